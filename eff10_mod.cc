@@ -41,6 +41,7 @@ int main (int argc,char** argv) {
     runManager->SetNumberOfThreads(G4Threading::G4GetNumberOfCores());
     
     G4bool bPrimaries = false;
+    G4bool bLean = false;
     
     // Set mandatory initialization classes
     if(argc>2){
@@ -66,11 +67,22 @@ int main (int argc,char** argv) {
             
             bPrimaries = true;
         }
+        // Release stage with only the ions and the products of the
+        // radioactive decay, the thermal transport and the biasing are
+        // attached to the GenericIon only
+        else if(strcmp(argv[2],"--lean")==0){
+            bLean = true;
+        }
     }
-    else{
-        PhysicsList* physlist = new PhysicsList();
+    if(!bPrimaries){
+        PhysicsList* physlist = new PhysicsList(bLean);
         G4GenericBiasingPhysics* biasingPhysics = new G4GenericBiasingPhysics();
-        biasingPhysics->PhysicsBiasAllCharged();
+        if(bLean){
+            biasingPhysics->PhysicsBias("GenericIon");
+        }
+        else{
+            biasingPhysics->PhysicsBiasAllCharged();
+        }
         physlist->RegisterPhysics(biasingPhysics);
         runManager->SetUserInitialization(physlist);
     }
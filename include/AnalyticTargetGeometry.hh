@@ -0,0 +1,134 @@
+//
+// ********************************************************************
+// * License and Disclaimer                                           *
+// *                                                                  *
+// * The  Geant4 software  is  copyright of the Copyright Holders  of *
+// * the Geant4 Collaboration.  It is provided  under  the terms  and *
+// * conditions of the Geant4 Software License,  included in the file *
+// * LICENSE and available at  http://cern.ch/geant4/license .  These *
+// * include a list of copyright holders.                             *
+// *                                                                  *
+// * Neither the authors of this software system, nor their employing *
+// * institutes,nor the agencies providing financial support for this *
+// * work  make  any representation or  warranty, express or implied, *
+// * regarding  this  software system or assume any liability for its *
+// * use.  Please see the license in the file  LICENSE  and URL above *
+// * for the full disclaimer and the limitation of liability.         *
+// *                                                                  *
+// * This  code  implementation is the result of  the  scientific and *
+// * technical work of the GEANT4 collaboration.                      *
+// * By using,  copying,  modifying or  distributing the software (or *
+// * any work based  on the software)  you  agree  to acknowledge its *
+// * use  in  resulting  scientific  publications,  and indicate your *
+// * acceptance of all terms of the Geant4 Software license.          *
+// ********************************************************************
+//
+//
+/// \file AnalyticTargetGeometry.hh
+/// \brief Definition of the AnalyticTargetGeometry class
+
+#ifndef AnalyticTargetGeometry_h
+#define AnalyticTargetGeometry_h 1
+
+#include "globals.hh"
+#include "G4ThreeVector.hh"
+
+#include <vector>
+
+class G4VPhysicalVolume;
+class G4VSolid;
+class G4AffineTransform;
+
+/// AnalyticTargetGeometry class
+///
+/// Copy of the volumes placed in the world as analytic shapes for the
+/// FreeMolecularFlowEngine: hollow tubes with planar cuts (G4Tubs and
+/// G4CutTubs with full phi), boxes, and subtractions of these. Volumes
+/// of the world material are transparent, apart from the detector which
+/// absorbs the ions. Intersect() returns, for a batch of rays in
+/// structure-of-arrays layout, the distance, the index and the outward
+/// normal of the first surface entered. The plain tubes, i.e. almost all
+/// the target, are processed lane by lane in a branch-free loop which
+/// the compiler can vectorize, the other solids with a generic search
+/// over the surface crossings.
+
+class AnalyticTargetGeometry
+{
+  public:
+    enum ShapeType {kTube, kBox};
+
+    // Shape in its own frame, local = fRotation * point + fTranslation
+    // with fRotation row-major
+    struct Shape {
+        G4int fType;
+        G4double fRotation[9];
+        G4double fTranslation[3];
+        // Tube: radii, half length and outward normals of the cuts
+        // through (0,0,-fDz) and (0,0,+fDz); box: half lengths
+        G4double fRmin;
+        G4double fRmax;
+        G4double fDz;
+        G4double fLowNorm[3];
+        G4double fHighNorm[3];
+        G4double fHalf[3];
+    };
+
+    struct Solid {
+        G4VPhysicalVolume* fVolume;
+        Shape fShape;
+        // Subtracted shapes, in the frame of fShape
+        std::vector<Shape> fHoles;
+        G4int fMaterialZ;
+        G4bool bDetector;
+    };
+
+  public:
+    AnalyticTargetGeometry();
+    ~AnalyticTargetGeometry();
+
+    // Import the volumes of the current world, false if a solid is not
+    // supported. With allVolumes also the volumes of the world material
+    // are kept, for the BallisticTransportation which stops at every
+    // boundary
+    G4bool Import(G4bool allVolumes = false);
+
+    size_t GetNumberOfSolids() const {return fSolids.size();}
+    const Solid& GetSolid(size_t i) const {return fSolids[i];}
+
+    // First surface entered by the rays (x,y,z) + t (u,v,w), hit is -1
+    // and distance DBL_MAX if none
+    void Intersect(size_t n,
+                   const G4double* x,const G4double* y,const G4double* z,
+                   const G4double* u,const G4double* v,const G4double* w,
+                   G4double* distance,G4int* hit,
+                   G4double* nx,G4double* ny,G4double* nz) const;
+
+  private:
+    static G4bool MakeShape(const G4VSolid*,const G4AffineTransform& toLocal,Shape&);
+    static void Transform(const Shape&,const G4double p[3],const G4double d[3],
+                          G4double lp[3],G4double ld[3]);
+    static G4bool Inside(const Shape&,const G4double p[3]);
+    // All the crossings of the ray with the surface of the shape, with
+    // the outward normals in the frame of the shape
+    static G4int Crossings(const Shape&,const G4double p[3],const G4double d[3],
+                           G4double t[],G4double n[][3]);
+
+    // Batched search for a plain tube
+    void IntersectTube(size_t index,size_t n,
+                       const G4double* x,const G4double* y,const G4double* z,
+                       const G4double* u,const G4double* v,const G4double* w,
+                       G4double* distance,G4int* hit,
+                       G4double* nx,G4double* ny,G4double* nz) const;
+    // Generic search for one ray, false if the solid is not entered
+    G4bool DistanceToIn(const Solid&,const G4double p[3],const G4double d[3],
+                        G4double& distance,G4double normal[3]) const;
+
+  private:
+    static const G4double fTolerance;
+
+    std::vector<Solid> fSolids;
+};
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+#endif
@@ -0,0 +1,128 @@
+//
+// ********************************************************************
+// * License and Disclaimer                                           *
+// *                                                                  *
+// * The  Geant4 software  is  copyright of the Copyright Holders  of *
+// * the Geant4 Collaboration.  It is provided  under  the terms  and *
+// * conditions of the Geant4 Software License,  included in the file *
+// * LICENSE and available at  http://cern.ch/geant4/license .  These *
+// * include a list of copyright holders.                             *
+// *                                                                  *
+// * Neither the authors of this software system, nor their employing *
+// * institutes,nor the agencies providing financial support for this *
+// * work  make  any representation or  warranty, express or implied, *
+// * regarding  this  software system or assume any liability for its *
+// * use.  Please see the license in the file  LICENSE  and URL above *
+// * for the full disclaimer and the limitation of liability.         *
+// *                                                                  *
+// * This  code  implementation is the result of  the  scientific and *
+// * technical work of the GEANT4 collaboration.                      *
+// * By using,  copying,  modifying or  distributing the software (or *
+// * any work based  on the software)  you  agree  to acknowledge its *
+// * use  in  resulting  scientific  publications,  and indicate your *
+// * acceptance of all terms of the Geant4 Software license.          *
+// ********************************************************************
+//
+//
+/// \file BallisticTransportation.hh
+/// \brief Definition of the BallisticTransportation class
+
+#ifndef BallisticTransportation_h
+#define BallisticTransportation_h 1
+
+#include "globals.hh"
+#include "G4Transportation.hh"
+#include "G4ParticleChangeForTransport.hh"
+#include "G4GenericMessenger.hh"
+#include "G4ThreeVector.hh"
+#include "AnalyticTargetGeometry.hh"
+#include "EffusionTrackData.hh"
+
+#include <unordered_map>
+
+class G4Navigator;
+class G4VPhysicalVolume;
+class G4ParticleDefinition;
+class G4SteppingManager;
+
+/// BallisticTransportation class
+///
+/// Transportation of the nuclei which replaces G4Transportation for the
+/// thermal ions (kinetic energy below fEnergyThreshold) flying in the
+/// world volume. The step is the distance to the first daughter of the
+/// world entered, from the AnalyticTargetGeometry, or to the world
+/// boundary: no navigator ComputeStep, no field propagation and no
+/// energy loss. The track is located in the new volume at the end of
+/// the step and the outward normal of the surface entered is stored in
+/// the EffusionTrackData for the EffusionProcess. All the other steps
+/// are delegated to G4Transportation, whose safety and touchable are
+/// reset after the ballistic steps. The mode is off by default
+/// (/ballistic/setActive) and the process is then G4Transportation.
+/// In both modes the process is the boundary trigger of the effusion: the
+/// EffusionProcess is not forced for the nuclei and the PostStepDoIt of
+/// the transportation forces it at the steps ending on a surface of
+/// another material, the interior steps do no effusion work.
+
+class BallisticTransportation : public G4Transportation
+{
+  public:
+    BallisticTransportation(G4int verbosityLevel = 0);
+    ~BallisticTransportation();
+
+    G4double AlongStepGetPhysicalInteractionLength(const G4Track& track,
+                                                   G4double previousStepSize,
+                                                   G4double currentMinimumStep,
+                                                   G4double& currentSafety,
+                                                   G4GPILSelection* selection);
+
+    G4VParticleChange* AlongStepDoIt(const G4Track& track,
+                                     const G4Step& stepData);
+
+    G4VParticleChange* PostStepDoIt(const G4Track& track,
+                                    const G4Step& stepData);
+
+    void StartTracking(G4Track* track);
+
+  private:
+    G4bool IsBallistic(const G4Track& track);
+    EffusionTrackData* GetTrackData(const G4Track& track);
+    G4ParticleChangeForTransport* Relocate(const G4Track& track);
+    
+    // Force the EffusionProcess of the particle for the current step
+    void TriggerEffusion(const G4Track& track,
+                         const G4Step& stepData,
+                         G4ParticleChangeForTransport* change);
+    G4int GetEffusionIndex(const G4ParticleDefinition* particle);
+
+  private:
+    AnalyticTargetGeometry fGeometry;
+    G4bool bImported;
+    G4bool bAvailable;
+    G4VPhysicalVolume* fWorld;
+    G4Navigator* fNavigator;
+    G4int fEffusionID;
+
+    // State of the current step
+    G4bool bBallisticStep;
+    G4bool bGeometryLimitedStep;
+    G4bool bSurfaceHit;
+    // The track has been moved without G4Transportation since its last step
+    G4bool bBallisticMoved;
+    G4ThreeVector fSurfaceNormal;
+    G4ParticleChangeForTransport fBallisticChange;
+
+    // Position of the EffusionProcess in the PostStepGPIL vector of each
+    // particle, -1 without it
+    G4SteppingManager* fSteppingManager;
+    std::unordered_map<const G4ParticleDefinition*,G4int> fEffusionIndex;
+    const G4ParticleDefinition* fLastDefinition;
+    G4int fLastEffusionIndex;
+
+    G4GenericMessenger* fMessenger;
+    G4bool bActive;
+    G4double fEnergyThreshold;
+};
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+#endif
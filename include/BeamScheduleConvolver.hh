@@ -0,0 +1,105 @@
+//
+// ********************************************************************
+// * License and Disclaimer                                           *
+// *                                                                  *
+// * The  Geant4 software  is  copyright of the Copyright Holders  of *
+// * the Geant4 Collaboration.  It is provided  under  the terms  and *
+// * conditions of the Geant4 Software License,  included in the file *
+// * LICENSE and available at  http://cern.ch/geant4/license .  These *
+// * include a list of copyright holders.                             *
+// *                                                                  *
+// * Neither the authors of this software system, nor their employing *
+// * institutes,nor the agencies providing financial support for this *
+// * work  make  any representation or  warranty, express or implied, *
+// * regarding  this  software system or assume any liability for its *
+// * use.  Please see the license in the file  LICENSE  and URL above *
+// * for the full disclaimer and the limitation of liability.         *
+// *                                                                  *
+// * This  code  implementation is the result of  the  scientific and *
+// * technical work of the GEANT4 collaboration.                      *
+// * By using,  copying,  modifying or  distributing the software (or *
+// * any work based  on the software)  you  agree  to acknowledge its *
+// * use  in  resulting  scientific  publications,  and indicate your *
+// * acceptance of all terms of the Geant4 Software license.          *
+// ********************************************************************
+//
+//
+/// \file BeamScheduleConvolver.hh
+/// \brief Definition of the BeamScheduleConvolver class
+
+#ifndef BeamScheduleConvolver_h
+#define BeamScheduleConvolver_h 1
+
+#include "globals.hh"
+#include "G4GenericMessenger.hh"
+
+#include <string>
+#include <vector>
+
+class Run;
+
+/// BeamScheduleConvolver class
+///
+/// Post-run stage computing the release rate at the telescope for beam
+/// time structures different from the single pulse at t = 0 of the
+/// simulation. The delay distribution of each isotope, i.e. the arrival
+/// time histogram per generated nucleus, is resampled on a uniform time
+/// grid, optionally weighted with the analytic decay and convolved with
+/// the production rate of every schedule. The rate is one nucleus per
+/// second while the beam is on, so the output is the release rate per
+/// unit production rate.
+
+class BeamScheduleConvolver
+{
+  public:
+    BeamScheduleConvolver();
+    ~BeamScheduleConvolver();
+
+    // Copy the tallies of a run, to be used by the next convolution
+    void SetRun(const Run*);
+    void LoadHistograms(std::string fileName);
+
+    // Write one file per schedule with the release rate of every isotope
+    void Convolve();
+    
+    G4bool HasSchedules() const {return !fSchedules.empty();}
+    
+    // Schedules are given as name;parameters with times in seconds
+    void AddConstant(std::string s);
+    void AddPulsed(std::string s);
+    void AddOnOff(std::string s);
+    void AddRamp(std::string s);
+    void ClearSchedules() {fSchedules.clear();}
+
+  private:
+    enum ScheduleType {kConstant, kPulsed, kRamp};
+    
+    struct Schedule {
+        G4String fName;
+        G4int fType;
+        G4double fPeriod;
+        G4double fWidth;
+    };
+    
+    G4bool AddSchedule(std::string s,G4int type,size_t nParameters);
+    
+    // Integral of the production rate from 0 to time
+    G4double GetBeamIntegral(const Schedule&,G4double time) const;
+    
+    // Probability per generated nucleus of arriving in each time step
+    std::vector<G4double> GetDelayDistribution(G4int code) const;
+
+  private:
+    Run* fRun;
+    std::vector<Schedule> fSchedules;
+
+    G4GenericMessenger* fMessenger;
+    G4double fTimeStep;
+    G4int fNumberOfSteps;
+    G4bool bApplyDecay;
+    G4String fOutputPrefix;
+};
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+#endif
@@ -0,0 +1,121 @@
+//
+// ********************************************************************
+// * License and Disclaimer                                           *
+// *                                                                  *
+// * The  Geant4 software  is  copyright of the Copyright Holders  of *
+// * the Geant4 Collaboration.  It is provided  under  the terms  and *
+// * conditions of the Geant4 Software License,  included in the file *
+// * LICENSE and available at  http://cern.ch/geant4/license .  These *
+// * include a list of copyright holders.                             *
+// *                                                                  *
+// * Neither the authors of this software system, nor their employing *
+// * institutes,nor the agencies providing financial support for this *
+// * work  make  any representation or  warranty, express or implied, *
+// * regarding  this  software system or assume any liability for its *
+// * use.  Please see the license in the file  LICENSE  and URL above *
+// * for the full disclaimer and the limitation of liability.         *
+// *                                                                  *
+// * This  code  implementation is the result of  the  scientific and *
+// * technical work of the GEANT4 collaboration.                      *
+// * By using,  copying,  modifying or  distributing the software (or *
+// * any work based  on the software)  you  agree  to acknowledge its *
+// * use  in  resulting  scientific  publications,  and indicate your *
+// * acceptance of all terms of the Geant4 Software license.          *
+// ********************************************************************
+//
+//
+/// \file CommonRandomNumbers.hh
+/// \brief Definition of the CommonRandomNumbers class
+
+#ifndef CommonRandomNumbers_h
+#define CommonRandomNumbers_h 1
+
+#include "globals.hh"
+#include "G4GenericMessenger.hh"
+
+#include <cstdint>
+#include <set>
+#include <vector>
+
+/// CommonRandomNumbers class
+///
+/// Paired runs of two configurations (temperature, adsorption times,
+/// layout) with common random numbers. When active, the engine is reseeded
+/// from a hash of fSeed, the pair index and the event ID before the source
+/// sampling, and at the start of every track from a stream of its own: the
+/// primary
+/// ions are keyed by their track ID, the secondaries by the key of their
+/// parent and their rank among its daughters. A change of the
+/// configuration then only moves the numbers of the tracks it touches,
+/// and the outcomes of the same ion in the two runs are correlated. The
+/// run ID is not in the keys, the two runs of a pair are consecutive
+/// beamOn with the same fPair, and the next pair of the job takes
+/// another one.
+///
+/// The outcome of every primary ion is written to fOutputFile, /crn/compare
+/// matches the ions of two files by pair, event and track ID and prints
+/// the paired differences of the
+/// release fraction and of the release time with their standard errors,
+/// next to the ones of independent runs.
+///
+/// One instance per thread, created by the RunAction so that the commands
+/// exist before the macros are run.
+
+class CommonRandomNumbers
+{
+  public:
+    enum Stream {
+        kSource = 1,
+        kTransport = 2
+    };
+
+    // Weight of a primary ion and time it reaches the telescope, -1 if
+    // it is not released
+    struct Outcome {
+        G4int fPair;
+        G4int fEvent;
+        G4int fIon;
+        G4double fWeight;
+        G4double fTime;
+    };
+
+  public:
+    static CommonRandomNumbers* Instance();
+
+    G4bool IsActive() const {return bActive;}
+    G4int GetPair() const {return fPair;}
+    const G4String& GetOutputFile() const {return fOutputFile;}
+    void SetOutputFile(std::string fileName) {fOutputFile = (fileName == "none") ? "" : fileName;}
+
+    // Key of a stream and of the stream of a daughter of a track
+    uint64_t GetKey(G4int event,G4int stream,G4int index) const;
+    static uint64_t GetDaughterKey(uint64_t parent,G4int daughter);
+    // Seeds of the engine from the key, the buffered variates are dropped
+    void Reseed(uint64_t key) const;
+
+    // Text file, started anew the first time it is written in this job
+    void WriteOutcomes(const std::vector<Outcome>& outcomes);
+    // fileA;fileB, the differences are B - A
+    void Compare(std::string files);
+
+  private:
+    CommonRandomNumbers();
+    ~CommonRandomNumbers();
+
+    static uint64_t Mix(uint64_t z);
+    G4bool ReadOutcomes(const G4String& fileName,std::vector<Outcome>& outcomes) const;
+
+  private:
+    static G4ThreadLocal CommonRandomNumbers* fInstance;
+
+    G4GenericMessenger* fMessenger;
+    G4bool bActive;
+    G4int fSeed;
+    G4int fPair;
+    G4String fOutputFile;
+    std::set<G4String> fWrittenFiles;
+};
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+#endif
@@ -0,0 +1,148 @@
+//
+// ********************************************************************
+// * License and Disclaimer                                           *
+// *                                                                  *
+// * The  Geant4 software  is  copyright of the Copyright Holders  of *
+// * the Geant4 Collaboration.  It is provided  under  the terms  and *
+// * conditions of the Geant4 Software License,  included in the file *
+// * LICENSE and available at  http://cern.ch/geant4/license .  These *
+// * include a list of copyright holders.                             *
+// *                                                                  *
+// * Neither the authors of this software system, nor their employing *
+// * institutes,nor the agencies providing financial support for this *
+// * work  make  any representation or  warranty, express or implied, *
+// * regarding  this  software system or assume any liability for its *
+// * use.  Please see the license in the file  LICENSE  and URL above *
+// * for the full disclaimer and the limitation of liability.         *
+// *                                                                  *
+// * This  code  implementation is the result of  the  scientific and *
+// * technical work of the GEANT4 collaboration.                      *
+// * By using,  copying,  modifying or  distributing the software (or *
+// * any work based  on the software)  you  agree  to acknowledge its *
+// * use  in  resulting  scientific  publications,  and indicate your *
+// * acceptance of all terms of the Geant4 Software license.          *
+// ********************************************************************
+//
+//
+/// \file CompartmentModel.hh
+/// \brief Definition of the CompartmentModel class
+
+#ifndef CompartmentModel_h
+#define CompartmentModel_h 1
+
+#include "globals.hh"
+#include "G4GenericMessenger.hh"
+
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+class G4VPhysicalVolume;
+class Run;
+
+/// CompartmentModel class
+///
+/// Reduced model of the target for fast screening. The target is split
+/// in compartments: the disks (index = copy number), the box cavity
+/// (all the other volumes), the transfer line and the detector. The
+/// SteppingAction of a full simulation fills, per element, the
+/// histograms of the time spent in a compartment before moving to the
+/// next one, separately for the compartment where the nucleus has been
+/// produced. The model samples the transitions from these kernels as a
+/// semi-Markov chain and applies the radioactive decay, so that the
+/// kernels should be calibrated with a long-lived isotope of each
+/// element. The daughters of the decay chains added with addDecay start
+/// in the compartment of the decay with the kernels of their element.
+/// The tallies are stored in a Run and written as the isotope table and
+/// the release histograms of the full simulation.
+
+class CompartmentModel
+{
+  public:
+    enum Compartment {
+        kBox = 90,
+        kTransfer,
+        kDetector,
+        kOutside,
+        kLost
+    };
+
+  public:
+    CompartmentModel();
+    ~CompartmentModel();
+
+    // Compartment of a volume of the target, kOutside for no volume
+    static G4int GetCompartment(const G4VPhysicalVolume*);
+
+    // Calibration switch, the workers register the SteppingAction only
+    // when it is on at their start (first beamOn)
+    static G4bool IsCalibrating() {return bCalibrate;}
+
+    // Copy the kernels of a Geant4 run
+    void SetRun(const Run*);
+
+    // Kernels in the checkpoint format of the Run
+    void SaveCalibration(std::string fileName);
+    void LoadCalibration(std::string fileName);
+
+    // parentZ;parentA;daughterZ;daughterA;branching ratio
+    void AddDecay(std::string s);
+    // Z;A;number of ions;disk, with disk -1 for the production of the
+    // calibration run
+    void Simulate(std::string s);
+
+  private:
+    struct Kernel {
+        std::vector<G4int> fTo;
+        // Cumulative probability of the destinations and, per
+        // destination, cumulative distribution over the time bins
+        std::vector<G4double> fProbability;
+        std::vector<std::vector<G4double> > fCumulative;
+    };
+
+    struct Branch {
+        G4int fZ;
+        G4int fA;
+        G4double fProbability;
+    };
+
+    struct Ion {
+        G4int fZ;
+        G4int fA;
+        G4int fCompartment;
+        G4int fOriginDisk;
+        G4bool bFirst;
+        G4double fTime;
+    };
+
+  private:
+    void Prepare();
+    const Kernel* FindKernel(G4int Z,G4bool first,G4int compartment) const;
+    G4double SampleTime(const std::vector<G4double>& cumulative) const;
+    G4double GetLifeTime(G4int Z,G4int A);
+    // Follow the ion until its end, the daughters are added to the stack
+    void Transport(const Ion& ion,std::vector<Ion>& stack);
+
+  private:
+    static G4bool bCalibrate;
+
+    // Calibration run and kernels built from it
+    Run* fRun;
+    G4bool bPrepared;
+    std::unordered_map<G4int,Kernel> fKernels;
+    
+    // Decay branches and lifetimes per isotope, key A*1000+Z
+    std::unordered_map<G4int,std::vector<Branch> > fDecays;
+    std::unordered_map<G4int,G4double> fLifeTimes;
+
+    // Tallies of the last simulation
+    Run* fResult;
+    G4long fTransitions;
+
+    G4GenericMessenger* fMessenger;
+    G4String fOutputPrefix;
+};
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+#endif
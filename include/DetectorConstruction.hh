@@ -134,6 +134,24 @@ public:
     G4double GetTargetDiskThickness(G4int aInt) {return fTargetDiskThickness[aInt];}
     
 
+    // Fast simulation of the transfer line with the kernel read from
+    // fTransferKernelFile, see TransferLineModel
+private:
+    G4bool bTransferFastSim;
+public:
+    void SetTransferFastSim(G4bool aBool) {bTransferFastSim=aBool;}
+    G4bool GetTransferFastSim() {return bTransferFastSim;}
+
+private:
+    G4String fTransferKernelFile;
+public:
+    void SetTransferKernelFile(G4String aString) {fTransferKernelFile=aString;}
+    G4String GetTransferKernelFile() {return fTransferKernelFile;}
+
+    // Trace the kernel histories in the current geometry and write them
+    // to fTransferKernelFile
+    void BuildTransferKernel(G4int histories);
+
 
 
 
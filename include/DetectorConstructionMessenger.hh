@@ -42,6 +42,7 @@ class G4UIcmdWith3Vector;
 class G4UIcmdWithABool;
 class G4UIcmdWithAString;
 class G4UIcmdWithADouble;
+class G4UIcmdWithAnInteger;
 
 #include "G4UImessenger.hh"
 #include "globals.hh"
@@ -73,6 +74,10 @@ private:
 
     G4UIcmdWithADoubleAndUnit* fTargetDiskPositionCmd[MAX_DISK_NUMBER];
     G4UIcmdWithADoubleAndUnit* fTargetDiskThicknessCmd[MAX_DISK_NUMBER];
+
+    G4UIcmdWithABool* fTransferFastSimCmd;
+    G4UIcmdWithAString* fTransferKernelCmd;
+    G4UIcmdWithAnInteger* fBuildTransferKernelCmd;
 };
 
 #endif
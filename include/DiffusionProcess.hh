@@ -56,6 +56,11 @@ public:
     
     G4VParticleChange* PostStepDoIt(const G4Track& aTrack,
                                     const G4Step&  aStep);
+    
+    // The track data is fetched once at the start of the track
+    void StartTracking(G4Track* aTrack);
+    void EndTracking();
+    
 public:
     void SetDiffusionCoefficient(G4int partZ,
                                  std::string matName,
@@ -138,6 +143,7 @@ private:
     
 private:
     G4int fEffusionID;
+    EffusionTrackData* fTrackData;
     EffusionTrackData* GetTrackData(const G4Track&);
     
 private:
@@ -50,7 +50,7 @@
 #include "G4VBiasingOperator.hh"
 class G4BOptnChangeCrossSection;
 class G4ParticleDefinition;
-#include <map>
+#include <vector>
 
 class EffusionOptrChangeCrossSection : public G4VBiasingOperator {
 public:
@@ -95,9 +95,11 @@ private:
                                  const G4VParticleChange*                particleChangeProduced );
   
 private:
-  // -- List of associations between processes and biasing operations:
-  std::map< const G4BiasingProcessInterface*, 
-            G4BOptnChangeCrossSection*       > fChangeCrossSectionOperations;
+  // -- Biasing operations in the order of the wrapped processes in the shared data,
+  // -- a linear scan of the few processes is cheaper than a map lookup at each step:
+  std::vector< const G4BiasingProcessInterface* > fProcesses;
+  std::vector< G4BOptnChangeCrossSection*       > fChangeCrossSectionOperations;
+  G4BOptnChangeCrossSection* GetOperation(const G4BiasingProcessInterface* callingProcess) const;
   G4bool                                  fSetup;
   const G4ParticleDefinition*    fParticleToBias;
   G4int fEffusionID;
@@ -49,7 +49,7 @@
 class EffusionOptrChangeCrossSection;
 class G4ParticleDefinition;
 
-#include <map>
+#include <vector>
 
 class EffusionOptrMultiParticleChangeCrossSection : public G4VBiasingOperator {
 public:
@@ -102,11 +102,14 @@ public:
   void StartTracking( const G4Track* track );
   
 private:
-  // -- List of associations between particle types and biasing operators:
-  std::map < const G4ParticleDefinition*, 
-             EffusionOptrChangeCrossSection* >    fBOptrForParticle;
+  // -- Biasing operators in the order of the particle types to bias, the general ions
+  // -- share the operator of the GenericIon:
   std::vector < const G4ParticleDefinition* >   fParticlesToBias;
+  std::vector < EffusionOptrChangeCrossSection* > fBOptrForParticle;
   EffusionOptrChangeCrossSection*                  fCurrentOperator;
+  // -- Operator of the previous track, consecutive tracks are mostly of the same type:
+  const G4ParticleDefinition*                    fLastDefinition;
+  EffusionOptrChangeCrossSection*                  fLastOperator;
 
   // -- count number of biased interations for current track:
   G4int fnInteractions;
@@ -12,12 +12,17 @@
 class EffusionPhysicsList: public G4VPhysicsConstructor
 {
   public:
-    EffusionPhysicsList(G4int verbose =1);
+    // In the lean mode only the ions and the products of the radioactive
+    // decay are built, and the processes are attached to the GenericIon only
+    EffusionPhysicsList(G4int verbose =1, G4bool lean = false);
     ~EffusionPhysicsList();
 
   protected:
     void ConstructParticle();
     void ConstructProcess();
+
+  private:
+    G4bool bLean;
 };
 
 #endif
@@ -37,7 +37,10 @@
 #include "G4VDiscreteProcess.hh"
 
 #include "EffusionTrackData.hh"
-#include "G4GenericMessenger.hh"
+#include "SurfaceModel.hh"
+#include "SurfaceNormalProvider.hh"
+#include "G4SystemOfUnits.hh"
+#include "G4GenericMessenger.hh"
 
 #include <unordered_map>
 #include <string>
@@ -48,13 +51,30 @@ public:
     EffusionProcess(const G4String& processName = "effusion");
     ~EffusionProcess();
     
+    // Tracks still in the target after 100 hours are killed, the same
+    // limit ends the histories of the surrogate models
+    static const G4double fTimeLimit;
+    
+    // Not forced for the particles with the boundary trigger of the
+    // BallisticTransportation, which forces it at the steps ending on a
+    // surface of another material, forced for the other ones and after
+    // the time limit
     G4double GetMeanFreePath(const G4Track& ,
                              G4double ,
                              G4ForceCondition* condition);
     
+    // Surface interaction of the DefaultSurfaceModel, the other models
+    // are in SurfaceEffusionProcess
     G4VParticleChange* PostStepDoIt(const G4Track& aTrack,
                                     const G4Step&  aStep);
     
+    // The track data is fetched once at the start of the track
+    void StartTracking(G4Track* aTrack);
+    void EndTracking();
+    
+    // Temperatures of the materials for the thermal re-emission energy
+    void BuildPhysicsTable(const G4ParticleDefinition&);
+    
 public:
     void SampleMaxwellBoltzmannKineticEnergy(const G4Track&);
     void SampleLambertianDirection(const G4Track& aTrack);
@@ -94,9 +114,30 @@ public:
         if(tokens.size() < 3){return;}
         SetAdsorptionTime(std::stoi(tokens[0]),std::stoi(tokens[1]),std::stof(tokens[2]));
     }
+    
+    // Adsorption time of the element partZ on the material matZ, zero if
+    // not defined, used by the EffusionTransitionSolver
+    G4double GetAdsorptionTime(G4int partZ,
+                               G4int matZ){
+        std::unordered_map<int, double>::iterator it =
+        theAdsorptionTimeMap.find(GetIndex(partZ,matZ));
+        
+        if (it != theAdsorptionTimeMap.end()){
+            return it->second;
+        }
+        return 0.;
+    }
+    
+    // Effusion process registered to the particle, also when wrapped by
+    // the biasing, zero if not found
+    static EffusionProcess* GetEffusionProcess(const G4ParticleDefinition*);
     
 private:
     G4GenericMessenger*  fAdsorptionTimeMessenger;
+    
+    // Re-emission with the thermal energy of the surface instead of the
+    // energy of the incoming ion
+    G4bool bThermalEnergy;
     
     G4double kCarTolerance;
     
@@ -113,16 +154,28 @@ private:
     G4ThreeVector theGlobalNormal;
     G4ThreeVector theGlobalPoint;
     G4bool validLocalNorm;
+    SurfaceNormalProvider fNormalProvider;
         
 private:
     G4int fEffusionID;
+    EffusionTrackData* fTrackData;
     EffusionTrackData* GetTrackData(const G4Track&);
 
 private:
-    G4double GetDiffusionProbability(const G4Track&);
-    G4double GetAdsorptionProbability(const G4Track&);
     G4double GetAdsorptionTime(const G4Track&);
-    G4double GetFullAdsorptionProbability(const G4Track&);
+    
+private:
+    // Particles transported by the BallisticTransportation, which forces
+    // the effusion at the steps ending on a surface of another material
+    std::unordered_map<const G4ParticleDefinition*, G4bool> fTriggered;
+    const G4ParticleDefinition* fLastDefinition;
+    G4bool bLastTriggered;
+    G4bool IsTriggered(const G4ParticleDefinition*);
+    
+protected:
+    template<class Model>
+    G4VParticleChange* SurfaceInteraction(const G4Track& aTrack,
+                                          const G4Step&  aStep);
     
 private:
     std::unordered_map<int, double> theAdsorptionTimeMap;
@@ -130,4 +183,104 @@ private:
     int GetIndex(int partZ, int matA) {return partZ*1000 + matA;};
 };
 
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+template<class Model>
+G4VParticleChange* EffusionProcess::SurfaceInteraction(const G4Track& aTrack,
+                                                       const G4Step&  aStep)
+{
+    aParticleChange.Initialize(aTrack);
+
+    if(aTrack.GetGlobalTime() > fTimeLimit) {
+        G4Exception("EffusionProcess::PostStepDoIt",
+                    "eff0001",
+                    JustWarning,
+                    "Particle killed after 100 hours.");
+        
+        aParticleChange.ProposeEnergy(0.);
+        aParticleChange.ProposeTrackStatus(fStopAndKill);
+        return &aParticleChange;
+    }
+    
+    // Check Boundaries
+    G4StepPoint* pPreStepPoint  = aStep.GetPreStepPoint();
+    G4StepPoint* pPostStepPoint = aStep.GetPostStepPoint();
+    
+    if(pPostStepPoint->GetStepStatus() != fGeomBoundary){
+        return &aParticleChange;
+    }
+
+    // Check StepLength
+    if(aTrack.GetStepLength()<=kCarTolerance/2){
+        return &aParticleChange;
+    }
+
+    // Check Materials of next and previous volumes, if same do nothing.
+    G4Material* aMaterialPre  = pPreStepPoint ->GetPhysicalVolume()->GetLogicalVolume()->GetMaterial();
+    G4Material* aMaterialPost = pPostStepPoint->GetPhysicalVolume()->GetLogicalVolume()->GetMaterial();
+    
+    if(aMaterialPre == aMaterialPost){
+        return &aParticleChange;
+    }
+
+    ///////////////////////////////////////////////////////////////////////////////////
+    if(pPostStepPoint->GetPhysicalVolume()->GetMotherLogical() == 0){
+        return &aParticleChange;
+    }
+    
+    // If the particle is diffused into the material, it continues its motion
+    if(SurfaceTest<typename Model::Diffusion>(aTrack)){
+        return &aParticleChange;
+    }
+    
+    // If the particle is adsorbed, the sticking time is summed to the
+    // particle global time, i.e., the particle re-start to travel after a time
+    // equal to the sticking time
+    if(SurfaceTest<typename Model::Adsorption>(aTrack)){
+        
+        G4double adsorptionTime = Model::StickingTime::Sample(GetAdsorptionTime(aTrack));
+        aParticleChange.ProposeGlobalTime(aTrack.GetGlobalTime() + adsorptionTime ) ;
+        GetTrackData(aTrack)->SetTimeSticked(adsorptionTime);
+
+        // If the particle is adsorbed and not released, it is killed
+        if(SurfaceTest<typename Model::FullAdsorption>(aTrack)){
+            aParticleChange.ProposeEnergy(0.);
+            aParticleChange.ProposeTrackStatus(fStopAndKill);
+            return &aParticleChange;
+        }
+        
+        // Kinetic energy of the particle leaving the surface
+        if(!Model::Energy::kUnchanged){
+            aParticleChange.ProposeEnergy(Model::Energy::Sample(aTrack));
+        }
+    }
+
+    // Compute the outgoing particle direction around the normal
+    // theGlobalNormal is computed by the SampleLambertianDirection() function
+    SampleLambertianDirection(aTrack);
+    aParticleChange.ProposeMomentumDirection(Model::Emission::Sample(theGlobalNormal));
+    
+    return &aParticleChange;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+/// Effusion process with the surface model given at compile time, see
+/// SurfaceModel.hh. It replaces the EffusionProcess in the physics list
+/// and is found by EffusionProcess::GetEffusionProcess() as well.
+
+template<class Model>
+class SurfaceEffusionProcess : public EffusionProcess{
+    
+public:
+    SurfaceEffusionProcess(const G4String& processName = "effusion")
+    : EffusionProcess(processName){;}
+    ~SurfaceEffusionProcess(){;}
+    
+    G4VParticleChange* PostStepDoIt(const G4Track& aTrack,
+                                    const G4Step&  aStep){
+        return SurfaceInteraction<Model>(aTrack,aStep);
+    }
+};
+
 #endif /* EffusionProcess_h */
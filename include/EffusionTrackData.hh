@@ -44,6 +44,8 @@
 
 class EffusionProcess;
 #include "G4VAuxiliaryTrackInformation.hh"
+#include "G4ThreeVector.hh"
+#include "G4Allocator.hh"
 
 class EffusionTrackData : public G4VAuxiliaryTrackInformation {
     friend class EffusionProcess;
@@ -52,6 +54,11 @@ public:
     EffusionTrackData();
     ~EffusionTrackData();
     
+    // Served by a per-thread pool, the data is given back to the pool when
+    // the G4Track deletes its auxiliary information
+    inline void *operator new(size_t);
+    inline void operator delete(void *aData);
+    
     void Print() const;
     
 private:
@@ -69,13 +76,54 @@ public:
     void SetTotalTimeSticked(G4double aDouble) {fTotalTimeSticked = aDouble;};
     G4double GetTotalTimeSticked() {return fTotalTimeSticked;};
     
+    // Outward normal of the surface entered in the last step, cached by
+    // the BallisticTransportation for the EffusionProcess
+    void SetSurfaceNormal(const G4ThreeVector& aVector) {
+        fSurfaceNormal = aVector;
+        bSurfaceNormal = true;
+    };
+    void ClearSurfaceNormal() {bSurfaceNormal = false;};
+    G4bool HasSurfaceNormal() {return bSurfaceNormal;};
+    const G4ThreeVector& GetSurfaceNormal() {return fSurfaceNormal;};
+    
 private:
     // ----------
     // Sticking Time
     // ----------
     G4double fTimeSticked;
     G4double fTotalTimeSticked;
+    
+    // ----------
+    // Surface Normal
+    // ----------
+    G4ThreeVector fSurfaceNormal;
+    G4bool bSurfaceNormal;
 
 };
 
+#ifdef G4MULTITHREADED
+extern G4ThreadLocal G4Allocator<EffusionTrackData>* EffusionTrackDataAllocator;
+#else
+extern G4Allocator<EffusionTrackData> EffusionTrackDataAllocator;
+#endif
+
+inline void* EffusionTrackData::operator new(size_t)
+{
+#ifdef G4MULTITHREADED
+    if(!EffusionTrackDataAllocator) EffusionTrackDataAllocator = new G4Allocator<EffusionTrackData>;
+    return (void *) EffusionTrackDataAllocator->MallocSingle();
+#else
+    return (void *) EffusionTrackDataAllocator.MallocSingle();
+#endif
+}
+
+inline void EffusionTrackData::operator delete(void* aData)
+{
+#ifdef G4MULTITHREADED
+    EffusionTrackDataAllocator->FreeSingle((EffusionTrackData*) aData);
+#else
+    EffusionTrackDataAllocator.FreeSingle((EffusionTrackData*) aData);
+#endif
+}
+
 #endif
@@ -0,0 +1,137 @@
+//
+// ********************************************************************
+// * License and Disclaimer                                           *
+// *                                                                  *
+// * The  Geant4 software  is  copyright of the Copyright Holders  of *
+// * the Geant4 Collaboration.  It is provided  under  the terms  and *
+// * conditions of the Geant4 Software License,  included in the file *
+// * LICENSE and available at  http://cern.ch/geant4/license .  These *
+// * include a list of copyright holders.                             *
+// *                                                                  *
+// * Neither the authors of this software system, nor their employing *
+// * institutes,nor the agencies providing financial support for this *
+// * work  make  any representation or  warranty, express or implied, *
+// * regarding  this  software system or assume any liability for its *
+// * use.  Please see the license in the file  LICENSE  and URL above *
+// * for the full disclaimer and the limitation of liability.         *
+// *                                                                  *
+// * This  code  implementation is the result of  the  scientific and *
+// * technical work of the GEANT4 collaboration.                      *
+// * By using,  copying,  modifying or  distributing the software (or *
+// * any work based  on the software)  you  agree  to acknowledge its *
+// * use  in  resulting  scientific  publications,  and indicate your *
+// * acceptance of all terms of the Geant4 Software license.          *
+// ********************************************************************
+//
+//
+/// \file EffusionTransitionSolver.hh
+/// \brief Definition of the EffusionTransitionSolver class
+
+#ifndef EffusionTransitionSolver_h
+#define EffusionTransitionSolver_h 1
+
+#include "globals.hh"
+#include "G4ThreeVector.hh"
+#include "G4GenericMessenger.hh"
+
+#include <map>
+#include <string>
+#include <vector>
+
+class G4VPhysicalVolume;
+class G4Navigator;
+
+/// EffusionTransitionSolver class
+///
+/// Effusion as an absorbing Markov chain over surface patches. A patch
+/// is a slice along the local z axis of the surface of a volume placed
+/// in the world. Lambertian rays are traced once per geometry from every
+/// patch, and isotropic rays from the inside of every disk, to estimate
+/// the probability of the next patch hit, of entering the detector and
+/// of leaving the world, with the first two moments of the flight length.
+/// For a given ion the linear systems (I - Q) x = b of the chain give
+/// the release probability, the mean and the variance of the delay and
+/// the release probability with the decay, per disk of origin, for any
+/// set of adsorption times without new rays.
+///
+/// The re-emission point is sampled uniformly on the patch, so that the
+/// result converges to the Monte Carlo one as the patches get smaller.
+
+class EffusionTransitionSolver
+{
+  public:
+    EffusionTransitionSolver();
+    ~EffusionTransitionSolver();
+
+    // Trace the rays and fill the transition tallies
+    void BuildTransitions();
+    
+    // Solve the chain for the ion Z;A with the adsorption times of the
+    // effusion process
+    void Solve(std::string s);
+    
+    // Solve the chain for the ion Z;A with the adsorption time on the
+    // material matZ scanned logarithmically: Z;A;matZ;min_ns;max_ns;n
+    void ScanAdsorptionTime(std::string s);
+
+  private:
+    struct Patch {
+        G4VPhysicalVolume* fVolume;
+        G4int fSegment;
+        G4int fMaterialZ;
+    };
+    
+    struct Solution {
+        G4double fRelease;
+        G4double fMeanDelay;
+        G4double fSigmaDelay;
+        G4double fReleaseWithDecay;
+    };
+    
+    // Outcome of a ray: index of the patch hit, or one of these
+    enum RayOutcome {kDetector = -1, kEscaped = -2};
+
+    void BuildPatches();
+    G4int FindPatch(G4VPhysicalVolume*,const G4ThreeVector& globalPoint) const;
+    G4int TraceRay(G4ThreeVector point,const G4ThreeVector& direction,G4double& length);
+    void Tally(size_t row,G4int outcome,G4double length);
+    
+    // Solution per source (disk) for the given adsorption time per patch
+    std::vector<Solution> SolveChain(G4int Z,G4int A,
+                                     const std::vector<G4double>& adsorptionTime) const;
+    void PrintSolutions(G4int Z,G4int A,const std::vector<Solution>&) const;
+    
+    // Dense LU factorization with partial pivoting of the n x n row-major
+    // matrix and solution of k right-hand sides stored as n x k row-major
+    static G4bool Factorize(std::vector<G4double>& a,std::vector<size_t>& pivot,size_t n);
+    static void Substitute(const std::vector<G4double>& lu,const std::vector<size_t>& pivot,
+                           size_t n,std::vector<G4double>& b,size_t k);
+
+  private:
+    G4Navigator* fNavigator;
+    G4VPhysicalVolume* fDetector;
+
+    std::vector<Patch> fPatches;
+    // First patch and local z extent of each volume
+    std::map<const G4VPhysicalVolume*,G4int> fFirstPatch;
+    std::map<const G4VPhysicalVolume*,std::pair<G4double,G4double> > fExtent;
+    // Source volumes (disks) and their copy numbers
+    std::vector<G4VPhysicalVolume*> fSources;
+
+    // Tallies: one row per patch followed by one per source, one column
+    // per patch followed by detector and escape
+    size_t fColumns;
+    std::vector<G4double> fEmitted;
+    std::vector<G4double> fCounts;
+    std::vector<G4double> fSumLength;
+    std::vector<G4double> fSumLength2;
+
+    G4GenericMessenger* fMessenger;
+    G4int fSegments;
+    G4int fRaysPerPatch;
+    G4double fKineticEnergy;
+};
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+#endif
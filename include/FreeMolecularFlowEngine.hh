@@ -0,0 +1,123 @@
+//
+// ********************************************************************
+// * License and Disclaimer                                           *
+// *                                                                  *
+// * The  Geant4 software  is  copyright of the Copyright Holders  of *
+// * the Geant4 Collaboration.  It is provided  under  the terms  and *
+// * conditions of the Geant4 Software License,  included in the file *
+// * LICENSE and available at  http://cern.ch/geant4/license .  These *
+// * include a list of copyright holders.                             *
+// *                                                                  *
+// * Neither the authors of this software system, nor their employing *
+// * institutes,nor the agencies providing financial support for this *
+// * work  make  any representation or  warranty, express or implied, *
+// * regarding  this  software system or assume any liability for its *
+// * use.  Please see the license in the file  LICENSE  and URL above *
+// * for the full disclaimer and the limitation of liability.         *
+// *                                                                  *
+// * This  code  implementation is the result of  the  scientific and *
+// * technical work of the GEANT4 collaboration.                      *
+// * By using,  copying,  modifying or  distributing the software (or *
+// * any work based  on the software)  you  agree  to acknowledge its *
+// * use  in  resulting  scientific  publications,  and indicate your *
+// * acceptance of all terms of the Geant4 Software license.          *
+// ********************************************************************
+//
+//
+/// \file FreeMolecularFlowEngine.hh
+/// \brief Definition of the FreeMolecularFlowEngine class
+
+#ifndef FreeMolecularFlowEngine_h
+#define FreeMolecularFlowEngine_h 1
+
+#include "globals.hh"
+#include "G4GenericMessenger.hh"
+#include "AnalyticTargetGeometry.hh"
+
+#include <string>
+#include <vector>
+
+class G4VPhysicalVolume;
+class Run;
+
+/// FreeMolecularFlowEngine class
+///
+/// Standalone transport of the thermal ions in the target without the
+/// Geant4 stepping. The nuclei are generated uniformly in the disks with
+/// isotropic direction and fly straight out of the disk, as in a run
+/// without diffusion. Then they bounce on the solids of the
+/// AnalyticTargetGeometry with the rules of EffusionProcess: Lambertian
+/// re-emission around the surface normal after the adsorption time of
+/// the element on the first element of the material, end of the history
+/// when entering the detector, leaving the world, decaying or after 100
+/// hours. A batch of ions is kept in structure-of-arrays layout and the
+/// finished lanes are refilled with new ions. The tallies are stored in
+/// a Run, as the ones of the Geant4 simulation.
+///
+/// Validation compares the release fraction, mean and median arrival
+/// time with the ones of the last Geant4 run, which should be simulated
+/// with the same source and without diffusion (bDONT_USE_DIFFUSION).
+
+class FreeMolecularFlowEngine
+{
+  public:
+    FreeMolecularFlowEngine();
+    ~FreeMolecularFlowEngine();
+
+    // Copy the tallies of a Geant4 run for the validation
+    void SetRun(const Run*);
+
+    // Z;A;number of ions;disk, with disk -1 for all the disks
+    void Simulate(std::string s);
+    void Validate(std::string s);
+
+  private:
+    // Transport of nIons ions, false if the geometry or the ion is not
+    // supported
+    G4bool Transport(G4int Z,G4int A,G4long nIons,G4int disk);
+    // Start a new ion in the lane, inside the source volume
+    void Generate(size_t lane,G4int Z,G4int A,G4int disk);
+    // Remove the lane, replacing it with the last one
+    void Release(size_t lane);
+
+  private:
+    // Distance of the re-emitted ions from the surface, the tracks end
+    // at EffusionProcess::fTimeLimit as in the full simulation
+    static const G4double fSurfaceOffset;
+
+    AnalyticTargetGeometry fGeometry;
+    G4bool bImported;
+    // Disks and their volumes, for the sampling of the sources
+    std::vector<G4VPhysicalVolume*> fSources;
+    std::vector<G4double> fSourceVolume;
+
+    // Properties of the ions of the current simulation
+    G4double fVelocity;
+    G4double fLifeTime;
+    std::vector<G4double> fAdsorptionTime;
+
+    // Ions of the batch
+    size_t fLanes;
+    std::vector<G4int> fCode;
+    std::vector<G4double> fX, fY, fZ;
+    std::vector<G4double> fU, fV, fW;
+    std::vector<G4double> fTime;
+    std::vector<G4double> fDecayTime;
+    // Intersections of the batch
+    std::vector<G4double> fDistance;
+    std::vector<G4int> fHit;
+    std::vector<G4double> fNx, fNy, fNz;
+
+    // Tallies of the last simulation and of the Geant4 run
+    Run* fResult;
+    G4double fBounces;
+    Run* fRun;
+
+    G4GenericMessenger* fMessenger;
+    G4int fBatchSize;
+    G4double fKineticEnergy;
+};
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+#endif
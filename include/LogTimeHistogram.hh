@@ -0,0 +1,87 @@
+//
+// ********************************************************************
+// * License and Disclaimer                                           *
+// *                                                                  *
+// * The  Geant4 software  is  copyright of the Copyright Holders  of *
+// * the Geant4 Collaboration.  It is provided  under  the terms  and *
+// * conditions of the Geant4 Software License,  included in the file *
+// * LICENSE and available at  http://cern.ch/geant4/license .  These *
+// * include a list of copyright holders.                             *
+// *                                                                  *
+// * Neither the authors of this software system, nor their employing *
+// * institutes,nor the agencies providing financial support for this *
+// * work  make  any representation or  warranty, express or implied, *
+// * regarding  this  software system or assume any liability for its *
+// * use.  Please see the license in the file  LICENSE  and URL above *
+// * for the full disclaimer and the limitation of liability.         *
+// *                                                                  *
+// * This  code  implementation is the result of  the  scientific and *
+// * technical work of the GEANT4 collaboration.                      *
+// * By using,  copying,  modifying or  distributing the software (or *
+// * any work based  on the software)  you  agree  to acknowledge its *
+// * use  in  resulting  scientific  publications,  and indicate your *
+// * acceptance of all terms of the Geant4 Software license.          *
+// ********************************************************************
+//
+//
+/// \file LogTimeHistogram.hh
+/// \brief Definition of the LogTimeHistogram class
+
+#ifndef LogTimeHistogram_h
+#define LogTimeHistogram_h 1
+
+#include "globals.hh"
+#include <iostream>
+#include <vector>
+
+/// LogTimeHistogram class
+///
+/// Fixed-memory histogram of times with logarithmic bins from 1 ns to
+/// 1e7 s, twenty bins per decade, plus underflow (first bin) and
+/// overflow (last bin). All the histograms share the same binning, so
+/// that they can be merged bin by bin
+
+class LogTimeHistogram
+{
+  public:
+    LogTimeHistogram();
+    ~LogTimeHistogram();
+
+    void Fill(G4double time, G4double weight = 1.);
+    void Merge(const LogTimeHistogram&);
+
+    G4long GetEntries() const {return fEntries;}
+    G4double GetSumOfWeights() const;
+    const std::vector<G4double>& GetContents() const {return fContents;}
+
+    // Time below which a fraction q of the weight lies, interpolated
+    // logarithmically inside the bin
+    G4double GetQuantile(G4double q) const;
+    // Weight below the given time, with the same interpolation
+    G4double GetIntegral(G4double time) const;
+    
+    static G4int GetNumberOfBins() {return fBinsPerDecade * fDecades;}
+    static G4int GetBinsPerDecade() {return fBinsPerDecade;}
+    static G4double GetMinTime();
+    static G4double GetMaxTime();
+    static G4double GetBinLowEdge(G4int bin);
+    static G4int FindBin(G4double time);
+
+    // Text (checkpoints) and binary (output file) serialization, only the
+    // non-empty bins are written
+    void Write(std::ostream&) const;
+    G4bool Read(std::istream&);
+    void WriteBinary(std::ostream&) const;
+    G4bool ReadBinary(std::istream&);
+
+  private:
+    static const G4int fBinsPerDecade = 20;
+    static const G4int fDecades = 16;
+    
+    G4long fEntries;
+    std::vector<G4double> fContents;
+};
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+#endif
@@ -0,0 +1,79 @@
+//
+// ********************************************************************
+// * License and Disclaimer                                           *
+// *                                                                  *
+// * The  Geant4 software  is  copyright of the Copyright Holders  of *
+// * the Geant4 Collaboration.  It is provided  under  the terms  and *
+// * conditions of the Geant4 Software License,  included in the file *
+// * LICENSE and available at  http://cern.ch/geant4/license .  These *
+// * include a list of copyright holders.                             *
+// *                                                                  *
+// * Neither the authors of this software system, nor their employing *
+// * institutes,nor the agencies providing financial support for this *
+// * work  make  any representation or  warranty, express or implied, *
+// * regarding  this  software system or assume any liability for its *
+// * use.  Please see the license in the file  LICENSE  and URL above *
+// * for the full disclaimer and the limitation of liability.         *
+// *                                                                  *
+// * This  code  implementation is the result of  the  scientific and *
+// * technical work of the GEANT4 collaboration.                      *
+// * By using,  copying,  modifying or  distributing the software (or *
+// * any work based  on the software)  you  agree  to acknowledge its *
+// * use  in  resulting  scientific  publications,  and indicate your *
+// * acceptance of all terms of the Geant4 Software license.          *
+// ********************************************************************
+//
+//
+/// \file MomentAccumulator.hh
+/// \brief Definition of the MomentAccumulator class
+
+#ifndef MomentAccumulator_h
+#define MomentAccumulator_h 1
+
+#include "globals.hh"
+#include <iostream>
+
+/// MomentAccumulator class
+///
+/// Online weighted accumulator of the central moments up to the fourth
+/// (Welford update, Pebay formulas for the merge of two accumulators),
+/// stable for samples spanning many orders of magnitude and for the
+/// merge of the thread-local runs
+
+class MomentAccumulator
+{
+  public:
+    MomentAccumulator();
+    ~MomentAccumulator();
+
+    void Fill(G4double x, G4double weight = 1.);
+    void Merge(const MomentAccumulator&);
+    
+    G4long GetEntries() const {return fEntries;}
+    G4double GetSumOfWeights() const {return fSumW;}
+    G4double GetSumOfWeights2() const {return fSumW2;}
+    G4double GetEffectiveEntries() const;
+
+    G4double GetMean() const {return fMean;}
+    G4double GetMeanError() const;
+    G4double GetVariance() const;
+    G4double GetSkewness() const;
+    G4double GetKurtosis() const;
+    
+    // Text serialization used by the checkpoints
+    void Write(std::ostream&) const;
+    G4bool Read(std::istream&);
+    
+  private:
+    G4long fEntries;
+    G4double fSumW;
+    G4double fSumW2;
+    G4double fMean;
+    G4double fM2;
+    G4double fM3;
+    G4double fM4;
+};
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+#endif
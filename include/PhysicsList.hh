@@ -32,7 +32,7 @@
 class PhysicsList: public G4VModularPhysicsList
 {
 public:
-  PhysicsList();
+  PhysicsList(G4bool lean = false);
   virtual ~PhysicsList();
 
   virtual void SetCuts();
@@ -3,6 +3,13 @@
 
 #include "G4VUserPrimaryGeneratorAction.hh"
 #include "G4GeneralParticleSource.hh"
+#include "VertexFile.hh"
+
+class G4GenericMessenger;
+class StratifiedSource;
+class QuasiRandomSequence;
+class G4PrimaryVertex;
+class G4PrimaryParticle;
 
 class PrimaryGeneratorAction : public G4VUserPrimaryGeneratorAction
 {
@@ -12,8 +19,34 @@ public:
     ~PrimaryGeneratorAction();
     void GeneratePrimaries(G4Event* anEvent);
     
+    // Replace the GPS position, time and weight of the primaries with the
+    // birth vertices recorded by the production stage
+    void LoadVertices(std::string fileName);
+    
+private:
+    // Position and direction from the numbers of a quasi-random point,
+    // for the GPS volume cylinder and isotropic sources
+    void SetQuasiRandomPosition(G4PrimaryVertex* vertex,const G4double* u);
+    void SetQuasiRandomDirection(G4PrimaryParticle* primary,const G4double* u);
+    void WarnQuasiRandom(const G4String& what);
+    
 private:
     G4GeneralParticleSource* fParticleGPS;
+    
+    // Ions generated in each event, several ions share the per-event
+    // overhead and are told apart by their primary track ID
+    G4int fIonsPerEvent;
+    VertexFile fVertices;
+    G4bool bVerticesChecked;
+    
+    // Weighted mode, off for a zero yield
+    G4double fProductionYield;
+    G4double fSimulatedIons;
+    
+    StratifiedSource* fStratified;
+    QuasiRandomSequence* fQuasiRandom;
+    G4bool bQuasiRandomWarned;
+    G4GenericMessenger* fMessenger;
 };
 
 #endif
@@ -0,0 +1,64 @@
+//
+// ********************************************************************
+// * License and Disclaimer                                           *
+// *                                                                  *
+// * The  Geant4 software  is  copyright of the Copyright Holders  of *
+// * the Geant4 Collaboration.  It is provided  under  the terms  and *
+// * conditions of the Geant4 Software License,  included in the file *
+// * LICENSE and available at  http://cern.ch/geant4/license .  These *
+// * include a list of copyright holders.                             *
+// *                                                                  *
+// * Neither the authors of this software system, nor their employing *
+// * institutes,nor the agencies providing financial support for this *
+// * work  make  any representation or  warranty, express or implied, *
+// * regarding  this  software system or assume any liability for its *
+// * use.  Please see the license in the file  LICENSE  and URL above *
+// * for the full disclaimer and the limitation of liability.         *
+// *                                                                  *
+// * This  code  implementation is the result of  the  scientific and *
+// * technical work of the GEANT4 collaboration.                      *
+// * By using,  copying,  modifying or  distributing the software (or *
+// * any work based  on the software)  you  agree  to acknowledge its *
+// * use  in  resulting  scientific  publications,  and indicate your *
+// * acceptance of all terms of the Geant4 Software license.          *
+// ********************************************************************
+//
+//
+/// \file PrimaryParticleInformation.hh
+/// \brief Definition of the PrimaryParticleInformation class
+
+#ifndef PrimaryParticleInformation_h
+#define PrimaryParticleInformation_h 1
+
+#include "G4VUserPrimaryParticleInformation.hh"
+#include "globals.hh"
+
+/// PrimaryParticleInformation class
+///
+/// Stratum of a primary ion drawn by the StratifiedSource and share of
+/// the production in that stratum, replicate of the QuasiRandomSequence
+/// point of the ion, -1 when not used. Read back by the Run to build the
+/// stratified and the randomized quasi-Monte Carlo estimators of the
+/// release
+
+class PrimaryParticleInformation : public G4VUserPrimaryParticleInformation
+{
+  public:
+    PrimaryParticleInformation(G4int stratum,G4double share,G4int replicate = -1);
+    virtual ~PrimaryParticleInformation();
+
+    virtual void Print() const;
+
+    G4int GetStratum() const {return fStratum;}
+    G4double GetShare() const {return fShare;}
+    G4int GetReplicate() const {return fReplicate;}
+
+  private:
+    G4int fStratum;
+    G4double fShare;
+    G4int fReplicate;
+};
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+#endif
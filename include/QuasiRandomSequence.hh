@@ -0,0 +1,87 @@
+//
+// ********************************************************************
+// * License and Disclaimer                                           *
+// *                                                                  *
+// * The  Geant4 software  is  copyright of the Copyright Holders  of *
+// * the Geant4 Collaboration.  It is provided  under  the terms  and *
+// * conditions of the Geant4 Software License,  included in the file *
+// * LICENSE and available at  http://cern.ch/geant4/license .  These *
+// * include a list of copyright holders.                             *
+// *                                                                  *
+// * Neither the authors of this software system, nor their employing *
+// * institutes,nor the agencies providing financial support for this *
+// * work  make  any representation or  warranty, express or implied, *
+// * regarding  this  software system or assume any liability for its *
+// * use.  Please see the license in the file  LICENSE  and URL above *
+// * for the full disclaimer and the limitation of liability.         *
+// *                                                                  *
+// * This  code  implementation is the result of  the  scientific and *
+// * technical work of the GEANT4 collaboration.                      *
+// * By using,  copying,  modifying or  distributing the software (or *
+// * any work based  on the software)  you  agree  to acknowledge its *
+// * use  in  resulting  scientific  publications,  and indicate your *
+// * acceptance of all terms of the Geant4 Software license.          *
+// ********************************************************************
+//
+//
+/// \file QuasiRandomSequence.hh
+/// \brief Definition of the QuasiRandomSequence class
+
+#ifndef QuasiRandomSequence_h
+#define QuasiRandomSequence_h 1
+
+#include "globals.hh"
+#include "G4GenericMessenger.hh"
+
+#include <cstdint>
+
+/// QuasiRandomSequence class
+///
+/// Randomized quasi-Monte Carlo points for the phase space of the primary
+/// ions: Halton sequence in fDimensions dimensions with a Cranley-Patterson
+/// rotation (random shift modulo 1). The ions of a run are split into
+/// fReplicates independently shifted copies of the sequence, the ion with
+/// global index k takes point k / fReplicates of replicate k % fReplicates,
+/// so that the point depends only on the event ID and not on the thread.
+/// The global index counts from fEventOffset, the events of the previous
+/// runs and checkpoint chunks set by the master, so that a new BeamOn
+/// continues the sequence instead of replaying the same points.
+/// The shifts are a hash of fSeed, the spread of the estimates of the
+/// replicates gives the error of the randomized QMC estimate.
+
+class QuasiRandomSequence
+{
+  public:
+    // Position (3) and direction (2) of the ion
+    static const G4int fDimensions = 5;
+
+  public:
+    QuasiRandomSequence();
+    ~QuasiRandomSequence();
+
+    G4bool IsActive() const {return bActive;}
+    G4int GetReplicates() const {return fReplicates;}
+
+    // Events simulated before the current run, set by the master before
+    // the workers start the event loop
+    static void SetEventOffset(G4long offset) {fEventOffset = offset;}
+    static G4long GetEventOffset() {return fEventOffset;}
+
+    // Point of the ion with the given global index, returns its replicate
+    G4int GetPoint(G4long index,G4double* point) const;
+
+  private:
+    static G4double RadicalInverse(uint64_t index,G4int base);
+    G4double GetShift(G4int replicate,G4int dimension) const;
+
+  private:
+    G4GenericMessenger* fMessenger;
+    G4bool bActive;
+    G4int fReplicates;
+    G4int fSeed;
+    static G4long fEventOffset;
+};
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+#endif
@@ -0,0 +1,147 @@
+//
+// ********************************************************************
+// * License and Disclaimer                                           *
+// *                                                                  *
+// * The  Geant4 software  is  copyright of the Copyright Holders  of *
+// * the Geant4 Collaboration.  It is provided  under  the terms  and *
+// * conditions of the Geant4 Software License,  included in the file *
+// * LICENSE and available at  http://cern.ch/geant4/license .  These *
+// * include a list of copyright holders.                             *
+// *                                                                  *
+// * Neither the authors of this software system, nor their employing *
+// * institutes,nor the agencies providing financial support for this *
+// * work  make  any representation or  warranty, express or implied, *
+// * regarding  this  software system or assume any liability for its *
+// * use.  Please see the license in the file  LICENSE  and URL above *
+// * for the full disclaimer and the limitation of liability.         *
+// *                                                                  *
+// * This  code  implementation is the result of  the  scientific and *
+// * technical work of the GEANT4 collaboration.                      *
+// * By using,  copying,  modifying or  distributing the software (or *
+// * any work based  on the software)  you  agree  to acknowledge its *
+// * use  in  resulting  scientific  publications,  and indicate your *
+// * acceptance of all terms of the Geant4 Software license.          *
+// ********************************************************************
+//
+//
+/// \file RandomVariateBuffer.hh
+/// \brief Definition of the RandomVariateBuffer class
+
+#ifndef RandomVariateBuffer_h
+#define RandomVariateBuffer_h 1
+
+#include "globals.hh"
+#include "G4ThreeVector.hh"
+#include "G4RandomTools.hh"
+#include "Randomize.hh"
+
+// Switch back to the draws one at a time from the engine, for validation
+#define bUSE_RANDOM_BUFFER 1
+
+/// RandomVariateBuffer class
+///
+/// Per-thread blocks of uniforms, Gaussians, isotropic directions and
+/// cosine-law directions for the effusion and diffusion processes. Each
+/// block is filled with a single flatArray() call of the engine and then
+/// transformed in plain loops over arrays, which the compiler vectorizes.
+/// The blocks are refilled on demand and emptied at the beginning of each
+/// event, so that an event only depends on the seeds of the event.
+
+class RandomVariateBuffer
+{
+  public:
+    static RandomVariateBuffer* Instance();
+
+    // Discard the values left in the blocks
+    void Reset();
+
+    inline G4double Uniform();
+    inline G4double Gauss(G4double mean,G4double sigma);
+    inline G4ThreeVector Isotropic();
+    // Cosine law around the unit vector normal
+    inline G4ThreeVector Lambertian(const G4ThreeVector& normal);
+
+  private:
+    RandomVariateBuffer();
+    ~RandomVariateBuffer();
+
+    void FillUniform();
+    void FillGauss();
+    void FillIsotropic();
+    void FillLambertian();
+
+  private:
+    static const G4int fBlockSize = 256;
+    static G4ThreadLocal RandomVariateBuffer* fInstance;
+
+    G4double fFlat[2*fBlockSize];
+
+    G4double fUniform[fBlockSize];
+    G4int fNextUniform;
+
+    G4double fGauss[fBlockSize];
+    G4int fNextGauss;
+
+    G4double fIsotropicX[fBlockSize];
+    G4double fIsotropicY[fBlockSize];
+    G4double fIsotropicZ[fBlockSize];
+    G4int fNextIsotropic;
+
+    // Directions in the frame of the normal, along z
+    G4double fLambertianX[fBlockSize];
+    G4double fLambertianY[fBlockSize];
+    G4double fLambertianZ[fBlockSize];
+    G4int fNextLambertian;
+};
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+inline G4double RandomVariateBuffer::Uniform(){
+    if(fNextUniform == fBlockSize) FillUniform();
+    return fUniform[fNextUniform++];
+}
+
+inline G4double RandomVariateBuffer::Gauss(G4double mean,G4double sigma){
+    if(fNextGauss == fBlockSize) FillGauss();
+    return mean + sigma * fGauss[fNextGauss++];
+}
+
+inline G4ThreeVector RandomVariateBuffer::Isotropic(){
+    if(fNextIsotropic == fBlockSize) FillIsotropic();
+    G4int i0 = fNextIsotropic++;
+    return G4ThreeVector(fIsotropicX[i0],fIsotropicY[i0],fIsotropicZ[i0]);
+}
+
+inline G4ThreeVector RandomVariateBuffer::Lambertian(const G4ThreeVector& normal){
+    if(fNextLambertian == fBlockSize) FillLambertian();
+    G4int i0 = fNextLambertian++;
+    G4ThreeVector u = normal.orthogonal().unit();
+    G4ThreeVector v = normal.cross(u);
+    return fLambertianX[i0] * u + fLambertianY[i0] * v + fLambertianZ[i0] * normal;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+// Draws of the processes, from the buffers or one at a time from the engine
+
+inline G4double BufferedUniform(){
+    if(bUSE_RANDOM_BUFFER) return RandomVariateBuffer::Instance()->Uniform();
+    return G4UniformRand();
+}
+
+inline G4double BufferedGauss(G4double mean,G4double sigma){
+    if(bUSE_RANDOM_BUFFER) return RandomVariateBuffer::Instance()->Gauss(mean,sigma);
+    return G4RandGauss::shoot(mean,sigma);
+}
+
+inline G4ThreeVector BufferedIsotropic(){
+    if(bUSE_RANDOM_BUFFER) return RandomVariateBuffer::Instance()->Isotropic();
+    return G4RandomDirection();
+}
+
+inline G4ThreeVector BufferedLambertian(const G4ThreeVector& normal){
+    if(bUSE_RANDOM_BUFFER) return RandomVariateBuffer::Instance()->Lambertian(normal);
+    return G4LambertianRand(normal);
+}
+
+#endif
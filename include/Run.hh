@@ -33,7 +33,13 @@
 
 #include "G4Run.hh"
 #include "globals.hh"
+#include "MomentAccumulator.hh"
+#include "LogTimeHistogram.hh"
+#include "VertexFile.hh"
+#include "CommonRandomNumbers.hh"
 #include <unordered_map>
+#include <iostream>
+#include <vector>
 
 /// Run class
 ///
@@ -42,21 +48,140 @@
 
 class Run : public G4Run
 {
+  public:
+    // Reasons for the end of a nucleus track, see TrackingAction
+    enum TerminationReason {
+        kDecayed = 1,
+        kTimeLimit,
+        kAdsorbed,
+        kEscaped,
+        kOther
+    };
+
   public:
     Run();
     virtual ~Run();
 
     virtual void RecordEvent(const G4Event*);
     virtual void Merge(const G4Run*);
+
+    // Add the tallies of another run without touching the G4Run counters,
+    // used to sum consecutive runs into the checkpointed totals
+    void Accumulate(const Run*);
+    
+    // Text serialization of the tallies for checkpoint and resume
+    void WriteCheckpoint(std::ostream&) const;
+    G4bool ReadCheckpoint(std::istream&);
     
-    G4int GetCode(G4int A,G4int Z, G4int disk){
+    G4int GetCode(G4int A,G4int Z, G4int disk) const{
         return (disk+1)*1000000 + A*1000 + Z;
     }
     
+    // Online estimators for the convergence check, the isotope code is
+    // the one of GetCode() with disk = -1. The number of generated nuclei
+    // is the sum over the disks of fIsotopes, the released ones are the
+    // tracks reaching the telescope
+    std::vector<G4int> GetReleasedIsotopes() const;
+    MomentAccumulator GetArrivalTime(G4int code) const;
+    G4int GetGenerated(G4int code) const;
+    G4int GetReleased(G4int code) const;
+    // Sums of the weights of the primaries, the release fraction and its
+    // error are the weighted ones and reduce to the counts for unit weights
+    G4double GetGeneratedWeight(G4int code) const;
+    G4double GetReleasedWeight(G4int code) const;
+    G4double GetReleaseFraction(G4int code) const;
+    G4double GetReleaseRelativeError(G4int code) const;
+    G4double GetMeanArrivalTime(G4int code) const;
+    G4double GetMeanArrivalTimeRelativeError(G4int code) const;
+    LogTimeHistogram GetArrivalTimeHistogram(G4int code) const;
+    G4double GetMedianArrivalTime(G4int code) const;
+    G4double GetMedianArrivalTimeRelativeError(G4int code) const;
+
+    // Nucleus produced in a disk, code of GetCode()
+    void AddGenerated(G4int code,G4double weight = 1.);
+
+    // Termination time histograms, filled by the TrackingAction
+    void FillTermination(G4int reason,G4int code,G4double time,G4double weight = 1.);
+    
+    // Time spent in a compartment of the CompartmentModel before moving
+    // to the next one, per element, filled by the SteppingAction. first
+    // is true for the compartment where the track has been produced
+    G4int GetCompartmentCode(G4int Z,G4bool first,G4int from,G4int to) const{
+        return (first ? 10000000 : 0) + Z*10000 + from*100 + to;
+    }
+    void FillCompartment(G4int Z,G4bool first,G4int from,G4int to,G4double time,
+                         G4double weight = 1.);
+    
+    // Stratified sampling (StratifiedSource), the isotope code is the one
+    // of GetCode() with disk = -1. The release fraction is the sum over
+    // the strata of the share times the fraction released in the stratum,
+    // its variance the sum of share^2 p(1-p)/n
+    G4int GetStratumCode(G4int stratum,G4int code) const{
+        return stratum*1000000 + code;
+    }
+    G4double GetStratifiedReleaseFraction(G4int code) const;
+    G4double GetStratifiedReleaseVariance(G4int code) const;
+    // Standard deviation of the release in each stratum, for the Neyman
+    // allocation of the next run. Smoothed, (r+1/2)/(n+1), so that the
+    // strata without release keep some ions
+    std::vector<G4double> GetStratumSigmas(G4int code) const;
+    // Isotope with the most released nuclei from the strata, -1 if none
+    G4int GetStratifiedIsotope() const;
+    void PrintStratifiedSummary() const;
+    
+    // Randomized quasi-Monte Carlo source (QuasiRandomSequence): the
+    // release fraction is the mean of the fractions of the replicates,
+    // its error the standard error of that mean
+    G4int GetReplicateCode(G4int replicate,G4int code) const{
+        return replicate*1000000 + code;
+    }
+    G4double GetQuasiRandomReleaseFraction(G4int code) const;
+    G4double GetQuasiRandomReleaseError(G4int code) const;
+    void PrintQuasiRandomSummary() const;
+
+    // Binary file with the generated counts and all the time histograms
+    void WriteHistograms(const G4String& fileName) const;
+    G4bool ReadHistograms(const G4String& fileName);
+
+    // Table of the arrival time moments per isotope and disk of origin
+    void PrintArrivalTimeSummary() const;
+
+    // Keep the birth vertices of the nuclei produced in the disks
+    void SetRecordVertices(G4bool aBool) {bRecordVertices=aBool;}
+    // Keep the outcome of every primary ion, for the paired comparisons
+    void SetRecordOutcomes(G4bool aBool) {bRecordOutcomes=aBool;}
+
   private:
     G4int fUCx_ID;
+    G4int fTelescope_ID;
+    G4bool bRecordVertices;
+    G4bool bRecordOutcomes;
 public:
     std::unordered_map<int,int> fIsotopes;
+    // Sum of the weights of the nuclei in fIsotopes
+    std::unordered_map<int,G4double> fIsotopesWeight;
+    // Production share and primary ions per stratum, released nuclei per
+    // GetStratumCode()
+    std::unordered_map<int,G4double> fStratumShare;
+    std::unordered_map<int,int> fStratumGenerated;
+    std::unordered_map<int,int> fStratumReleased;
+    // Primary ions per replicate, released nuclei per GetReplicateCode()
+    std::unordered_map<int,int> fReplicateGenerated;
+    std::unordered_map<int,int> fReplicateReleased;
+    // Arrival time at the telescope per isotope and disk of origin, the
+    // nuclei produced outside the disks are stored with disk = -1
+    std::unordered_map<int,MomentAccumulator> fArrivalTime;
+    // Log-time histograms of the arrival at the telescope (same keys as
+    // fArrivalTime) and of the end of the tracks (reason*100000000 + code)
+    std::unordered_map<int,LogTimeHistogram> fArrivalHistogram;
+    std::unordered_map<int,LogTimeHistogram> fTerminationHistogram;
+    // Dwell time histograms, with the keys of GetCompartmentCode()
+    std::unordered_map<int,LogTimeHistogram> fCompartmentHistogram;
+    // Birth vertices per isotope code, merged into the master run but not
+    // accumulated or checkpointed
+    std::unordered_map<int,std::vector<VertexFile::Record> > fVertices;
+    // Outcomes of the primary ions, merged like the vertices
+    std::vector<CommonRandomNumbers::Outcome> fOutcomes;
 };
 
 //....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
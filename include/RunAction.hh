@@ -29,9 +29,16 @@
 
 #include "G4UserRunAction.hh"
 #include "globals.hh"
+#include <vector>
+#include <set>
 
 class RunActionMessenger;
 class G4Run;
+class Run;
+class BeamScheduleConvolver;
+class EffusionTransitionSolver;
+class FreeMolecularFlowEngine;
+class CompartmentModel;
 
 class RunAction : public G4UserRunAction
 {
@@ -42,6 +49,92 @@ public:
     virtual G4Run* GenerateRun();
     virtual void BeginOfRunAction(const G4Run*);
     virtual void   EndOfRunAction(const G4Run*);
+
+    // Checkpointed runs: the events are processed in chunks of
+    // fEventsPerChunk, after each chunk the merged tallies and the master
+    // random engine (which seeds the worker streams) are saved to disk
+    void BeamOnWithCheckpoints(G4long nEvents);
+    void Resume();
+    void TopUp(G4long nEvents);
+
+    // Convergence-driven runs: chunks of fEventsPerChunk events are
+    // processed until the relative standard error of the chosen
+    // observables is below fConvergenceTarget for every isotope, the
+    // wall-time budget is exhausted or nMaxEvents have been simulated
+    void BeamOnUntilConverged(G4long nMaxEvents);
+    void AddConvergenceIsotope(G4int A,G4int Z);
+    void ClearConvergenceIsotopes() {fConvergenceIsotopes.clear();}
+
+private:
+    void ProcessChunks();
+    G4bool IsConverged();
+    void WriteCheckpoint();
+    G4bool ReadCheckpoint();
+
+private:
+    RunActionMessenger* fMessenger;
+    BeamScheduleConvolver* fConvolver;
+    EffusionTransitionSolver* fSolver;
+    FreeMolecularFlowEngine* fEngine;
+    CompartmentModel* fCompartmentModel;
+    Run* fCumulativeRun;
+    G4long fEventsDone;
+    G4long fEventsTarget;
+    G4bool bCheckpoint;
+    G4bool bConvergence;
+    std::vector<G4int> fConvergenceIsotopes;
+
+private:
+    G4String fCheckpointFile;
+public:
+    void SetCheckpointFile(G4String aString) {fCheckpointFile=aString;}
+    G4String GetCheckpointFile() {return fCheckpointFile;}
+
+private:
+    G4int fEventsPerChunk;
+public:
+    void SetEventsPerChunk(G4int aInt) {fEventsPerChunk=aInt;}
+    G4int GetEventsPerChunk() {return fEventsPerChunk;}
+
+private:
+    G4bool bOutputPerRun;
+public:
+    void SetOutputPerRun(G4bool aBool) {bOutputPerRun=aBool;}
+    G4bool GetOutputPerRun() {return bOutputPerRun;}
+
+private:
+    G4double fConvergenceTarget;
+public:
+    void SetConvergenceTarget(G4double aDouble) {fConvergenceTarget=aDouble;}
+    G4double GetConvergenceTarget() {return fConvergenceTarget;}
+
+private:
+    G4String fConvergenceObservable;
+public:
+    void SetConvergenceObservable(G4String aString) {fConvergenceObservable=aString;}
+    G4String GetConvergenceObservable() {return fConvergenceObservable;}
+
+private:
+    G4double fMaxWallTime;
+public:
+    void SetMaxWallTime(G4double aDouble) {fMaxWallTime=aDouble;}
+    G4double GetMaxWallTime() {return fMaxWallTime;}
+
+private:
+    G4String fHistogramFile;
+public:
+    void SetHistogramFile(G4String aString) {fHistogramFile=aString;}
+    G4String GetHistogramFile() {return fHistogramFile;}
+
+private:
+    // Prefix of the vertex files, empty if the vertices are not recorded.
+    // The files written in this job are started anew, the later runs
+    // append to them
+    G4String fVertexPrefix;
+    std::set<G4int> fVertexCodes;
+public:
+    void SetVertexPrefix(G4String aString) {fVertexPrefix=aString;}
+    G4String GetVertexPrefix() {return fVertexPrefix;}
 };
 
 //....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
@@ -0,0 +1,84 @@
+//
+// ********************************************************************
+// * License and Disclaimer                                           *
+// *                                                                  *
+// * The  Geant4 software  is  copyright of the Copyright Holders  of *
+// * the Geant4 Collaboration.  It is provided  under  the terms  and *
+// * conditions of the Geant4 Software License,  included in the file *
+// * LICENSE and available at  http://cern.ch/geant4/license .  These *
+// * include a list of copyright holders.                             *
+// *                                                                  *
+// * Neither the authors of this software system, nor their employing *
+// * institutes,nor the agencies providing financial support for this *
+// * work  make  any representation or  warranty, express or implied, *
+// * regarding  this  software system or assume any liability for its *
+// * use.  Please see the license in the file  LICENSE  and URL above *
+// * for the full disclaimer and the limitation of liability.         *
+// *                                                                  *
+// * This  code  implementation is the result of  the  scientific and *
+// * technical work of the GEANT4 collaboration.                      *
+// * By using,  copying,  modifying or  distributing the software (or *
+// * any work based  on the software)  you  agree  to acknowledge its *
+// * use  in  resulting  scientific  publications,  and indicate your *
+// * acceptance of all terms of the Geant4 Software license.          *
+// ********************************************************************
+// --------------------------------------------------------------
+//
+
+#ifndef RunActionMessenger_h
+#define RunActionMessenger_h 1
+
+class RunAction;
+class G4UIdirectory;
+class G4UIcmdWithAString;
+class G4UIcmdWithAnInteger;
+class G4UIcmdWithADouble;
+class G4UIcmdWithABool;
+class G4UIcmdWithoutParameter;
+class G4UIcmdWithADoubleAndUnit;
+class G4UIcommand;
+
+#include "G4UImessenger.hh"
+#include "globals.hh"
+
+class RunActionMessenger: public G4UImessenger
+{
+public:
+    RunActionMessenger(RunAction* mpga);
+    ~RunActionMessenger();
+    
+    virtual void SetNewValue(G4UIcommand * command,G4String newValues);
+    virtual G4String GetCurrentValue(G4UIcommand * command);
+    
+private:
+    RunAction * fTarget;
+    
+    G4UIdirectory* fCheckpointDirectory;
+    
+    G4UIcmdWithAString* fCheckpointFileCmd;
+    G4UIcmdWithAnInteger* fEventsPerChunkCmd;
+    G4UIcmdWithADouble* fBeamOnCmd;
+    G4UIcmdWithoutParameter* fResumeCmd;
+    G4UIcmdWithADouble* fTopUpCmd;
+    G4UIcmdWithABool* fOutputPerRunCmd;
+
+    G4UIdirectory* fConvergenceDirectory;
+
+    G4UIcmdWithADouble* fConvergenceTargetCmd;
+    G4UIcmdWithAString* fConvergenceObservableCmd;
+    G4UIcommand* fAddIsotopeCmd;
+    G4UIcmdWithoutParameter* fClearIsotopesCmd;
+    G4UIcmdWithADoubleAndUnit* fMaxWallTimeCmd;
+    G4UIcmdWithADouble* fConvergenceBeamOnCmd;
+
+    G4UIdirectory* fHistogramDirectory;
+
+    G4UIcmdWithAString* fHistogramFileCmd;
+
+    G4UIdirectory* fVertexDirectory;
+
+    G4UIcmdWithAString* fVertexPrefixCmd;
+};
+
+#endif
+
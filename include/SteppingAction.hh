@@ -0,0 +1,78 @@
+//
+// ********************************************************************
+// * License and Disclaimer                                           *
+// *                                                                  *
+// * The  Geant4 software  is  copyright of the Copyright Holders  of *
+// * the Geant4 Collaboration.  It is provided  under  the terms  and *
+// * conditions of the Geant4 Software License,  included in the file *
+// * LICENSE and available at  http://cern.ch/geant4/license .  These *
+// * include a list of copyright holders.                             *
+// *                                                                  *
+// * Neither the authors of this software system, nor their employing *
+// * institutes,nor the agencies providing financial support for this *
+// * work  make  any representation or  warranty, express or implied, *
+// * regarding  this  software system or assume any liability for its *
+// * use.  Please see the license in the file  LICENSE  and URL above *
+// * for the full disclaimer and the limitation of liability.         *
+// *                                                                  *
+// * This  code  implementation is the result of  the  scientific and *
+// * technical work of the GEANT4 collaboration.                      *
+// * By using,  copying,  modifying or  distributing the software (or *
+// * any work based  on the software)  you  agree  to acknowledge its *
+// * use  in  resulting  scientific  publications,  and indicate your *
+// * acceptance of all terms of the Geant4 Software license.          *
+// ********************************************************************
+//
+//
+/// \file SteppingAction.hh
+/// \brief Definition of the SteppingAction class
+
+#ifndef SteppingAction_h
+#define SteppingAction_h 1
+
+#include "G4UserSteppingAction.hh"
+#include "globals.hh"
+
+#include <unordered_map>
+
+class G4Step;
+class G4VPhysicalVolume;
+class G4ParticleDefinition;
+
+/// SteppingAction class
+///
+/// Calibration of the CompartmentModel: for each nucleus, the time spent
+/// in a compartment is stored in the Run when the track moves to another
+/// compartment, leaves the world or is killed. The time is lost for the
+/// nuclei which decay, the decay is applied by the model. Registered
+/// only with /compartment/setCalibration true.
+
+class SteppingAction : public G4UserSteppingAction
+{
+public:
+    SteppingAction();
+    virtual ~SteppingAction();
+    
+    virtual void UserSteppingAction(const G4Step*);
+
+private:
+    G4int GetCompartment(const G4VPhysicalVolume*);
+
+private:
+    // Compartment of the volumes, filled at the first visit
+    std::unordered_map<const G4VPhysicalVolume*,G4int> fCompartments;
+    
+    // Definition of the last step and whether it is a nucleus
+    const G4ParticleDefinition* fDefinition;
+    G4bool bNucleus;
+    
+    // Compartment of the current track, time of entry and whether the
+    // track has been produced there
+    G4int fCompartment;
+    G4double fEntryTime;
+    G4bool bFirst;
+};
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+#endif
@@ -0,0 +1,131 @@
+//
+// ********************************************************************
+// * License and Disclaimer                                           *
+// *                                                                  *
+// * The  Geant4 software  is  copyright of the Copyright Holders  of *
+// * the Geant4 Collaboration.  It is provided  under  the terms  and *
+// * conditions of the Geant4 Software License,  included in the file *
+// * LICENSE and available at  http://cern.ch/geant4/license .  These *
+// * include a list of copyright holders.                             *
+// *                                                                  *
+// * Neither the authors of this software system, nor their employing *
+// * institutes,nor the agencies providing financial support for this *
+// * work  make  any representation or  warranty, express or implied, *
+// * regarding  this  software system or assume any liability for its *
+// * use.  Please see the license in the file  LICENSE  and URL above *
+// * for the full disclaimer and the limitation of liability.         *
+// *                                                                  *
+// * This  code  implementation is the result of  the  scientific and *
+// * technical work of the GEANT4 collaboration.                      *
+// * By using,  copying,  modifying or  distributing the software (or *
+// * any work based  on the software)  you  agree  to acknowledge its *
+// * use  in  resulting  scientific  publications,  and indicate your *
+// * acceptance of all terms of the Geant4 Software license.          *
+// ********************************************************************
+//
+//
+/// \file StratifiedSource.hh
+/// \brief Definition of the StratifiedSource class
+
+#ifndef StratifiedSource_h
+#define StratifiedSource_h 1
+
+#include "globals.hh"
+#include "G4GenericMessenger.hh"
+#include "G4ThreeVector.hh"
+#include "VertexFile.hh"
+
+#include <map>
+#include <string>
+#include <vector>
+
+class G4VPhysicalVolume;
+
+/// StratifiedSource class
+///
+/// Stratified sampling of the primary ions in the disks. Each disk is
+/// split in fRadialZones rings of equal area and fDepthZones slabs of
+/// equal thickness, the share of the production of a stratum is the
+/// one of its disk (proportional to the volume unless given) divided by
+/// the number of strata of the disk. The ions of a run are assigned to
+/// the strata from their global index, proportionally to the share or
+/// with the Neyman allocation (share times the standard deviation of
+/// the release in the stratum, from a pilot run), with at least one ion
+/// per stratum. Inside a stratum the position is uniform. The Run
+/// combines the release of the strata with their shares.
+///
+/// With a vertex file the share of a stratum is the weight of the
+/// records born in it and the positions are drawn among these records
+/// with a probability proportional to their weight, the strata without
+/// record are dropped. The disk shares then only select the disks.
+
+class StratifiedSource
+{
+  public:
+    StratifiedSource();
+    ~StratifiedSource();
+
+    G4bool IsActive() const {return bActive;}
+
+    // Stratum of the ion with the given index among total ions of the run
+    G4int GetStratum(G4long index,G4long total);
+    // Uniform position in the stratum, from three numbers in [0,1) if
+    // given (quasi-random points) or from the random engine
+    G4ThreeVector SamplePosition(G4int stratum,const G4double* u = nullptr) const;
+    // Record of the vertex file in the stratum from a number in [0,1),
+    // nullptr without vertex file
+    const VertexFile::Record* SampleRecord(G4int stratum,G4double u) const;
+    G4double GetShare(G4int stratum) const {return fStrata[stratum].fShare;}
+
+    // Vertex file giving the shares and the positions, nullptr for the
+    // uniform strata
+    void SetVertices(const VertexFile* vertices);
+
+    // disk;share, the disks without a share are not sampled once a share
+    // is given
+    void SetDiskShare(std::string s);
+    void ClearDiskShares();
+    // sigma of the strata separated by ';', used by the Neyman allocation
+    void SetSigmas(std::string s);
+
+  private:
+    G4bool Setup();
+    void BuildAllocation(G4long total);
+    void AssignVertices(const std::vector<G4VPhysicalVolume*>& disks,
+                        G4int radialZones,G4int depthZones);
+
+  private:
+    struct Stratum {
+        G4VPhysicalVolume* fVolume;
+        G4double fRMin, fRMax;
+        G4double fZMin, fZMax;
+        G4double fPhiStart, fPhiDelta;
+        G4double fShare;
+        // Records of the vertex file in the stratum and their cumulative
+        // weight
+        std::vector<G4long> fRecords;
+        std::vector<G4double> fRecordCumulative;
+    };
+    std::vector<Stratum> fStrata;
+    std::map<G4int,G4double> fDiskShare;
+    std::vector<G4double> fSigma;
+    const VertexFile* fVertices;
+    
+    // Cumulative number of ions of the strata for a run of fTotal ions
+    std::vector<G4double> fCumulative;
+    G4long fTotal;
+    G4bool bChanged;
+    G4int fBuiltRadialZones;
+    G4int fBuiltDepthZones;
+    G4String fBuiltAllocation;
+
+    G4GenericMessenger* fMessenger;
+    G4bool bActive;
+    G4int fRadialZones;
+    G4int fDepthZones;
+    G4String fAllocation;
+};
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+#endif
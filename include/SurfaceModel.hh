@@ -0,0 +1,162 @@
+//
+// ********************************************************************
+// * License and Disclaimer                                           *
+// *                                                                  *
+// * The  Geant4 software  is  copyright of the Copyright Holders  of *
+// * the Geant4 Collaboration.  It is provided  under  the terms  and *
+// * conditions of the Geant4 Software License,  included in the file *
+// * LICENSE and available at  http://cern.ch/geant4/license .  These *
+// * include a list of copyright holders.                             *
+// *                                                                  *
+// * Neither the authors of this software system, nor their employing *
+// * institutes,nor the agencies providing financial support for this *
+// * work  make  any representation or  warranty, express or implied, *
+// * regarding  this  software system or assume any liability for its *
+// * use.  Please see the license in the file  LICENSE  and URL above *
+// * for the full disclaimer and the limitation of liability.         *
+// *                                                                  *
+// * This  code  implementation is the result of  the  scientific and *
+// * technical work of the GEANT4 collaboration.                      *
+// * By using,  copying,  modifying or  distributing the software (or *
+// * any work based  on the software)  you  agree  to acknowledge its *
+// * use  in  resulting  scientific  publications,  and indicate your *
+// * acceptance of all terms of the Geant4 Software license.          *
+// ********************************************************************
+//
+//
+/// \file SurfaceModel.hh
+/// \brief Policies of the surface interaction of the EffusionProcess
+
+#ifndef SurfaceModel_h
+#define SurfaceModel_h 1
+
+#include "globals.hh"
+#include "G4ThreeVector.hh"
+#include "G4Track.hh"
+#include "G4Step.hh"
+#include "G4StepPoint.hh"
+#include "G4VPhysicalVolume.hh"
+#include "G4LogicalVolume.hh"
+#include "G4Material.hh"
+#include "G4RandomTools.hh"
+#include "G4PhysicalConstants.hh"
+#include "Randomize.hh"
+#include "RandomVariateBuffer.hh"
+#include "ThermalEnergyTable.hh"
+
+#include <cmath>
+
+/// Surface models of the EffusionProcess
+///
+/// A surface model is a struct with six policies:
+///   Diffusion      probability to enter the material
+///   Adsorption     probability to stick on the surface
+///   FullAdsorption probability to stay on the surface forever
+///   StickingTime   sticking time from the mean adsorption time
+///   Energy         kinetic energy after the re-emission
+///   Emission       direction of re-emission from the outward normal
+/// The probability policies tell at compile time whether they are
+/// constant, so that the test and the random number disappear for the
+/// constant ones. A model depending on the material reads it from the
+/// post-step point of the track.
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+struct NeverPolicy {
+    static const G4bool kAlways = false;
+    static const G4bool kNever = true;
+    static G4double GetProbability(const G4Track&) {return 0.;}
+};
+
+struct AlwaysPolicy {
+    static const G4bool kAlways = true;
+    static const G4bool kNever = false;
+    static G4double GetProbability(const G4Track&) {return 1.;}
+};
+
+// Sampling of a probability policy, without random number if constant
+template<class Probability>
+inline G4bool SurfaceTest(const G4Track& aTrack){
+    if(Probability::kAlways) return true;
+    if(Probability::kNever) return false;
+    return BufferedUniform() < Probability::GetProbability(aTrack);
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+// The particle stays on the surface for the mean adsorption time
+struct MeanStickingTime {
+    static G4double Sample(G4double meanTime) {return meanTime;}
+};
+
+// Exponential distribution of the sticking time (Frenkel)
+struct ExponentialStickingTime {
+    static G4double Sample(G4double meanTime){
+        if(meanTime <= 0.) return 0.;
+        return - meanTime * std::log(1. - BufferedUniform());
+    }
+};
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+struct UnchangedEnergy {
+    static const G4bool kUnchanged = true;
+    static G4double Sample(const G4Track& aTrack) {return aTrack.GetKineticEnergy();}
+};
+
+// Ideal gas at the temperature of the material hit
+struct MaxwellBoltzmannEnergy {
+    static const G4bool kUnchanged = false;
+    static G4double Sample(const G4Track& aTrack){
+        const G4StepPoint* pPostStepPoint = aTrack.GetStep()->GetPostStepPoint();
+        G4Material* aMaterialPost = pPostStepPoint->GetPhysicalVolume()->GetLogicalVolume()->GetMaterial();
+        G4double mass = aTrack.GetDefinition()->GetPDGMass();
+        G4double sqrtkTm = std::sqrt(CLHEP::k_Boltzmann * aMaterialPost->GetTemperature() * mass);
+        G4double px = BufferedGauss(0.,sqrtkTm);
+        G4double py = BufferedGauss(0.,sqrtkTm);
+        G4double pz = BufferedGauss(0.,sqrtkTm);
+        return (px * px + py * py + pz * pz) * 0.5 / mass;
+    }
+};
+
+// Flux of an ideal gas leaving the material hit, from the tabulated
+// inverse CDF of the ThermalEnergyTable
+struct TabulatedThermalEnergy {
+    static const G4bool kUnchanged = false;
+    static G4double Sample(const G4Track& aTrack){
+        const G4StepPoint* pPostStepPoint = aTrack.GetStep()->GetPostStepPoint();
+        return ThermalEnergyTable::Instance()->Sample(pPostStepPoint->GetMaterial(),
+                                                      BufferedUniform());
+    }
+};
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+// Cosine law around the outward normal
+struct LambertianEmission {
+    static G4ThreeVector Sample(const G4ThreeVector& normal) {return BufferedLambertian(normal);}
+};
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+// Model of the EffusionProcess: no diffusion, adsorption at each hit for
+// the mean adsorption time, re-emission with the same energy and the
+// cosine law
+struct DefaultSurfaceModel {
+    typedef NeverPolicy Diffusion;
+    typedef AlwaysPolicy Adsorption;
+    typedef NeverPolicy FullAdsorption;
+    typedef MeanStickingTime StickingTime;
+    typedef UnchangedEnergy Energy;
+    typedef LambertianEmission Emission;
+};
+
+// Default model with the thermal re-emission energy, used by the
+// EffusionProcess with /effusion/setThermalEnergy
+struct ThermalSurfaceModel : public DefaultSurfaceModel {
+    typedef TabulatedThermalEnergy Energy;
+};
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+#endif
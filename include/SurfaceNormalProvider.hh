@@ -0,0 +1,100 @@
+//
+// ********************************************************************
+// * License and Disclaimer                                           *
+// *                                                                  *
+// * The  Geant4 software  is  copyright of the Copyright Holders  of *
+// * the Geant4 Collaboration.  It is provided  under  the terms  and *
+// * conditions of the Geant4 Software License,  included in the file *
+// * LICENSE and available at  http://cern.ch/geant4/license .  These *
+// * include a list of copyright holders.                             *
+// *                                                                  *
+// * Neither the authors of this software system, nor their employing *
+// * institutes,nor the agencies providing financial support for this *
+// * work  make  any representation or  warranty, express or implied, *
+// * regarding  this  software system or assume any liability for its *
+// * use.  Please see the license in the file  LICENSE  and URL above *
+// * for the full disclaimer and the limitation of liability.         *
+// *                                                                  *
+// * This  code  implementation is the result of  the  scientific and *
+// * technical work of the GEANT4 collaboration.                      *
+// * By using,  copying,  modifying or  distributing the software (or *
+// * any work based  on the software)  you  agree  to acknowledge its *
+// * use  in  resulting  scientific  publications,  and indicate your *
+// * acceptance of all terms of the Geant4 Software license.          *
+// ********************************************************************
+//
+//
+/// \file SurfaceNormalProvider.hh
+/// \brief Definition of the SurfaceNormalProvider class
+
+#ifndef SurfaceNormalProvider_h
+#define SurfaceNormalProvider_h 1
+
+#include "globals.hh"
+#include "G4ThreeVector.hh"
+#include "G4AffineTransform.hh"
+
+#include <unordered_map>
+#include <vector>
+
+class G4VPhysicalVolume;
+class G4VSolid;
+
+/// SurfaceNormalProvider class
+///
+/// Outward normal of the surface of a volume placed in the world, used
+/// for the Lambertian re-emission in place of the navigator. The global
+/// to local transforms of the daughters of the world are computed once,
+/// and the normal of the G4Tubs and G4CutTubs with full phi and of the
+/// G4Box is given in closed form from the nearest surface. The boolean
+/// and the other solids, and the volumes not placed in the world, are
+/// left to the navigator.
+
+class SurfaceNormalProvider
+{
+  public:
+    SurfaceNormalProvider();
+    ~SurfaceNormalProvider();
+
+    // Outward normal in the global frame of the surface of the volume
+    // nearest to the global point, false if not supported
+    G4bool GetGlobalNormal(const G4VPhysicalVolume* volume,
+                           const G4ThreeVector& globalPoint,
+                           G4ThreeVector& globalNormal);
+
+  private:
+    enum ShapeType {kUnsupported, kTube, kBox};
+
+    struct Entry {
+        G4int fType;
+        G4AffineTransform fToLocal;
+        G4AffineTransform fToGlobal;
+        // Tube: radii, half length and outward normals of the cuts
+        // through (0,0,-fDz) and (0,0,+fDz); box: half lengths
+        G4double fRmin;
+        G4double fRmax;
+        G4double fDz;
+        G4ThreeVector fLowNorm;
+        G4ThreeVector fHighNorm;
+        G4ThreeVector fHalf;
+    };
+
+    void Import();
+    static void MakeEntry(const G4VSolid*,Entry&);
+    static G4ThreeVector TubeNormal(const Entry&,const G4ThreeVector&);
+    static G4ThreeVector BoxNormal(const Entry&,const G4ThreeVector&);
+
+  private:
+    G4bool bImported;
+    std::vector<Entry> fEntries;
+    std::unordered_map<const G4VPhysicalVolume*,size_t> fIndex;
+
+    // Entry of the last volume, the nuclei bounce many times in a row
+    // on the same volumes
+    const G4VPhysicalVolume* fLastVolume;
+    const Entry* fLastEntry;
+};
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+#endif
@@ -79,6 +79,8 @@ private:
     G4double fEnergy;
     G4double fEnergyPrevious;
     G4int fDisk;
+    G4int fIon;
+    G4double fWeight;
 
 public:
     inline void SetTrackID(G4int z) { fTrackID = z; }
@@ -103,6 +105,10 @@ public:
     inline G4double GetEnergyPrevious() const { return fEnergyPrevious; }
     inline void SetDiskNumber(G4int z) { fDisk = z; }
     inline G4int GetDiskNumber() const { return fDisk; }
+    inline void SetIon(G4int z) { fIon = z; }
+    inline G4int GetIon() const { return fIon; }
+    inline void SetWeight(G4double w) { fWeight = w; }
+    inline G4double GetWeight() const { return fWeight; }
 };
 
 typedef G4THitsCollection<TargetSensitiveDetectorHit> TargetSensitiveDetectorHitsCollection;
@@ -0,0 +1,77 @@
+//
+// ********************************************************************
+// * License and Disclaimer                                           *
+// *                                                                  *
+// * The  Geant4 software  is  copyright of the Copyright Holders  of *
+// * the Geant4 Collaboration.  It is provided  under  the terms  and *
+// * conditions of the Geant4 Software License,  included in the file *
+// * LICENSE and available at  http://cern.ch/geant4/license .  These *
+// * include a list of copyright holders.                             *
+// *                                                                  *
+// * Neither the authors of this software system, nor their employing *
+// * institutes,nor the agencies providing financial support for this *
+// * work  make  any representation or  warranty, express or implied, *
+// * regarding  this  software system or assume any liability for its *
+// * use.  Please see the license in the file  LICENSE  and URL above *
+// * for the full disclaimer and the limitation of liability.         *
+// *                                                                  *
+// * This  code  implementation is the result of  the  scientific and *
+// * technical work of the GEANT4 collaboration.                      *
+// * By using,  copying,  modifying or  distributing the software (or *
+// * any work based  on the software)  you  agree  to acknowledge its *
+// * use  in  resulting  scientific  publications,  and indicate your *
+// * acceptance of all terms of the Geant4 Software license.          *
+// ********************************************************************
+//
+//
+/// \file ThermalEnergyTable.hh
+/// \brief Definition of the ThermalEnergyTable class
+
+#ifndef ThermalEnergyTable_h
+#define ThermalEnergyTable_h 1
+
+#include "globals.hh"
+
+#include <vector>
+
+class G4Material;
+
+/// ThermalEnergyTable class
+///
+/// Kinetic energy of the ions re-emitted by a surface at the temperature
+/// of its material. The flux of an ideal gas through a surface has the
+/// energy spectrum E exp(-E/kT), i.e. a Gamma(2) in units of kT, which
+/// does not depend on the mass. A single inverse CDF of the Gamma(2) is
+/// tabulated once, and the kT of the materials are taken at the start of
+/// the run, so that a sample costs one uniform and one interpolation. The
+/// last bin, with the tail, is inverted with Newton's method.
+
+class ThermalEnergyTable
+{
+  public:
+    static ThermalEnergyTable* Instance();
+
+    // kT of the materials of the material table, at the start of the run
+    void Build();
+
+    G4double Sample(const G4Material* material,G4double u);
+
+  private:
+    ThermalEnergyTable();
+    ~ThermalEnergyTable();
+
+    static G4double InverseCDF(G4double u,G4double x);
+
+  private:
+    static const G4int fBins = 1024;
+    static G4ThreadLocal ThermalEnergyTable* fInstance;
+
+    // E/kT at u = i/fBins
+    G4double fInverseCDF[fBins];
+    // Indexed by G4Material::GetIndex()
+    std::vector<G4double> fkT;
+};
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+#endif
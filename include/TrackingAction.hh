@@ -0,0 +1,90 @@
+//
+// ********************************************************************
+// * License and Disclaimer                                           *
+// *                                                                  *
+// * The  Geant4 software  is  copyright of the Copyright Holders  of *
+// * the Geant4 Collaboration.  It is provided  under  the terms  and *
+// * conditions of the Geant4 Software License,  included in the file *
+// * LICENSE and available at  http://cern.ch/geant4/license .  These *
+// * include a list of copyright holders.                             *
+// *                                                                  *
+// * Neither the authors of this software system, nor their employing *
+// * institutes,nor the agencies providing financial support for this *
+// * work  make  any representation or  warranty, express or implied, *
+// * regarding  this  software system or assume any liability for its *
+// * use.  Please see the license in the file  LICENSE  and URL above *
+// * for the full disclaimer and the limitation of liability.         *
+// *                                                                  *
+// * This  code  implementation is the result of  the  scientific and *
+// * technical work of the GEANT4 collaboration.                      *
+// * By using,  copying,  modifying or  distributing the software (or *
+// * any work based  on the software)  you  agree  to acknowledge its *
+// * use  in  resulting  scientific  publications,  and indicate your *
+// * acceptance of all terms of the Geant4 Software license.          *
+// ********************************************************************
+// --------------------------------------------------------------
+//
+
+#ifndef TrackingAction_h
+#define TrackingAction_h 1
+
+#include "G4UserTrackingAction.hh"
+#include "globals.hh"
+
+#include <unordered_map>
+#include <cstdint>
+
+class G4Track;
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+class TrackingAction : public G4UserTrackingAction
+{
+public:
+
+  TrackingAction();
+  virtual ~TrackingAction();
+   
+  virtual void PreUserTrackingAction(const G4Track*);
+  virtual void PostUserTrackingAction(const G4Track*);
+    
+    // Track ID of the primary ion the track descends from, -1 if unknown
+    G4int GetIon(G4int trackID) const;
+    
+    // Weight of the source of the primary ion the track descends from,
+    // yield / simulated ions times the vertex file weight, 1 if unknown.
+    // The weights of the biasing of the decay are not part of it
+    G4double GetSourceWeight(G4int trackID) const;
+    
+    // Forget the tracks of the previous event, called at the begin of each
+    // event: with several ions per event the track ID 1 is no longer the
+    // start of the event, and the event ID restarts with every run
+    void ClearEvent();
+
+private:
+    G4int GetTerminationReason(const G4Track*);
+    
+private:
+    // Disk where the nuclei of the current event have been produced,
+    // -1 outside the disks
+    std::unordered_map<G4int,G4int> fOriginDisk;
+    
+    // Primary ion of the tracks of the current event, an event can carry
+    // several ions and the tallies are tagged with the one they come from
+    std::unordered_map<G4int,G4int> fIon;
+    std::unordered_map<G4int,G4double> fSourceWeight;
+    
+    // Common random numbers: stream key of the tracks of the current event
+    // and number of daughters of each track already started
+    std::unordered_map<G4int,uint64_t> fStreamKey;
+    std::unordered_map<G4int,G4int> fDaughters;
+    
+    // Index of the EffusionTrackData, created here for the nuclei before
+    // the processes start tracking
+    G4int fEffusionID;
+};
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+#endif
+
@@ -0,0 +1,121 @@
+//
+// ********************************************************************
+// * License and Disclaimer                                           *
+// *                                                                  *
+// * The  Geant4 software  is  copyright of the Copyright Holders  of *
+// * the Geant4 Collaboration.  It is provided  under  the terms  and *
+// * conditions of the Geant4 Software License,  included in the file *
+// * LICENSE and available at  http://cern.ch/geant4/license .  These *
+// * include a list of copyright holders.                             *
+// *                                                                  *
+// * Neither the authors of this software system, nor their employing *
+// * institutes,nor the agencies providing financial support for this *
+// * work  make  any representation or  warranty, express or implied, *
+// * regarding  this  software system or assume any liability for its *
+// * use.  Please see the license in the file  LICENSE  and URL above *
+// * for the full disclaimer and the limitation of liability.         *
+// *                                                                  *
+// * This  code  implementation is the result of  the  scientific and *
+// * technical work of the GEANT4 collaboration.                      *
+// * By using,  copying,  modifying or  distributing the software (or *
+// * any work based  on the software)  you  agree  to acknowledge its *
+// * use  in  resulting  scientific  publications,  and indicate your *
+// * acceptance of all terms of the Geant4 Software license.          *
+// ********************************************************************
+//
+//
+/// \file TransferLineKernel.hh
+/// \brief Definition of the TransferLineKernel class
+
+#ifndef TransferLineKernel_h
+#define TransferLineKernel_h 1
+
+#include "globals.hh"
+#include "G4ThreeVector.hh"
+#include "G4AffineTransform.hh"
+
+#include <vector>
+
+class G4VPhysicalVolume;
+class G4CutTubs;
+
+/// TransferLineKernel class
+///
+/// Tabulated outcome of the effusion through the bore of the transfer
+/// line, the two vacuum envelopes TransferBore1 and TransferBore2. The
+/// ions enter uniformly from the open end of TransferBore1 with a cosine
+/// law and bounce with Lambertian re-emission on the tube walls until
+/// they leave from the far end of TransferBore2 (transmission) or from
+/// the entrance (return). For each history the exit point and direction
+/// in the frame of the exit envelope, the flight length and the number
+/// of wall hits are stored: the elapsed time of an ion with velocity v
+/// and adsorption time tau on the walls is length/v + hits*tau, so that
+/// a kernel serves every ion and adsorption time of the same geometry.
+
+class TransferLineKernel
+{
+  public:
+    struct Entry {
+        G4bool fTransmitted;
+        G4ThreeVector fPosition;
+        G4ThreeVector fDirection;
+        G4double fLength;
+        G4int fHits;
+    };
+
+  public:
+    TransferLineKernel();
+    ~TransferLineKernel();
+
+    // Find the envelopes in the current geometry, false if missing
+    G4bool SetupGeometry();
+
+    // Trace the histories with the same bounce model of EffusionProcess
+    G4bool Build(G4int histories);
+
+    // Binary file keyed by the geometry of the envelopes, Read() fails
+    // if the geometry differs from the current one
+    G4bool Write(const G4String& fileName) const;
+    G4bool Read(const G4String& fileName);
+
+    // Random history of the kernel
+    const Entry& Sample() const;
+
+    // True for a point on the entrance of TransferBore1 moving inwards,
+    // both in the local frame of the envelope
+    G4bool IsEntering(const G4ThreeVector& localPoint,
+                      const G4ThreeVector& localDirection) const;
+
+    // Global coordinates of the exit of a history
+    G4ThreeVector GetGlobalPosition(const Entry&) const;
+    G4ThreeVector GetGlobalDirection(const Entry&) const;
+
+    G4VPhysicalVolume* GetEntrance() const {return fBore[0];}
+    G4int GetWallZ() const {return fWallZ;}
+    size_t GetNumberOfEntries() const {return fEntries.size();}
+    G4double GetTransmission() const;
+
+  private:
+    G4bool Trace(Entry& entry) const;
+
+  private:
+    static const G4double fTolerance;
+    static const G4double fNormalTolerance;
+    // Histories still bouncing after these steps are discarded
+    static const G4int fMaxSteps = 1000000;
+
+    G4VPhysicalVolume* fBore[2];
+    const G4CutTubs* fSolid[2];
+    G4AffineTransform fToGlobal[2];
+    G4AffineTransform fToLocal[2];
+    G4int fWallZ;
+
+    // Solid and placement parameters of the envelopes
+    std::vector<G4double> fGeometryKey;
+
+    std::vector<Entry> fEntries;
+};
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+#endif
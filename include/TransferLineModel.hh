@@ -0,0 +1,69 @@
+//
+// ********************************************************************
+// * License and Disclaimer                                           *
+// *                                                                  *
+// * The  Geant4 software  is  copyright of the Copyright Holders  of *
+// * the Geant4 Collaboration.  It is provided  under  the terms  and *
+// * conditions of the Geant4 Software License,  included in the file *
+// * LICENSE and available at  http://cern.ch/geant4/license .  These *
+// * include a list of copyright holders.                             *
+// *                                                                  *
+// * Neither the authors of this software system, nor their employing *
+// * institutes,nor the agencies providing financial support for this *
+// * work  make  any representation or  warranty, express or implied, *
+// * regarding  this  software system or assume any liability for its *
+// * use.  Please see the license in the file  LICENSE  and URL above *
+// * for the full disclaimer and the limitation of liability.         *
+// *                                                                  *
+// * This  code  implementation is the result of  the  scientific and *
+// * technical work of the GEANT4 collaboration.                      *
+// * By using,  copying,  modifying or  distributing the software (or *
+// * any work based  on the software)  you  agree  to acknowledge its *
+// * use  in  resulting  scientific  publications,  and indicate your *
+// * acceptance of all terms of the Geant4 Software license.          *
+// ********************************************************************
+//
+//
+/// \file TransferLineModel.hh
+/// \brief Definition of the TransferLineModel class
+
+#ifndef TransferLineModel_h
+#define TransferLineModel_h 1
+
+#include "G4VFastSimulationModel.hh"
+#include "TransferLineKernel.hh"
+
+/// TransferLineModel class
+///
+/// Fast simulation of the transfer line: an ion entering the bore from
+/// the target box is moved at once to the exit of a history sampled from
+/// the TransferLineKernel, with the elapsed time computed from its own
+/// velocity and from the adsorption time on the tube walls. The elapsed
+/// time is passed to the biasing operator as sticking time, so that the
+/// decay during the transit is accounted for.
+/// The kernel is read from file by each thread at the first use, without
+/// a valid kernel the detailed tracking is used.
+
+class TransferLineModel : public G4VFastSimulationModel
+{
+  public:
+    TransferLineModel(const G4String& modelName,
+                      G4Region* envelope,
+                      const G4String& kernelFile);
+    ~TransferLineModel();
+
+    virtual G4bool IsApplicable(const G4ParticleDefinition&);
+    virtual G4bool ModelTrigger(const G4FastTrack&);
+    virtual void DoIt(const G4FastTrack&, G4FastStep&);
+
+  private:
+    TransferLineKernel fKernel;
+    G4String fKernelFile;
+    G4bool bLoaded;
+    G4bool bReady;
+    G4int fEffusionID;
+};
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+#endif
@@ -0,0 +1,87 @@
+//
+// ********************************************************************
+// * License and Disclaimer                                           *
+// *                                                                  *
+// * The  Geant4 software  is  copyright of the Copyright Holders  of *
+// * the Geant4 Collaboration.  It is provided  under  the terms  and *
+// * conditions of the Geant4 Software License,  included in the file *
+// * LICENSE and available at  http://cern.ch/geant4/license .  These *
+// * include a list of copyright holders.                             *
+// *                                                                  *
+// * Neither the authors of this software system, nor their employing *
+// * institutes,nor the agencies providing financial support for this *
+// * work  make  any representation or  warranty, express or implied, *
+// * regarding  this  software system or assume any liability for its *
+// * use.  Please see the license in the file  LICENSE  and URL above *
+// * for the full disclaimer and the limitation of liability.         *
+// *                                                                  *
+// * This  code  implementation is the result of  the  scientific and *
+// * technical work of the GEANT4 collaboration.                      *
+// * By using,  copying,  modifying or  distributing the software (or *
+// * any work based  on the software)  you  agree  to acknowledge its *
+// * use  in  resulting  scientific  publications,  and indicate your *
+// * acceptance of all terms of the Geant4 Software license.          *
+// ********************************************************************
+//
+//
+/// \file VertexFile.hh
+/// \brief Definition of the VertexFile class
+
+#ifndef VertexFile_h
+#define VertexFile_h 1
+
+#include "globals.hh"
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/// VertexFile class
+///
+/// Birth vertices of the nuclei of one isotope code (see Run::GetCode())
+/// recorded by the production stage: position, time and weight of the
+/// first step in the disk. The file is a fixed header followed by an
+/// array of fixed size records, the release stage maps it in memory and
+/// reads the records in place without any parsing.
+
+class VertexFile
+{
+  public:
+    // Layout (native byte order):
+    //   char[8] "EFF10VTX", int32 version, int32 code, int64 n,
+    //   n x (float position[3] [mm], float weight, double time [ns])
+    struct Record {
+        float fPosition[3];
+        float fWeight;
+        G4double fTime;
+    };
+
+  public:
+    VertexFile();
+    ~VertexFile();
+
+    // Append the records to the file, a new file is created if missing or
+    // if truncate is true. False if the file holds another isotope code
+    static G4bool Append(const G4String& fileName,G4int code,
+                         const std::vector<Record>& records,G4bool truncate);
+
+    // Map the file read-only, the previous mapping is released
+    G4bool Open(const G4String& fileName);
+    void Close();
+
+    G4bool IsOpen() const {return fRecords != nullptr;}
+    G4int GetCode() const {return fCode;}
+    G4long GetNumberOfRecords() const {return fEntries;}
+    const Record& GetRecord(G4long i) const {return fRecords[i];}
+
+  private:
+    void* fMapping;
+    std::size_t fSize;
+    const Record* fRecords;
+    G4long fEntries;
+    G4int fCode;
+};
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+#endif
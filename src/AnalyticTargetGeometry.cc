@@ -0,0 +1,473 @@
+//
+// ********************************************************************
+// * License and Disclaimer                                           *
+// *                                                                  *
+// * The  Geant4 software  is  copyright of the Copyright Holders  of *
+// * the Geant4 Collaboration.  It is provided  under  the terms  and *
+// * conditions of the Geant4 Software License,  included in the file *
+// * LICENSE and available at  http://cern.ch/geant4/license .  These *
+// * include a list of copyright holders.                             *
+// *                                                                  *
+// * Neither the authors of this software system, nor their employing *
+// * institutes,nor the agencies providing financial support for this *
+// * work  make  any representation or  warranty, express or implied, *
+// * regarding  this  software system or assume any liability for its *
+// * use.  Please see the license in the file  LICENSE  and URL above *
+// * for the full disclaimer and the limitation of liability.         *
+// *                                                                  *
+// * This  code  implementation is the result of  the  scientific and *
+// * technical work of the GEANT4 collaboration.                      *
+// * By using,  copying,  modifying or  distributing the software (or *
+// * any work based  on the software)  you  agree  to acknowledge its *
+// * use  in  resulting  scientific  publications,  and indicate your *
+// * acceptance of all terms of the Geant4 Software license.          *
+// ********************************************************************
+//
+//
+/// \file AnalyticTargetGeometry.cc
+/// \brief Implementation of the AnalyticTargetGeometry class
+
+#include "AnalyticTargetGeometry.hh"
+
+#include "G4TransportationManager.hh"
+#include "G4Navigator.hh"
+#include "G4VPhysicalVolume.hh"
+#include "G4LogicalVolume.hh"
+#include "G4AffineTransform.hh"
+#include "G4Tubs.hh"
+#include "G4CutTubs.hh"
+#include "G4Box.hh"
+#include "G4SubtractionSolid.hh"
+#include "G4DisplacedSolid.hh"
+#include "G4Material.hh"
+#include "G4Element.hh"
+#include "G4PhysicalConstants.hh"
+#include "G4SystemOfUnits.hh"
+
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+
+// Maximum number of shapes subtracted from a solid
+#define MAX_HOLE_NUMBER 4
+
+// Tolerance on the surfaces and on the distances
+const G4double AnalyticTargetGeometry::fTolerance = 1.e-9 * CLHEP::mm;
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+AnalyticTargetGeometry::AnalyticTargetGeometry(){}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+AnalyticTargetGeometry::~AnalyticTargetGeometry(){}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+G4bool AnalyticTargetGeometry::MakeShape(const G4VSolid* solid,
+                                         const G4AffineTransform& toLocal,
+                                         Shape& shape){
+    G4ThreeVector lowNorm(0.,0.,-1.);
+    G4ThreeVector highNorm(0.,0.,1.);
+    
+    if(const G4CutTubs* cutTubs = dynamic_cast<const G4CutTubs*>(solid)){
+        if(cutTubs->GetDeltaPhiAngle() < CLHEP::twopi - 1.e-9) return false;
+        shape.fType = kTube;
+        shape.fRmin = cutTubs->GetInnerRadius();
+        shape.fRmax = cutTubs->GetOuterRadius();
+        shape.fDz = cutTubs->GetZHalfLength();
+        lowNorm = cutTubs->GetLowNorm();
+        highNorm = cutTubs->GetHighNorm();
+    }
+    else if(const G4Tubs* tubs = dynamic_cast<const G4Tubs*>(solid)){
+        if(tubs->GetDeltaPhiAngle() < CLHEP::twopi - 1.e-9) return false;
+        shape.fType = kTube;
+        shape.fRmin = tubs->GetInnerRadius();
+        shape.fRmax = tubs->GetOuterRadius();
+        shape.fDz = tubs->GetZHalfLength();
+    }
+    else if(const G4Box* box = dynamic_cast<const G4Box*>(solid)){
+        shape.fType = kBox;
+        shape.fHalf[0] = box->GetXHalfLength();
+        shape.fHalf[1] = box->GetYHalfLength();
+        shape.fHalf[2] = box->GetZHalfLength();
+    }
+    else{
+        return false;
+    }
+    
+    for(G4int i0=0;i0<3;i0++){
+        shape.fLowNorm[i0] = lowNorm[i0];
+        shape.fHighNorm[i0] = highNorm[i0];
+    }
+    
+    // Columns of the rotation from the transformed axes
+    G4ThreeVector translation = toLocal.TransformPoint(G4ThreeVector());
+    for(G4int i0=0;i0<3;i0++){
+        G4ThreeVector axis;
+        axis[i0] = 1.;
+        G4ThreeVector column = toLocal.TransformAxis(axis);
+        for(G4int i1=0;i1<3;i1++){
+            shape.fRotation[i1*3 + i0] = column[i1];
+        }
+        shape.fTranslation[i0] = translation[i0];
+    }
+    return true;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+G4bool AnalyticTargetGeometry::Import(G4bool allVolumes){
+    fSolids.clear();
+    
+    G4VPhysicalVolume* world = G4TransportationManager::GetTransportationManager()->
+        GetNavigatorForTracking()->GetWorldVolume();
+    G4LogicalVolume* worldLogical = world->GetLogicalVolume();
+    
+    for(size_t i0=0;i0<worldLogical->GetNoDaughters();i0++){
+        G4VPhysicalVolume* volume = worldLogical->GetDaughter(i0);
+        G4LogicalVolume* logical = volume->GetLogicalVolume();
+        
+        Solid solid;
+        solid.fVolume = volume;
+        solid.bDetector = (logical->GetName() == "Detector.Logic");
+        if(!allVolumes && !solid.bDetector &&
+           logical->GetMaterial() == worldLogical->GetMaterial()) continue;
+        
+        const G4ElementVector* theElementVector = logical->GetMaterial()->GetElementVector();
+        solid.fMaterialZ = G4int(std::round((*theElementVector)[0]->GetZ()));
+        
+        G4AffineTransform toLocal =
+            G4AffineTransform(volume->GetRotation(),volume->GetTranslation()).Inverse();
+        
+        G4bool supported = false;
+        const G4VSolid* base = logical->GetSolid();
+        std::vector<const G4VSolid*> holes;
+        while(const G4SubtractionSolid* subtraction = dynamic_cast<const G4SubtractionSolid*>(base)){
+            holes.push_back(subtraction->GetConstituentSolid(1));
+            base = subtraction->GetConstituentSolid(0);
+        }
+        if(MakeShape(base,toLocal,solid.fShape) && holes.size() <= MAX_HOLE_NUMBER){
+            supported = true;
+            for(auto hole : holes){
+                Shape shape;
+                G4AffineTransform toHole;
+                if(const G4DisplacedSolid* displaced = dynamic_cast<const G4DisplacedSolid*>(hole)){
+                    toHole = displaced->GetTransform();
+                    hole = displaced->GetConstituentMovedSolid();
+                }
+                supported = supported && MakeShape(hole,toHole,shape);
+                solid.fHoles.push_back(shape);
+            }
+        }
+        
+        if(!supported){
+            G4ExceptionDescription ed;
+            ed << "Solid of the volume `" << volume->GetName()
+            << "' not supported by the analytic geometry." << G4endl;
+            G4Exception("AnalyticTargetGeometry::Import",
+                        "eff0007",
+                        JustWarning,
+                        ed);
+            fSolids.clear();
+            return false;
+        }
+        fSolids.push_back(solid);
+    }
+    return true;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void AnalyticTargetGeometry::Transform(const Shape& shape,
+                                       const G4double p[3],const G4double d[3],
+                                       G4double lp[3],G4double ld[3]){
+    const G4double* r = shape.fRotation;
+    for(G4int i0=0;i0<3;i0++){
+        lp[i0] = r[i0*3] * p[0] + r[i0*3+1] * p[1] + r[i0*3+2] * p[2] + shape.fTranslation[i0];
+        ld[i0] = r[i0*3] * d[0] + r[i0*3+1] * d[1] + r[i0*3+2] * d[2];
+    }
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+G4bool AnalyticTargetGeometry::Inside(const Shape& shape,const G4double p[3]){
+    if(shape.fType == kBox){
+        return std::fabs(p[0]) <= shape.fHalf[0] &&
+            std::fabs(p[1]) <= shape.fHalf[1] &&
+            std::fabs(p[2]) <= shape.fHalf[2];
+    }
+    
+    G4double r2 = p[0] * p[0] + p[1] * p[1];
+    const G4double* l = shape.fLowNorm;
+    const G4double* h = shape.fHighNorm;
+    return r2 <= shape.fRmax * shape.fRmax && r2 >= shape.fRmin * shape.fRmin &&
+        p[0] * l[0] + p[1] * l[1] + p[2] * l[2] + shape.fDz * l[2] <= 0. &&
+        p[0] * h[0] + p[1] * h[1] + p[2] * h[2] - shape.fDz * h[2] <= 0.;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+G4int AnalyticTargetGeometry::Crossings(const Shape& shape,
+                                        const G4double p[3],const G4double d[3],
+                                        G4double t[],G4double n[][3]){
+    G4int count = 0;
+    
+    if(shape.fType == kBox){
+        for(G4int i0=0;i0<3;i0++){
+            if(d[i0] == 0.) continue;
+            for(G4int side=-1;side<=1;side+=2){
+                G4double tc = (side * shape.fHalf[i0] - p[i0]) / d[i0];
+                G4bool onFace = true;
+                for(G4int i1=0;i1<3;i1++){
+                    if(i1 == i0) continue;
+                    onFace = onFace && std::fabs(p[i1] + tc * d[i1]) <= shape.fHalf[i1] + fTolerance;
+                }
+                if(!onFace) continue;
+                t[count] = tc;
+                n[count][0] = n[count][1] = n[count][2] = 0.;
+                n[count][i0] = side;
+                count++;
+            }
+        }
+        return count;
+    }
+    
+    const G4double* l = shape.fLowNorm;
+    const G4double* h = shape.fHighNorm;
+    const G4double pLow = p[0] * l[0] + p[1] * l[1] + p[2] * l[2] + shape.fDz * l[2];
+    const G4double dLow = d[0] * l[0] + d[1] * l[1] + d[2] * l[2];
+    const G4double pHigh = p[0] * h[0] + p[1] * h[1] + p[2] * h[2] - shape.fDz * h[2];
+    const G4double dHigh = d[0] * h[0] + d[1] * h[1] + d[2] * h[2];
+    
+    // Cylinders, the inner one with the normal towards the axis
+    const G4double a = d[0] * d[0] + d[1] * d[1];
+    const G4double b = p[0] * d[0] + p[1] * d[1];
+    const G4double r2 = p[0] * p[0] + p[1] * p[1];
+    const G4double radius[2] = {shape.fRmax,shape.fRmin};
+    for(G4int i0=0;i0<2 && a > 0.;i0++){
+        if(radius[i0] <= 0.) continue;
+        G4double disc = b * b - a * (r2 - radius[i0] * radius[i0]);
+        if(disc < 0.) continue;
+        G4double s = std::sqrt(disc);
+        for(G4int side=-1;side<=1;side+=2){
+            G4double tc = (-b + side * s) / a;
+            if(pLow + tc * dLow > fTolerance || pHigh + tc * dHigh > fTolerance) continue;
+            G4double sign = (i0 == 0) ? 1. : -1.;
+            t[count] = tc;
+            n[count][0] = sign * (p[0] + tc * d[0]) / radius[i0];
+            n[count][1] = sign * (p[1] + tc * d[1]) / radius[i0];
+            n[count][2] = 0.;
+            count++;
+        }
+    }
+    
+    // Cuts
+    const G4double rmax2 = shape.fRmax * shape.fRmax + fTolerance;
+    const G4double rmin2 = shape.fRmin * shape.fRmin - fTolerance;
+    if(dLow != 0.){
+        G4double tc = - pLow / dLow;
+        G4double x = p[0] + tc * d[0];
+        G4double y = p[1] + tc * d[1];
+        if(x * x + y * y <= rmax2 && x * x + y * y >= rmin2 && pHigh + tc * dHigh <= fTolerance){
+            t[count] = tc;
+            n[count][0] = l[0];
+            n[count][1] = l[1];
+            n[count][2] = l[2];
+            count++;
+        }
+    }
+    if(dHigh != 0.){
+        G4double tc = - pHigh / dHigh;
+        G4double x = p[0] + tc * d[0];
+        G4double y = p[1] + tc * d[1];
+        if(x * x + y * y <= rmax2 && x * x + y * y >= rmin2 && pLow + tc * dLow <= fTolerance){
+            t[count] = tc;
+            n[count][0] = h[0];
+            n[count][1] = h[1];
+            n[count][2] = h[2];
+            count++;
+        }
+    }
+    return count;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+G4bool AnalyticTargetGeometry::DistanceToIn(const Solid& solid,
+                                            const G4double p[3],const G4double d[3],
+                                            G4double& distance,G4double normal[3]) const{
+    // Up to 6 crossings per shape
+    G4double t[6 * (MAX_HOLE_NUMBER + 1)];
+    G4double n[6 * (MAX_HOLE_NUMBER + 1)][3];
+    
+    G4double lp[3], ld[3];
+    Transform(solid.fShape,p,d,lp,ld);
+    G4int count = Crossings(solid.fShape,lp,ld,t,n);
+    
+    G4double hp[MAX_HOLE_NUMBER][3], hd[MAX_HOLE_NUMBER][3];
+    for(size_t i0=0;i0<solid.fHoles.size();i0++){
+        const Shape& hole = solid.fHoles[i0];
+        Transform(hole,lp,ld,hp[i0],hd[i0]);
+        G4int first = count;
+        count += Crossings(hole,hp[i0],hd[i0],t + first,n + first);
+        // Back to the frame of the solid, pointing into the hole
+        const G4double* r = hole.fRotation;
+        for(G4int i1=first;i1<count;i1++){
+            G4double m[3];
+            for(G4int i2=0;i2<3;i2++){
+                m[i2] = - (r[i2] * n[i1][0] + r[3+i2] * n[i1][1] + r[6+i2] * n[i1][2]);
+            }
+            n[i1][0] = m[0];
+            n[i1][1] = m[1];
+            n[i1][2] = m[2];
+        }
+    }
+    
+    // First crossing followed by a point of the solid
+    const G4double step = 1.e3 * fTolerance;
+    G4int entry = -1;
+    for(G4int i0=0;i0<count;i0++){
+        if(t[i0] <= fTolerance) continue;
+        if(entry >= 0 && t[i0] >= t[entry]) continue;
+        G4double q[3];
+        for(G4int i1=0;i1<3;i1++) q[i1] = lp[i1] + (t[i0] + step) * ld[i1];
+        G4bool inside = Inside(solid.fShape,q);
+        for(size_t i1=0;inside && i1<solid.fHoles.size();i1++){
+            G4double hq[3];
+            for(G4int i2=0;i2<3;i2++) hq[i2] = hp[i1][i2] + (t[i0] + step) * hd[i1][i2];
+            inside = !Inside(solid.fHoles[i1],hq);
+        }
+        if(inside) entry = i0;
+    }
+    if(entry < 0) return false;
+    
+    distance = t[entry];
+    const G4double* r = solid.fShape.fRotation;
+    for(G4int i0=0;i0<3;i0++){
+        normal[i0] = r[i0] * n[entry][0] + r[3+i0] * n[entry][1] + r[6+i0] * n[entry][2];
+    }
+    return true;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void AnalyticTargetGeometry::IntersectTube(size_t index,size_t n,
+                                           const G4double* x,const G4double* y,const G4double* z,
+                                           const G4double* u,const G4double* v,const G4double* w,
+                                           G4double* distance,G4int* hit,
+                                           G4double* nx,G4double* ny,G4double* nz) const{
+    const Shape& shape = fSolids[index].fShape;
+    const G4double* r = shape.fRotation;
+    const G4double* c = shape.fTranslation;
+    const G4double* l = shape.fLowNorm;
+    const G4double* h = shape.fHighNorm;
+    const G4double rmax2 = shape.fRmax * shape.fRmax;
+    const G4double rmin2 = shape.fRmin * shape.fRmin;
+    const G4double irmax = 1. / shape.fRmax;
+    const G4double irmin = shape.fRmin > 0. ? 1. / shape.fRmin : 0.;
+    const G4double lowOffset = shape.fDz * l[2];
+    const G4double highOffset = - shape.fDz * h[2];
+    const G4double tol = fTolerance;
+    const G4double big = DBL_MAX;
+    const G4int solid = G4int(index);
+    
+    // No branches apart from the selections, one lane per ray
+    for(size_t k=0;k<n;k++){
+        const G4double px = r[0] * x[k] + r[1] * y[k] + r[2] * z[k] + c[0];
+        const G4double py = r[3] * x[k] + r[4] * y[k] + r[5] * z[k] + c[1];
+        const G4double pz = r[6] * x[k] + r[7] * y[k] + r[8] * z[k] + c[2];
+        const G4double dx = r[0] * u[k] + r[1] * v[k] + r[2] * w[k];
+        const G4double dy = r[3] * u[k] + r[4] * v[k] + r[5] * w[k];
+        const G4double dz = r[6] * u[k] + r[7] * v[k] + r[8] * w[k];
+        
+        const G4double a = dx * dx + dy * dy;
+        const G4double b = px * dx + py * dy;
+        const G4double r2 = px * px + py * py;
+        const G4double ia = 1. / (a > 0. ? a : 1.);
+        const G4double pLow = px * l[0] + py * l[1] + pz * l[2] + lowOffset;
+        const G4double dLow = dx * l[0] + dy * l[1] + dz * l[2];
+        const G4double pHigh = px * h[0] + py * h[1] + pz * h[2] + highOffset;
+        const G4double dHigh = dx * h[0] + dy * h[1] + dz * h[2];
+        
+        // Outer cylinder from outside, inner cylinder from the bore
+        const G4double discOut = b * b - a * (r2 - rmax2);
+        const G4double tOut = (-b - std::sqrt(std::max(discOut,0.))) * ia;
+        const G4bool okOut = a > 0. && discOut >= 0. && tOut > tol &&
+            pLow + tOut * dLow <= tol && pHigh + tOut * dHigh <= tol;
+        const G4double discIn = b * b - a * (r2 - rmin2);
+        const G4double tIn = (-b + std::sqrt(std::max(discIn,0.))) * ia;
+        const G4bool okIn = rmin2 > 0. && a > 0. && discIn >= 0. && tIn > tol &&
+            pLow + tIn * dLow <= tol && pHigh + tIn * dHigh <= tol;
+        
+        // Cuts, entered moving against the outward normal
+        const G4double tLow = - pLow / (dLow < 0. ? dLow : -1.);
+        const G4double xLow = px + tLow * dx;
+        const G4double yLow = py + tLow * dy;
+        const G4double rLow = xLow * xLow + yLow * yLow;
+        const G4bool okLow = dLow < 0. && tLow > tol && rLow <= rmax2 && rLow >= rmin2 &&
+            pHigh + tLow * dHigh <= tol;
+        const G4double tHigh = - pHigh / (dHigh < 0. ? dHigh : -1.);
+        const G4double xHigh = px + tHigh * dx;
+        const G4double yHigh = py + tHigh * dy;
+        const G4double rHigh = xHigh * xHigh + yHigh * yHigh;
+        const G4bool okHigh = dHigh < 0. && tHigh > tol && rHigh <= rmax2 && rHigh >= rmin2 &&
+            pLow + tHigh * dLow <= tol;
+        
+        const G4double t1 = okOut ? tOut : big;
+        const G4double t2 = okIn ? tIn : big;
+        const G4double t3 = okLow ? tLow : big;
+        const G4double t4 = okHigh ? tHigh : big;
+        const G4double t = std::min(std::min(t1,t2),std::min(t3,t4));
+        
+        // Local outward normal of the surface entered
+        const G4double qx = px + t * dx;
+        const G4double qy = py + t * dy;
+        const G4double lnx = t == t1 ? qx * irmax : t == t2 ? - qx * irmin : t == t3 ? l[0] : h[0];
+        const G4double lny = t == t1 ? qy * irmax : t == t2 ? - qy * irmin : t == t3 ? l[1] : h[1];
+        const G4double lnz = t == t1 ? 0. : t == t2 ? 0. : t == t3 ? l[2] : h[2];
+        
+        const G4bool closer = t < distance[k];
+        distance[k] = closer ? t : distance[k];
+        hit[k] = closer ? solid : hit[k];
+        nx[k] = closer ? r[0] * lnx + r[3] * lny + r[6] * lnz : nx[k];
+        ny[k] = closer ? r[1] * lnx + r[4] * lny + r[7] * lnz : ny[k];
+        nz[k] = closer ? r[2] * lnx + r[5] * lny + r[8] * lnz : nz[k];
+    }
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void AnalyticTargetGeometry::Intersect(size_t n,
+                                       const G4double* x,const G4double* y,const G4double* z,
+                                       const G4double* u,const G4double* v,const G4double* w,
+                                       G4double* distance,G4int* hit,
+                                       G4double* nx,G4double* ny,G4double* nz) const{
+    for(size_t k=0;k<n;k++){
+        distance[k] = DBL_MAX;
+        hit[k] = -1;
+    }
+    
+    for(size_t i0=0;i0<fSolids.size();i0++){
+        const Solid& solid = fSolids[i0];
+        if(solid.fShape.fType == kTube && solid.fHoles.empty()){
+            IntersectTube(i0,n,x,y,z,u,v,w,distance,hit,nx,ny,nz);
+            continue;
+        }
+        for(size_t k=0;k<n;k++){
+            G4double p[3] = {x[k],y[k],z[k]};
+            G4double d[3] = {u[k],v[k],w[k]};
+            G4double t = 0.;
+            G4double normal[3];
+            if(DistanceToIn(solid,p,d,t,normal) && t < distance[k]){
+                distance[k] = t;
+                hit[k] = G4int(i0);
+                nx[k] = normal[0];
+                ny[k] = normal[1];
+                nz[k] = normal[2];
+            }
+        }
+    }
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
@@ -0,0 +1,299 @@
+//
+// ********************************************************************
+// * License and Disclaimer                                           *
+// *                                                                  *
+// * The  Geant4 software  is  copyright of the Copyright Holders  of *
+// * the Geant4 Collaboration.  It is provided  under  the terms  and *
+// * conditions of the Geant4 Software License,  included in the file *
+// * LICENSE and available at  http://cern.ch/geant4/license .  These *
+// * include a list of copyright holders.                             *
+// *                                                                  *
+// * Neither the authors of this software system, nor their employing *
+// * institutes,nor the agencies providing financial support for this *
+// * work  make  any representation or  warranty, express or implied, *
+// * regarding  this  software system or assume any liability for its *
+// * use.  Please see the license in the file  LICENSE  and URL above *
+// * for the full disclaimer and the limitation of liability.         *
+// *                                                                  *
+// * This  code  implementation is the result of  the  scientific and *
+// * technical work of the GEANT4 collaboration.                      *
+// * By using,  copying,  modifying or  distributing the software (or *
+// * any work based  on the software)  you  agree  to acknowledge its *
+// * use  in  resulting  scientific  publications,  and indicate your *
+// * acceptance of all terms of the Geant4 Software license.          *
+// ********************************************************************
+//
+//
+/// \file BallisticTransportation.cc
+/// \brief Implementation of the BallisticTransportation class
+
+#include "BallisticTransportation.hh"
+
+#include "G4TransportationManager.hh"
+#include "G4Navigator.hh"
+#include "G4VPhysicalVolume.hh"
+#include "G4LogicalVolume.hh"
+#include "G4VSolid.hh"
+#include "G4TouchableHistory.hh"
+#include "G4PhysicsModelCatalog.hh"
+#include "G4ProcessManager.hh"
+#include "G4ProcessVector.hh"
+#include "G4BiasingProcessInterface.hh"
+#include "G4EventManager.hh"
+#include "G4TrackingManager.hh"
+#include "G4SteppingManager.hh"
+#include "EffusionProcess.hh"
+#include "G4SystemOfUnits.hh"
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+BallisticTransportation::BallisticTransportation(G4int verbosityLevel):
+G4Transportation(verbosityLevel),
+bImported(false),
+bAvailable(false),
+fWorld(0),
+fNavigator(0),
+bBallisticStep(false),
+bGeometryLimitedStep(false),
+bSurfaceHit(false),
+bBallisticMoved(false),
+fSteppingManager(0),
+fLastDefinition(0),
+fLastEffusionIndex(-1),
+bActive(false),
+fEnergyThreshold(1. * CLHEP::keV){
+    fEffusionID = G4PhysicsModelCatalog::GetIndex("effusion");
+    if(fEffusionID == -1){
+        fEffusionID = G4PhysicsModelCatalog::Register("effusion");
+    }
+    
+    fMessenger = new G4GenericMessenger(this,
+                                        "/ballistic/",
+                                        "Ballistic transportation of the thermal ions" );
+    fMessenger->DeclareProperty("setActive", bActive,
+                                "use the analytic steps in the world volume, off by default" );
+    fMessenger->DeclarePropertyWithUnit("setEnergyThreshold", "eV", fEnergyThreshold,
+                                        "maximum kinetic energy of the ballistic ions" );
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+BallisticTransportation::~BallisticTransportation(){
+    delete fMessenger;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void BallisticTransportation::StartTracking(G4Track* track){
+    G4Transportation::StartTracking(track);
+    bBallisticMoved = false;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+EffusionTrackData* BallisticTransportation::GetTrackData(const G4Track& track){
+    EffusionTrackData* trackdata =
+    (EffusionTrackData*)(track.GetAuxiliaryTrackInformation(fEffusionID));
+    if(trackdata == nullptr){
+        trackdata = new EffusionTrackData();
+        track.SetAuxiliaryTrackInformation(fEffusionID,trackdata);
+    }
+    return trackdata;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+G4bool BallisticTransportation::IsBallistic(const G4Track& track){
+    if(!bActive) return false;
+    if(track.GetKineticEnergy() >= fEnergyThreshold) return false;
+    
+    // Only in the world, the volume of the vacuum surrounding the target
+    const G4VPhysicalVolume* volume = track.GetVolume();
+    if(volume == 0 || volume->GetMotherLogical() != 0) return false;
+    
+    if(!bImported){
+        fNavigator = G4TransportationManager::GetTransportationManager()->GetNavigatorForTracking();
+        fWorld = fNavigator->GetWorldVolume();
+        bAvailable = fGeometry.Import(true);
+        bImported = true;
+    }
+    return bAvailable;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+G4double BallisticTransportation::
+AlongStepGetPhysicalInteractionLength(const G4Track& track,
+                                      G4double previousStepSize,
+                                      G4double currentMinimumStep,
+                                      G4double& currentSafety,
+                                      G4GPILSelection* selection){
+    bBallisticStep = IsBallistic(track);
+    if(!bBallisticStep){
+        // The safety sphere and the touchable of G4Transportation date
+        // from before the ballistic steps, they are restarted from the
+        // volume where the track has been located
+        if(bBallisticMoved){
+            G4Transportation::StartTracking(const_cast<G4Track*>(&track));
+            bBallisticMoved = false;
+        }
+        return G4Transportation::AlongStepGetPhysicalInteractionLength(track,
+                                                                       previousStepSize,
+                                                                       currentMinimumStep,
+                                                                       currentSafety,
+                                                                       selection);
+    }
+    
+    *selection = CandidateForSelection;
+    currentSafety = 0.;
+    
+    const G4ThreeVector& position = track.GetPosition();
+    const G4ThreeVector& direction = track.GetMomentumDirection();
+    G4double x = position.x(), y = position.y(), z = position.z();
+    G4double u = direction.x(), v = direction.y(), w = direction.z();
+    G4double distance = 0.;
+    G4int hit = -1;
+    G4double nx = 0., ny = 0., nz = 0.;
+    fGeometry.Intersect(1,&x,&y,&z,&u,&v,&w,&distance,&hit,&nx,&ny,&nz);
+    
+    // The world is placed at the origin without rotation
+    G4double worldDistance = fWorld->GetLogicalVolume()->GetSolid()->DistanceToOut(position,direction);
+    bSurfaceHit = (hit >= 0 && distance < worldDistance);
+    if(!bSurfaceHit){
+        distance = worldDistance;
+    }
+    fSurfaceNormal.set(nx,ny,nz);
+    bGeometryLimitedStep = (distance <= currentMinimumStep);
+    
+    return distance;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+G4VParticleChange* BallisticTransportation::AlongStepDoIt(const G4Track& track,
+                                                          const G4Step& stepData){
+    if(!bBallisticStep){
+        return G4Transportation::AlongStepDoIt(track,stepData);
+    }
+    
+    // Straight line at constant velocity
+    G4double stepLength = stepData.GetStepLength();
+    G4double deltaTime = stepLength / track.GetVelocity();
+    G4double deltaProperTime = deltaTime * track.GetDynamicParticle()->GetMass() / track.GetTotalEnergy();
+    
+    fBallisticChange.Initialize(track);
+    fBallisticChange.ProposePosition(track.GetPosition() + stepLength * track.GetMomentumDirection());
+    fBallisticChange.ProposeMomentumDirection(track.GetMomentumDirection());
+    fBallisticChange.ProposeEnergy(track.GetKineticEnergy());
+    fBallisticChange.ProposeLocalTime(track.GetLocalTime() + deltaTime);
+    fBallisticChange.ProposeProperTime(track.GetProperTime() + deltaProperTime);
+    fBallisticChange.ProposeTrueStepLength(stepLength);
+    return &fBallisticChange;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+G4VParticleChange* BallisticTransportation::PostStepDoIt(const G4Track& track,
+                                                         const G4Step& stepData){
+    EffusionTrackData* trackdata =
+    (EffusionTrackData*)(track.GetAuxiliaryTrackInformation(fEffusionID));
+    if(trackdata){
+        trackdata->ClearSurfaceNormal();
+    }
+    
+    G4ParticleChangeForTransport* change = bBallisticStep ? Relocate(track) :
+    static_cast<G4ParticleChangeForTransport*>(G4Transportation::PostStepDoIt(track,stepData));
+    TriggerEffusion(track,stepData,change);
+    return change;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+G4ParticleChangeForTransport* BallisticTransportation::Relocate(const G4Track& track){
+    bBallisticMoved = true;
+    fBallisticChange.Initialize(track);
+    if(!bGeometryLimitedStep){
+        // Still in the world
+        fNavigator->LocateGlobalPointWithinVolume(track.GetPosition());
+        return &fBallisticChange;
+    }
+    
+    // Full search from the world, the direction selects the volume entered
+    // when the point is on its surface
+    fNavigator->LocateGlobalPointAndSetup(track.GetPosition(),
+                                          &track.GetMomentumDirection(),
+                                          false,
+                                          false);
+    G4TouchableHandle touchable = fNavigator->CreateTouchableHistory();
+    
+    G4VPhysicalVolume* volume = touchable->GetVolume();
+    G4LogicalVolume* logical = volume ? volume->GetLogicalVolume() : 0;
+    if(volume == 0){
+        fBallisticChange.ProposeTrackStatus(fStopAndKill);
+    }
+    fBallisticChange.SetMaterialInTouchable(logical ? logical->GetMaterial() : 0);
+    fBallisticChange.SetMaterialCutsCoupleInTouchable(logical ? logical->GetMaterialCutsCouple() : 0);
+    fBallisticChange.SetSensitiveDetectorInTouchable(logical ? logical->GetSensitiveDetector() : 0);
+    fBallisticChange.SetTouchableHandle(touchable);
+    
+    if(bSurfaceHit){
+        GetTrackData(track)->SetSurfaceNormal(fSurfaceNormal);
+    }
+    return &fBallisticChange;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void BallisticTransportation::TriggerEffusion(const G4Track& track,
+                                              const G4Step& stepData,
+                                              G4ParticleChangeForTransport* change){
+    // The conditions of the surface interaction of the EffusionProcess: a
+    // step ending on a surface, not in the world, with a change of material
+    if(stepData.GetPostStepPoint()->GetStepStatus() != fGeomBoundary) return;
+    const G4VPhysicalVolume* next = change->GetTouchableHandle()->GetVolume();
+    if(next == 0 || next->GetMotherLogical() == 0) return;
+    const G4VPhysicalVolume* previous = stepData.GetPreStepPoint()->GetPhysicalVolume();
+    if(previous->GetLogicalVolume()->GetMaterial() == next->GetLogicalVolume()->GetMaterial()) return;
+    
+    G4int index = GetEffusionIndex(track.GetDefinition());
+    if(index < 0) return;
+    
+    // The transportation is the first PostStepDoIt of the step, the
+    // effusion invoked after it is forced for this step only
+    if(fSteppingManager == 0){
+        fSteppingManager = G4EventManager::GetEventManager()->GetTrackingManager()->GetSteppingManager();
+    }
+    (*fSteppingManager->GetfSelectedPostStepDoItVector())[index] = Forced;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+G4int BallisticTransportation::GetEffusionIndex(const G4ParticleDefinition* particle){
+    if(particle == fLastDefinition){
+        return fLastEffusionIndex;
+    }
+    std::unordered_map<const G4ParticleDefinition*,G4int>::iterator it =
+    fEffusionIndex.find(particle);
+    if(it == fEffusionIndex.end()){
+        // Position in the PostStepGPIL vector, the one of the conditions
+        // selected by the stepping manager
+        G4int index = -1;
+        G4ProcessVector* processes = particle->GetProcessManager()->GetPostStepProcessVector(typeGPIL);
+        for(G4int i0=0;i0<G4int(processes->size()) && index < 0;i0++){
+            G4VProcess* process = (*processes)[i0];
+            G4BiasingProcessInterface* wrapper = dynamic_cast<G4BiasingProcessInterface*>(process);
+            if(wrapper && wrapper->GetWrappedProcess()){
+                process = wrapper->GetWrappedProcess();
+            }
+            if(dynamic_cast<EffusionProcess*>(process)){
+                index = i0;
+            }
+        }
+        it = fEffusionIndex.insert({particle,index}).first;
+    }
+    fLastDefinition = particle;
+    fLastEffusionIndex = it->second;
+    return fLastEffusionIndex;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
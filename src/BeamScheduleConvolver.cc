@@ -0,0 +1,291 @@
+//
+// ********************************************************************
+// * License and Disclaimer                                           *
+// *                                                                  *
+// * The  Geant4 software  is  copyright of the Copyright Holders  of *
+// * the Geant4 Collaboration.  It is provided  under  the terms  and *
+// * conditions of the Geant4 Software License,  included in the file *
+// * LICENSE and available at  http://cern.ch/geant4/license .  These *
+// * include a list of copyright holders.                             *
+// *                                                                  *
+// * Neither the authors of this software system, nor their employing *
+// * institutes,nor the agencies providing financial support for this *
+// * work  make  any representation or  warranty, express or implied, *
+// * regarding  this  software system or assume any liability for its *
+// * use.  Please see the license in the file  LICENSE  and URL above *
+// * for the full disclaimer and the limitation of liability.         *
+// *                                                                  *
+// * This  code  implementation is the result of  the  scientific and *
+// * technical work of the GEANT4 collaboration.                      *
+// * By using,  copying,  modifying or  distributing the software (or *
+// * any work based  on the software)  you  agree  to acknowledge its *
+// * use  in  resulting  scientific  publications,  and indicate your *
+// * acceptance of all terms of the Geant4 Software license.          *
+// ********************************************************************
+//
+//
+/// \file BeamScheduleConvolver.cc
+/// \brief Implementation of the BeamScheduleConvolver class
+
+#include "BeamScheduleConvolver.hh"
+#include "Run.hh"
+
+#include "G4IonTable.hh"
+#include "G4ParticleDefinition.hh"
+#include "G4SystemOfUnits.hh"
+
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <iomanip>
+#include <sstream>
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+BeamScheduleConvolver::BeamScheduleConvolver():
+fRun(0),
+fTimeStep(0.1 * CLHEP::s),
+fNumberOfSteps(10000),
+bApplyDecay(false),
+fOutputPrefix("schedule"){
+    fMessenger = new G4GenericMessenger(this,
+                                        "/schedule/",
+                                        "Convolution of the release with beam schedules" );
+    
+    fMessenger->DeclareMethod("addConstant", &BeamScheduleConvolver::AddConstant,
+                              "add constant beam name" ).SetToBeBroadcasted(false);
+    fMessenger->DeclareMethod("addPulsed", &BeamScheduleConvolver::AddPulsed,
+                              "add pulsed beam name;period_s;pulse_width_s" ).SetToBeBroadcasted(false);
+    fMessenger->DeclareMethod("addOnOff", &BeamScheduleConvolver::AddOnOff,
+                              "add on/off beam name;on_s;off_s" ).SetToBeBroadcasted(false);
+    fMessenger->DeclareMethod("addRamp", &BeamScheduleConvolver::AddRamp,
+                              "add beam ramped to full intensity name;ramp_s" ).SetToBeBroadcasted(false);
+    fMessenger->DeclareMethod("clear", &BeamScheduleConvolver::ClearSchedules,
+                              "remove all the schedules" ).SetToBeBroadcasted(false);
+    fMessenger->DeclarePropertyWithUnit("setTimeStep", "s", fTimeStep,
+                                        "time step of the output" ).SetToBeBroadcasted(false);
+    fMessenger->DeclareProperty("setNumberOfSteps", fNumberOfSteps,
+                                "number of time steps of the output" ).SetToBeBroadcasted(false);
+    fMessenger->DeclareProperty("setApplyDecay", bApplyDecay,
+                                "weight the delays with the decay, for runs without radioactive decay" ).SetToBeBroadcasted(false);
+    fMessenger->DeclareProperty("setOutputPrefix", fOutputPrefix,
+                                "prefix of the output files" ).SetToBeBroadcasted(false);
+    fMessenger->DeclareMethod("loadHistograms", &BeamScheduleConvolver::LoadHistograms,
+                              "load the histogram file of a previous run" ).SetToBeBroadcasted(false);
+    fMessenger->DeclareMethod("convolve", &BeamScheduleConvolver::Convolve,
+                              "convolve the last run with all the schedules" ).SetToBeBroadcasted(false);
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+BeamScheduleConvolver::~BeamScheduleConvolver(){
+    delete fMessenger;
+    delete fRun;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void BeamScheduleConvolver::SetRun(const Run* aRun){
+    delete fRun;
+    fRun = new Run();
+    fRun->Accumulate(aRun);
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void BeamScheduleConvolver::LoadHistograms(std::string fileName){
+    delete fRun;
+    fRun = new Run();
+    if(!fRun->ReadHistograms(fileName)){
+        G4ExceptionDescription ed;
+        ed << "Cannot read histogram file `" << fileName << "'" << G4endl;
+        G4Exception("BeamScheduleConvolver::LoadHistograms",
+                    "eff0004",
+                    JustWarning,
+                    ed);
+        delete fRun;
+        fRun = 0;
+    }
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+G4bool BeamScheduleConvolver::AddSchedule(std::string s,G4int type,size_t nParameters){
+    if (s==""){return false;}
+    const char delimiter = ';';
+    std::vector<std::string> tokens;
+    std::string token;
+    std::istringstream tokenStream(s);
+    while (std::getline(tokenStream, token, delimiter)){
+        tokens.push_back(token);
+    }
+    if(tokens.size() < nParameters + 1){return false;}
+
+    Schedule schedule;
+    schedule.fName = tokens[0];
+    schedule.fType = type;
+    schedule.fPeriod = nParameters > 0 ? std::stod(tokens[1]) * CLHEP::s : 0.;
+    schedule.fWidth = nParameters > 1 ? std::stod(tokens[2]) * CLHEP::s : 0.;
+    fSchedules.push_back(schedule);
+    return true;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void BeamScheduleConvolver::AddConstant(std::string s){
+    AddSchedule(s,kConstant,0);
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void BeamScheduleConvolver::AddPulsed(std::string s){
+    AddSchedule(s,kPulsed,2);
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void BeamScheduleConvolver::AddOnOff(std::string s){
+    // An on/off cycle is a pulse as long as the on time
+    if(AddSchedule(s,kPulsed,2)){
+        Schedule& schedule = fSchedules.back();
+        G4double on = schedule.fPeriod;
+        schedule.fPeriod = on + schedule.fWidth;
+        schedule.fWidth = on;
+    }
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void BeamScheduleConvolver::AddRamp(std::string s){
+    AddSchedule(s,kRamp,1);
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+G4double BeamScheduleConvolver::GetBeamIntegral(const Schedule& schedule,G4double time) const{
+    if(time <= 0.) return 0.;
+    
+    if(schedule.fType == kPulsed && schedule.fPeriod > 0.){
+        G4double cycles = std::floor(time / schedule.fPeriod);
+        G4double phase = time - cycles * schedule.fPeriod;
+        return cycles * schedule.fWidth + std::min(phase,schedule.fWidth);
+    }
+    if(schedule.fType == kRamp && schedule.fPeriod > 0.){
+        if(time < schedule.fPeriod){
+            return 0.5 * time * time / schedule.fPeriod;
+        }
+        return time - 0.5 * schedule.fPeriod;
+    }
+    return time;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+std::vector<G4double> BeamScheduleConvolver::GetDelayDistribution(G4int code) const{
+    std::vector<G4double> delay(fNumberOfSteps,0.);
+
+    G4double generated = fRun->GetGeneratedWeight(code);
+    if(generated <= 0.) return delay;
+    LogTimeHistogram histogram = fRun->GetArrivalTimeHistogram(code);
+
+    G4double lifetime = -1.;
+    if(bApplyDecay){
+        G4ParticleDefinition* ion = G4IonTable::GetIonTable()->GetIon(code % 1000,(code / 1000) % 1000);
+        if(ion) lifetime = ion->GetPDGLifeTime();
+    }
+    
+    G4double previous = histogram.GetIntegral(0.);
+    for(G4int i0=0;i0<fNumberOfSteps;i0++){
+        G4double integral = histogram.GetIntegral((i0 + 1) * fTimeStep);
+        delay[i0] = (integral - previous) / generated;
+        previous = integral;
+        if(lifetime > 0.){
+            delay[i0] *= std::exp(- (i0 + 0.5) * fTimeStep / lifetime);
+        }
+    }
+    return delay;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void BeamScheduleConvolver::Convolve(){
+    if(!fRun){
+        G4Exception("BeamScheduleConvolver::Convolve",
+                    "eff0004",
+                    JustWarning,
+                    "No run or histogram file to convolve.");
+        return;
+    }
+    
+    // Isotopes with at least one arrival, the ones produced only
+    // outside the disks have no generated nuclei to normalize to
+    std::vector<G4int> codes;
+    for (auto& it : fRun->fArrivalHistogram){
+        G4int code = it.first % 1000000;
+        if(fRun->GetGenerated(code) > 0) codes.push_back(code);
+    }
+    std::sort(codes.begin(),codes.end());
+    codes.erase(std::unique(codes.begin(),codes.end()),codes.end());
+    
+    std::vector<std::vector<G4double> > delays;
+    for (auto code : codes){
+        delays.push_back(GetDelayDistribution(code));
+    }
+    
+    const size_t steps = size_t(fNumberOfSteps);
+    std::vector<G4double> beam(steps);
+    std::vector<std::vector<G4double> > rates(codes.size(),std::vector<G4double>(steps));
+    
+    for (auto& schedule : fSchedules){
+        // Mean production rate in each time step
+        G4double previous = 0.;
+        for(size_t i0=0;i0<steps;i0++){
+            G4double integral = GetBeamIntegral(schedule,(i0 + 1) * fTimeStep);
+            beam[i0] = (integral - previous) / fTimeStep;
+            previous = integral;
+        }
+        
+        // Direct convolution, scattering the nuclei produced in each
+        // step: the inner loop runs over contiguous arrays and the steps
+        // without beam are skipped
+        for(size_t i1=0;i1<codes.size();i1++){
+            G4double* rate = rates[i1].data();
+            const G4double* delay = delays[i1].data();
+            std::fill(rate,rate + steps,0.);
+            for(size_t i0=0;i0<steps;i0++){
+                const G4double production = beam[i0];
+                if(production == 0.) continue;
+                G4double* out = rate + i0;
+                const size_t n = steps - i0;
+                for(size_t i2=0;i2<n;i2++){
+                    out[i2] += production * delay[i2];
+                }
+            }
+        }
+        
+        std::ofstream fFileOut;
+        G4String fileName = fOutputPrefix + "_" + schedule.fName + ".dat";
+        fFileOut.open(fileName,std::ofstream::out | std::ofstream::trunc);
+        fFileOut << "# release rate per unit production rate, schedule " << schedule.fName
+        << ", time at the center of the step" << std::endl;
+        fFileOut << "# t[s]";
+        for (auto code : codes){
+            fFileOut << " A" << (code / 1000) % 1000 << "Z" << code % 1000;
+        }
+        fFileOut << std::endl;
+        fFileOut << std::setprecision(6);
+        for(size_t i0=0;i0<steps;i0++){
+            fFileOut << (i0 + 0.5) * fTimeStep / CLHEP::s;
+            for(size_t i1=0;i1<codes.size();i1++){
+                fFileOut << " " << rates[i1][i0];
+            }
+            fFileOut << std::endl;
+        }
+        fFileOut.close();
+        
+        G4cout << "--- Schedule " << schedule.fName << ": release rates of "
+        << codes.size() << " isotopes written to " << fileName << G4endl;
+    }
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
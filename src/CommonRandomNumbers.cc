@@ -0,0 +1,293 @@
+//
+// ********************************************************************
+// * License and Disclaimer                                           *
+// *                                                                  *
+// * The  Geant4 software  is  copyright of the Copyright Holders  of *
+// * the Geant4 Collaboration.  It is provided  under  the terms  and *
+// * conditions of the Geant4 Software License,  included in the file *
+// * LICENSE and available at  http://cern.ch/geant4/license .  These *
+// * include a list of copyright holders.                             *
+// *                                                                  *
+// * Neither the authors of this software system, nor their employing *
+// * institutes,nor the agencies providing financial support for this *
+// * work  make  any representation or  warranty, express or implied, *
+// * regarding  this  software system or assume any liability for its *
+// * use.  Please see the license in the file  LICENSE  and URL above *
+// * for the full disclaimer and the limitation of liability.         *
+// *                                                                  *
+// * This  code  implementation is the result of  the  scientific and *
+// * technical work of the GEANT4 collaboration.                      *
+// * By using,  copying,  modifying or  distributing the software (or *
+// * any work based  on the software)  you  agree  to acknowledge its *
+// * use  in  resulting  scientific  publications,  and indicate your *
+// * acceptance of all terms of the Geant4 Software license.          *
+// ********************************************************************
+//
+//
+/// \file CommonRandomNumbers.cc
+/// \brief Implementation of the CommonRandomNumbers class
+
+#include "CommonRandomNumbers.hh"
+#include "RandomVariateBuffer.hh"
+
+#include "G4SystemOfUnits.hh"
+#include "Randomize.hh"
+
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <iomanip>
+#include <map>
+#include <sstream>
+#include <tuple>
+
+namespace
+{
+    const char kMagic[] = "EFF10CRN";
+    const G4int kVersion = 2;
+
+    // Mean and variance of the mean of a sample
+    void GetMeanError(const std::vector<G4double>& values,G4double& mean,G4double& variance){
+        mean = 0.;
+        variance = 0.;
+        if(values.empty()) return;
+        for (auto value : values) mean += value;
+        mean /= values.size();
+        if(values.size() < 2) return;
+        for (auto value : values) variance += (value - mean) * (value - mean);
+        variance /= (values.size() - 1.) * values.size();
+    }
+}
+
+G4ThreadLocal CommonRandomNumbers* CommonRandomNumbers::fInstance = 0;
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+CommonRandomNumbers* CommonRandomNumbers::Instance(){
+    if(!fInstance){
+        fInstance = new CommonRandomNumbers();
+    }
+    return fInstance;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+CommonRandomNumbers::CommonRandomNumbers():
+bActive(false),
+fSeed(1),
+fPair(0){
+    fMessenger = new G4GenericMessenger(this,
+                                        "/crn/",
+                                        "Common random numbers for paired runs of two configurations" );
+    
+    fMessenger->DeclareProperty("setActive", bActive,
+                                "reseed the engine for the source of each event and for each track" );
+    fMessenger->DeclareProperty("setSeed", fSeed,
+                                "seed of the streams, the same for the two runs of a pair" );
+    fMessenger->DeclareProperty("setPair", fPair,
+                                "index of the pair, the same for its two runs and another one for the next pair" );
+    fMessenger->DeclareMethod("setOutputFile",
+                              &CommonRandomNumbers::SetOutputFile,
+                              "file of the outcomes of the primary ions, none to stop writing" );
+    fMessenger->DeclareMethod("compare",
+                              &CommonRandomNumbers::Compare,
+                              "fileA;fileB, paired differences of the release of two runs" )
+    .SetToBeBroadcasted(false);
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+CommonRandomNumbers::~CommonRandomNumbers(){
+    delete fMessenger;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+uint64_t CommonRandomNumbers::Mix(uint64_t z){
+    // SplitMix64 finalizer
+    z += 0x9E3779B97F4A7C15ULL;
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+    return z ^ (z >> 31);
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+uint64_t CommonRandomNumbers::GetKey(G4int event,G4int stream,G4int index) const{
+    uint64_t key = Mix(uint64_t(uint32_t(fSeed)));
+    key = Mix(key ^ uint64_t(uint32_t(fPair)));
+    key = Mix(key ^ uint64_t(uint32_t(event)));
+    key = Mix(key ^ uint64_t(uint32_t(stream)));
+    return Mix(key ^ uint64_t(uint32_t(index)));
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+uint64_t CommonRandomNumbers::GetDaughterKey(uint64_t parent,G4int daughter){
+    return Mix(parent ^ Mix(uint64_t(uint32_t(daughter)) + 1));
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void CommonRandomNumbers::Reseed(uint64_t key) const{
+    // Two non-zero 31-bit seeds, zero terminated as for the event seeds
+    long seeds[3];
+    seeds[0] = long((key >> 32) & 0x7FFFFFFF);
+    seeds[1] = long(key & 0x7FFFFFFF);
+    seeds[2] = 0;
+    if(seeds[0] == 0) seeds[0] = 1;
+    if(seeds[1] == 0) seeds[1] = 1;
+    G4Random::setTheSeeds(seeds,-1);
+    
+    if(bUSE_RANDOM_BUFFER){
+        RandomVariateBuffer::Instance()->Reset();
+    }
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void CommonRandomNumbers::WriteOutcomes(const std::vector<Outcome>& outcomes){
+    if(fOutputFile.empty()) return;
+    
+    G4bool truncate = fWrittenFiles.insert(fOutputFile).second;
+    std::ofstream file(fOutputFile,truncate ? std::ofstream::trunc : std::ofstream::app);
+    if(!file.is_open()){
+        G4Exception("CommonRandomNumbers::WriteOutcomes",
+                    "eff0013",
+                    JustWarning,
+                    ("Cannot write the outcome file " + fOutputFile).c_str());
+        return;
+    }
+    if(truncate){
+        file << kMagic << " " << kVersion << std::endl;
+    }
+    file.precision(10);
+    for (auto& outcome : outcomes){
+        file << outcome.fPair << " " << outcome.fEvent << " " << outcome.fIon << " "
+        << outcome.fWeight << " " << (outcome.fTime >= 0. ? outcome.fTime / CLHEP::s : -1.) << std::endl;
+    }
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+G4bool CommonRandomNumbers::ReadOutcomes(const G4String& fileName,std::vector<Outcome>& outcomes) const{
+    std::ifstream file(fileName);
+    std::string magic;
+    G4int version = 0;
+    if(!(file >> magic >> version) || magic != kMagic || version != kVersion){
+        G4Exception("CommonRandomNumbers::ReadOutcomes",
+                    "eff0013",
+                    JustWarning,
+                    ("Cannot read the outcome file " + fileName).c_str());
+        return false;
+    }
+    Outcome outcome;
+    while(file >> outcome.fPair >> outcome.fEvent >> outcome.fIon >> outcome.fWeight >> outcome.fTime){
+        if(outcome.fTime >= 0.) outcome.fTime *= CLHEP::s;
+        outcomes.push_back(outcome);
+    }
+    return true;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void CommonRandomNumbers::Compare(std::string files){
+    std::replace(files.begin(),files.end(),';',' ');
+    std::istringstream input(files);
+    G4String fileA, fileB;
+    if(!(input >> fileA >> fileB)){
+        G4Exception("CommonRandomNumbers::Compare",
+                    "eff0013",
+                    JustWarning,
+                    "Usage: /crn/compare fileA;fileB");
+        return;
+    }
+    std::vector<Outcome> outcomesA, outcomesB;
+    if(!ReadOutcomes(fileA,outcomesA) || !ReadOutcomes(fileB,outcomesB)) return;
+    
+    // The ions are matched by pair, event and track ID, the run IDs of the
+    // two configurations differ
+    std::map<std::tuple<G4int,G4int,G4int>,const Outcome*> ions;
+    for (auto& outcome : outcomesA){
+        ions[std::make_tuple(outcome.fPair,outcome.fEvent,outcome.fIon)] = &outcome;
+    }
+    std::vector<std::pair<const Outcome*,const Outcome*>> pairs;
+    for (auto& outcome : outcomesB){
+        auto search = ions.find(std::make_tuple(outcome.fPair,outcome.fEvent,outcome.fIon));
+        if(search != ions.end()){
+            pairs.push_back(std::make_pair(search->second,&outcome));
+        }
+    }
+    if(pairs.empty()){
+        G4Exception("CommonRandomNumbers::Compare",
+                    "eff0013",
+                    JustWarning,
+                    ("No common ion in " + fileA + " and " + fileB).c_str());
+        return;
+    }
+    
+    // Release of each ion with its weight relative to the mean weight, the
+    // mean is the release fraction of the run
+    G4double weightA = 0., weightB = 0.;
+    for (auto& it : pairs){
+        weightA += it.first->fWeight;
+        weightB += it.second->fWeight;
+    }
+    weightA /= pairs.size();
+    weightB /= pairs.size();
+    std::vector<G4double> releaseA, releaseB, releaseDifference;
+    std::vector<G4double> timeA, timeB, timeDifference;
+    for (auto& it : pairs){
+        G4double a = (it.first->fTime >= 0. && weightA > 0.) ? it.first->fWeight / weightA : 0.;
+        G4double b = (it.second->fTime >= 0. && weightB > 0.) ? it.second->fWeight / weightB : 0.;
+        releaseA.push_back(a);
+        releaseB.push_back(b);
+        releaseDifference.push_back(b - a);
+        if(it.first->fTime >= 0.) timeA.push_back(it.first->fTime);
+        if(it.second->fTime >= 0.) timeB.push_back(it.second->fTime);
+        if(it.first->fTime >= 0. && it.second->fTime >= 0.){
+            timeDifference.push_back(it.second->fTime - it.first->fTime);
+        }
+    }
+    
+    G4double meanA, varianceA, meanB, varianceB, difference, variance;
+    
+    G4cout << G4endl << "---------------------- Common random numbers comparison -----------------------" << G4endl;
+    G4cout << "A: " << fileA << ", B: " << fileB << G4endl;
+    G4cout << pairs.size() << " paired ions, "
+    << outcomesA.size() + outcomesB.size() - 2 * pairs.size() << " unmatched" << G4endl;
+    G4cout << "                   A          B      B - A paired.err indep.err" << G4endl;
+    
+    std::ios::fmtflags flags = G4cout.flags();
+    std::streamsize precision = G4cout.precision(3);
+    
+    GetMeanError(releaseA,meanA,varianceA);
+    GetMeanError(releaseB,meanB,varianceB);
+    GetMeanError(releaseDifference,difference,variance);
+    G4cout << "fraction   " << std::scientific
+    << std::setw(11) << meanA
+    << std::setw(11) << meanB
+    << std::setw(11) << difference
+    << std::setw(11) << std::sqrt(variance)
+    << std::setw(11) << std::sqrt(varianceA + varianceB)
+    << G4endl;
+    
+    // Ions released in both runs for the paired difference of the times
+    GetMeanError(timeA,meanA,varianceA);
+    GetMeanError(timeB,meanB,varianceB);
+    GetMeanError(timeDifference,difference,variance);
+    G4cout << "time [s]   "
+    << std::setw(11) << meanA / CLHEP::s
+    << std::setw(11) << meanB / CLHEP::s
+    << std::setw(11) << difference / CLHEP::s
+    << std::setw(11) << std::sqrt(variance) / CLHEP::s
+    << std::setw(11) << std::sqrt(varianceA + varianceB) / CLHEP::s
+    << G4endl;
+    G4cout << timeDifference.size() << " ions released in both runs" << G4endl;
+    
+    G4cout.flags(flags);
+    G4cout.precision(precision);
+    G4cout << "-------------------------------------------------------------------------------" << G4endl;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
@@ -0,0 +1,431 @@
+//
+// ********************************************************************
+// * License and Disclaimer                                           *
+// *                                                                  *
+// * The  Geant4 software  is  copyright of the Copyright Holders  of *
+// * the Geant4 Collaboration.  It is provided  under  the terms  and *
+// * conditions of the Geant4 Software License,  included in the file *
+// * LICENSE and available at  http://cern.ch/geant4/license .  These *
+// * include a list of copyright holders.                             *
+// *                                                                  *
+// * Neither the authors of this software system, nor their employing *
+// * institutes,nor the agencies providing financial support for this *
+// * work  make  any representation or  warranty, express or implied, *
+// * regarding  this  software system or assume any liability for its *
+// * use.  Please see the license in the file  LICENSE  and URL above *
+// * for the full disclaimer and the limitation of liability.         *
+// *                                                                  *
+// * This  code  implementation is the result of  the  scientific and *
+// * technical work of the GEANT4 collaboration.                      *
+// * By using,  copying,  modifying or  distributing the software (or *
+// * any work based  on the software)  you  agree  to acknowledge its *
+// * use  in  resulting  scientific  publications,  and indicate your *
+// * acceptance of all terms of the Geant4 Software license.          *
+// ********************************************************************
+//
+//
+/// \file CompartmentModel.cc
+/// \brief Implementation of the CompartmentModel class
+
+#include "CompartmentModel.hh"
+#include "Run.hh"
+#include "EffusionProcess.hh"
+#include "LogTimeHistogram.hh"
+
+#include "G4VPhysicalVolume.hh"
+#include "G4LogicalVolume.hh"
+#include "G4IonTable.hh"
+#include "G4ParticleDefinition.hh"
+#include "G4SystemOfUnits.hh"
+#include "Randomize.hh"
+
+#include <algorithm>
+#include <cfloat>
+#include <chrono>
+#include <cmath>
+#include <fstream>
+#include <sstream>
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+G4bool CompartmentModel::bCalibrate = false;
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+CompartmentModel::CompartmentModel():
+fRun(0),
+bPrepared(false),
+fResult(0),
+fTransitions(0),
+fOutputPrefix("compartment"){
+    fMessenger = new G4GenericMessenger(this,
+                                        "/compartment/",
+                                        "Compartment model of the target" );
+    
+    fMessenger->DeclareProperty("setCalibration", bCalibrate,
+                                "fill the kernels in the next runs, to be set before the first beamOn" ).SetToBeBroadcasted(false);
+    fMessenger->DeclareMethod("saveCalibration", &CompartmentModel::SaveCalibration,
+                              "save the kernels of the last run" ).SetToBeBroadcasted(false);
+    fMessenger->DeclareMethod("loadCalibration", &CompartmentModel::LoadCalibration,
+                              "load the kernels saved by saveCalibration" ).SetToBeBroadcasted(false);
+    fMessenger->DeclareMethod("addDecay", &CompartmentModel::AddDecay,
+                              "add decay parentZ;parentA;daughterZ;daughterA;branching" ).SetToBeBroadcasted(false);
+    fMessenger->DeclareProperty("setOutputPrefix", fOutputPrefix,
+                                "prefix of the output files" ).SetToBeBroadcasted(false);
+    fMessenger->DeclareMethod("simulate", &CompartmentModel::Simulate,
+                              "simulate Z;A;number of ions;disk (-1 as in the calibration)" ).SetToBeBroadcasted(false);
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+CompartmentModel::~CompartmentModel(){
+    delete fMessenger;
+    delete fResult;
+    delete fRun;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+G4int CompartmentModel::GetCompartment(const G4VPhysicalVolume* volume){
+    if(!volume) return kOutside;
+    const G4String& name = volume->GetLogicalVolume()->GetName();
+    if(name.compare(0,4,"Disk") == 0) return volume->GetCopyNo();
+    if(name.compare(0,8,"Transfer") == 0) return kTransfer;
+    if(name == "Detector.Logic") return kDetector;
+    return kBox;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void CompartmentModel::SetRun(const Run* aRun){
+    delete fRun;
+    fRun = new Run();
+    fRun->Accumulate(aRun);
+    bPrepared = false;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void CompartmentModel::SaveCalibration(std::string fileName){
+    if(!fRun){
+        G4Exception("CompartmentModel::SaveCalibration",
+                    "eff0009",
+                    JustWarning,
+                    "No run to save.");
+        return;
+    }
+    if(!bCalibrate){
+        G4Exception("CompartmentModel::SaveCalibration",
+                    "eff0009",
+                    JustWarning,
+                    "The kernels are only filled with /compartment/setCalibration true.");
+    }
+    std::ofstream fFileOut;
+    fFileOut.open(fileName,std::ofstream::out | std::ofstream::trunc);
+    fFileOut.precision(17);
+    fFileOut << "eff10_compartment 1" << std::endl;
+    fRun->WriteCheckpoint(fFileOut);
+    fFileOut << "end" << std::endl;
+    fFileOut.close();
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void CompartmentModel::LoadCalibration(std::string fileName){
+    delete fRun;
+    fRun = new Run();
+    bPrepared = false;
+    
+    std::ifstream fFileIn(fileName);
+    std::string magic;
+    G4int version = 0;
+    fFileIn >> magic >> version;
+    if(magic != "eff10_compartment" || version != 1 || !fRun->ReadCheckpoint(fFileIn)){
+        G4ExceptionDescription ed;
+        ed << "Cannot read calibration file `" << fileName << "'" << G4endl;
+        G4Exception("CompartmentModel::LoadCalibration",
+                    "eff0009",
+                    JustWarning,
+                    ed);
+        delete fRun;
+        fRun = 0;
+    }
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void CompartmentModel::AddDecay(std::string s){
+    if (s==""){return;}
+    const char delimiter = ';';
+    std::vector<std::string> tokens;
+    std::string token;
+    std::istringstream tokenStream(s);
+    while (std::getline(tokenStream, token, delimiter)){
+        tokens.push_back(token);
+    }
+    if(tokens.size() < 5){return;}
+    
+    Branch branch;
+    branch.fZ = std::stoi(tokens[2]);
+    branch.fA = std::stoi(tokens[3]);
+    branch.fProbability = std::stod(tokens[4]);
+    fDecays[std::stoi(tokens[1]) * 1000 + std::stoi(tokens[0])].push_back(branch);
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void CompartmentModel::Prepare(){
+    fKernels.clear();
+    
+    // Weight per destination of each kernel, the key of the kernel is the
+    // compartment code without the destination
+    const size_t bins = LogTimeHistogram::GetNumberOfBins() + 2;
+    for (auto& it : fRun->fCompartmentHistogram){
+        G4double total = it.second.GetSumOfWeights();
+        if(total <= 0.) continue;
+        
+        Kernel& kernel = fKernels[it.first - it.first % 100];
+        kernel.fTo.push_back(it.first % 100);
+        kernel.fProbability.push_back(total);
+        
+        const std::vector<G4double>& contents = it.second.GetContents();
+        std::vector<G4double> cumulative(bins,0.);
+        G4double sum = 0.;
+        for(size_t i0=0;i0<bins;i0++){
+            sum += contents[i0];
+            cumulative[i0] = sum / total;
+        }
+        kernel.fCumulative.push_back(cumulative);
+    }
+    
+    for (auto& it : fKernels){
+        std::vector<G4double>& probability = it.second.fProbability;
+        G4double sum = 0.;
+        for(auto& weight : probability){
+            sum += weight;
+            weight = sum;
+        }
+        for(auto& weight : probability){
+            weight /= sum;
+        }
+    }
+    bPrepared = true;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+const CompartmentModel::Kernel* CompartmentModel::FindKernel(G4int Z,
+                                                             G4bool first,
+                                                             G4int compartment) const{
+    // The nuclei produced in a compartment without a kernel of their own,
+    // as the daughters decaying in the cavity, move as the ones entering
+    // from outside
+    auto search = fKernels.find(fRun->GetCompartmentCode(Z,first,compartment,0));
+    if(search == fKernels.end() && first){
+        search = fKernels.find(fRun->GetCompartmentCode(Z,false,compartment,0));
+    }
+    if(search == fKernels.end()) return 0;
+    return &(search->second);
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+G4double CompartmentModel::SampleTime(const std::vector<G4double>& cumulative) const{
+    // Inverse of the cumulative distribution, interpolated logarithmically
+    // inside the bin as in LogTimeHistogram::GetQuantile()
+    G4double random = G4UniformRand();
+    size_t bin = std::upper_bound(cumulative.begin(),cumulative.end(),random) - cumulative.begin();
+    if(bin == 0) return LogTimeHistogram::GetMinTime();
+    if(bin >= cumulative.size() - 1) return LogTimeHistogram::GetMaxTime();
+    G4double fraction = (random - cumulative[bin-1]) / (cumulative[bin] - cumulative[bin-1]);
+    return LogTimeHistogram::GetBinLowEdge(G4int(bin)) *
+        std::pow(10.,fraction / LogTimeHistogram::GetBinsPerDecade());
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+G4double CompartmentModel::GetLifeTime(G4int Z,G4int A){
+    auto search = fLifeTimes.find(A * 1000 + Z);
+    if(search != fLifeTimes.end()) return search->second;
+    
+    G4double lifetime = -1.;
+    G4ParticleDefinition* ion = G4IonTable::GetIonTable()->GetIon(Z,A);
+    if(ion && !ion->GetPDGStable()) lifetime = ion->GetPDGLifeTime();
+    fLifeTimes[A * 1000 + Z] = lifetime;
+    return lifetime;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void CompartmentModel::Transport(const Ion& ion,std::vector<Ion>& stack){
+    G4double lifetime = GetLifeTime(ion.fZ,ion.fA);
+    G4double decayTime = lifetime > 0. ? ion.fTime - lifetime * std::log(1. - G4UniformRand()) : DBL_MAX;
+    G4int code = fResult->GetCode(ion.fA,ion.fZ,ion.fOriginDisk);
+    
+    G4int compartment = ion.fCompartment;
+    G4bool first = ion.bFirst;
+    G4double time = ion.fTime;
+    
+    while(true){
+        const Kernel* kernel = FindKernel(ion.fZ,first,compartment);
+        if(!kernel){
+            fResult->FillTermination(Run::kOther,code,time);
+            return;
+        }
+        
+        const std::vector<G4double>& probability = kernel->fProbability;
+        size_t next = std::upper_bound(probability.begin(),probability.end(),G4UniformRand()) - probability.begin();
+        next = std::min(next,probability.size() - 1);
+        G4double arrival = time + SampleTime(kernel->fCumulative[next]);
+        fTransitions++;
+        
+        if(arrival > decayTime){
+            fResult->FillTermination(Run::kDecayed,code,decayTime);
+            
+            // The daughter starts where the parent decays, as a nucleus
+            // produced there
+            auto search = fDecays.find(ion.fA * 1000 + ion.fZ);
+            if(search == fDecays.end()) return;
+            G4double random = G4UniformRand();
+            for (auto& branch : search->second){
+                if(random < branch.fProbability){
+                    Ion daughter;
+                    daughter.fZ = branch.fZ;
+                    daughter.fA = branch.fA;
+                    daughter.fCompartment = compartment;
+                    daughter.fOriginDisk = compartment < kBox ? compartment : -1;
+                    daughter.bFirst = true;
+                    daughter.fTime = decayTime;
+                    if(daughter.fOriginDisk >= 0){
+                        fResult->AddGenerated(fResult->GetCode(daughter.fA,daughter.fZ,daughter.fOriginDisk));
+                    }
+                    stack.push_back(daughter);
+                    return;
+                }
+                random -= branch.fProbability;
+            }
+            return;
+        }
+        if(arrival > EffusionProcess::fTimeLimit){
+            fResult->FillTermination(Run::kTimeLimit,code,arrival);
+            return;
+        }
+        
+        time = arrival;
+        first = false;
+        compartment = kernel->fTo[next];
+        if(compartment == kDetector){
+            fResult->fArrivalTime[code].Fill(time);
+            fResult->fArrivalHistogram[code].Fill(time);
+            return;
+        }
+        if(compartment == kOutside){
+            fResult->FillTermination(Run::kEscaped,code,time);
+            return;
+        }
+        if(compartment == kLost){
+            fResult->FillTermination(Run::kAdsorbed,code,time);
+            return;
+        }
+    }
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void CompartmentModel::Simulate(std::string s){
+    if (s==""){return;}
+    const char delimiter = ';';
+    std::vector<std::string> tokens;
+    std::string token;
+    std::istringstream tokenStream(s);
+    while (std::getline(tokenStream, token, delimiter)){
+        tokens.push_back(token);
+    }
+    if(tokens.size() < 3){return;}
+    G4int Z = std::stoi(tokens[0]);
+    G4int A = std::stoi(tokens[1]);
+    G4long nIons = std::stol(tokens[2]);
+    G4int disk = tokens.size() > 3 ? std::stoi(tokens[3]) : -1;
+    
+    if(!fRun){
+        G4Exception("CompartmentModel::Simulate",
+                    "eff0009",
+                    JustWarning,
+                    "No run or calibration file for the kernels.");
+        return;
+    }
+    if(!bPrepared) Prepare();
+    
+    // Disks of production, from the calibration run if not given
+    std::vector<G4int> disks;
+    std::vector<G4double> production;
+    if(disk >= 0){
+        disks.push_back(disk);
+        production.push_back(1.);
+    }
+    else{
+        for (auto it : fRun->fIsotopes){
+            if(it.first % 1000000 == fRun->GetCode(A,Z,-1) && it.first / 1000000 > 0){
+                disks.push_back(it.first / 1000000 - 1);
+                production.push_back(production.empty() ? it.second : production.back() + it.second);
+            }
+        }
+    }
+    if(disks.empty()){
+        G4ExceptionDescription ed;
+        ed << "No production of Z = " << Z << " A = " << A
+        << " in the calibration run, give the disk." << G4endl;
+        G4Exception("CompartmentModel::Simulate",
+                    "eff0009",
+                    JustWarning,
+                    ed);
+        return;
+    }
+    
+    delete fResult;
+    fResult = new Run();
+    fTransitions = 0;
+    
+    auto start = std::chrono::steady_clock::now();
+    
+    std::vector<Ion> stack;
+    for(G4long i0=0;i0<nIons;i0++){
+        G4double random = production.back() * G4UniformRand();
+        size_t index = std::upper_bound(production.begin(),production.end(),random) - production.begin();
+        index = std::min(index,production.size() - 1);
+        
+        Ion ion;
+        ion.fZ = Z;
+        ion.fA = A;
+        ion.fCompartment = disks[index];
+        ion.fOriginDisk = disks[index];
+        ion.bFirst = true;
+        ion.fTime = 0.;
+        fResult->AddGenerated(fResult->GetCode(A,Z,disks[index]));
+        
+        Transport(ion,stack);
+        while(!stack.empty()){
+            Ion daughter = stack.back();
+            stack.pop_back();
+            Transport(daughter,stack);
+        }
+    }
+    
+    std::chrono::duration<G4double> elapsed = std::chrono::steady_clock::now() - start;
+    G4cout << "--- Compartment model of Z = " << Z << " A = " << A << ": "
+    << nIons << " ions and " << fTransitions << " transitions in "
+    << elapsed.count() << " s ("
+    << (elapsed.count() > 0. ? nIons / elapsed.count() : 0.) << " ions/s)" << G4endl;
+    
+    fResult->PrintArrivalTimeSummary();
+    
+    std::ofstream fFileOut;
+    fFileOut.open(fOutputPrefix + "_isotope_table.dat",std::ofstream::out | std::ofstream::trunc);
+    for (auto it : fResult->fIsotopes){
+        fFileOut << it.first << " , " << it.second << std::endl;
+    }
+    fFileOut.close();
+    fResult->WriteHistograms(fOutputPrefix + "_histograms.bin");
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
@@ -53,6 +53,8 @@
 #include "G4PhysicalVolumeStore.hh"
 #include "G4LogicalVolumeStore.hh"
 #include "G4SolidStore.hh"
+#include "G4RegionStore.hh"
+#include "G4Region.hh"
 #include "G4TransportationManager.hh"
 #include "G4UnitsTable.hh"
 #include "G4NistManager.hh"
@@ -65,6 +67,8 @@
 #include "TargetSensitiveDetector.hh"
 
 #include "EffusionOptrMultiParticleChangeCrossSection.hh"
+#include "TransferLineKernel.hh"
+#include "TransferLineModel.hh"
 
 
 //....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
@@ -79,7 +83,9 @@ fTargetBoxInit(-107.02 * mm),
 fTargetBoxEnd(94.48 * mm),
 fTargetDiskRadius(20.0 * mm),
 fTargetDiskPosition(),
-fTargetDiskThickness()
+fTargetDiskThickness(),
+bTransferFastSim(false),
+fTransferKernelFile("transfer_kernel.dat")
 {
     fMessenger = new DetectorConstructionMessenger(this);
     
@@ -455,6 +461,59 @@ G4VPhysicalVolume* DetectorConstruction::Construct()
                       false,
                       0);
 
+    // Vacuum envelopes of the bore, region of the fast simulation. Only
+    // built for the fast simulation, the navigation is otherwise unchanged
+    if(bPrimaries == false && bTransferFastSim == true){
+        G4CutTubs* sBore1 = new G4CutTubs("TransferBore1.Solid",
+                                          0.,
+                                          TransferDmin * 0.5,
+                                          TransferSect1Dz * 0.5,
+                                          0.   * deg,
+                                          360. * deg,
+                                          sSection1->GetLowNorm(),
+                                          sSection1->GetHighNorm());
+
+        G4LogicalVolume* lBore1 = new G4LogicalVolume(sBore1,
+                                                      WorldMaterial,
+                                                      "TransferBore1.Logic");
+
+        new G4PVPlacement(Transfer1Rot,
+                          Transfer1Posz,
+                          lBore1,
+                          "TransferBore1.Physical",
+                          logicWorld,
+                          false,
+                          0);
+
+        G4CutTubs* sBore2 = new G4CutTubs("TransferBore2.Solid",
+                                          0.,
+                                          TransferDmin * 0.5,
+                                          TransferSect2Dz * 0.5,
+                                          0.   * deg,
+                                          360. * deg,
+                                          sTransfer2->GetLowNorm(),
+                                          sTransfer2->GetHighNorm());
+
+        G4LogicalVolume* lBore2 = new G4LogicalVolume(sBore2,
+                                                      WorldMaterial,
+                                                      "TransferBore2.Logic");
+
+        new G4PVPlacement(Transfer2Rot,
+                          Transfer2Posz,
+                          lBore2,
+                          "TransferBore2.Physical",
+                          logicWorld,
+                          false,
+                          0);
+
+        G4Region* transferRegion = G4RegionStore::GetInstance()->GetRegion("TransferLine",false);
+        if(transferRegion == NULL){
+            transferRegion = new G4Region("TransferLine");
+        }
+        transferRegion->AddRootLogicalVolume(lBore1);
+        transferRegion->AddRootLogicalVolume(lBore2);
+    }
+
     
     //*********************************************************//
     //
@@ -575,12 +634,28 @@ void DetectorConstruction::ConstructSDandField(){
         }
     }
     
+    if(bPrimaries == false && bTransferFastSim == true){
+        G4Region* transferRegion = G4RegionStore::GetInstance()->GetRegion("TransferLine");
+        new TransferLineModel("TransferLine.Model",transferRegion,fTransferKernelFile);
+        G4cout << "--- Attaching fast simulation model to region "
+        << transferRegion->GetName() << G4endl;
+    }
+    
     if(bPrimaries == false){
         EffusionOptrMultiParticleChangeCrossSection* effusionXSchange = new EffusionOptrMultiParticleChangeCrossSection();
         effusionXSchange->AddParticle("GenericIon");
-        // Modify Radioactive In-Flight Decay with Sticking Time
+        // Modify Radioactive In-Flight Decay with Sticking Time, only in the
+        // volumes where the nuclei stick and in the transfer line, where the
+        // fast simulation leaves the transit time
+        G4Material* worldMaterial =
+        G4LogicalVolumeStore::GetInstance()->GetVolume("World")->GetMaterial();
+        G4Region* transferRegion = G4RegionStore::GetInstance()->GetRegion("TransferLine",false);
         for (auto lv : *G4LogicalVolumeStore::GetInstance()){
             G4String lvName = lv->GetName();
+            if(lv->GetMaterial() == worldMaterial &&
+               (transferRegion == NULL || lv->GetRegion() != transferRegion)){
+                continue;
+            }
             effusionXSchange->AttachTo(lv);
             G4cout << "--- Attaching biasing operator " << effusionXSchange->GetName()
             << " to logical volume " << lvName << G4endl;
@@ -590,6 +665,16 @@ void DetectorConstruction::ConstructSDandField(){
 
 //....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
 
+void DetectorConstruction::BuildTransferKernel(G4int histories){
+    TransferLineKernel kernel;
+    if(kernel.Build(histories)){
+        kernel.Write(fTransferKernelFile);
+        G4cout << "--- Transfer line kernel written to " << fTransferKernelFile << G4endl;
+    }
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
 void DetectorConstruction::CreateTub(G4String name,
                                      G4double Dmin,
                                      G4double Dmax,
@@ -33,6 +33,7 @@
 #include "G4UIcmdWith3VectorAndUnit.hh"
 #include "G4UIcmdWith3Vector.hh"
 #include "G4UIcmdWithADouble.hh"
+#include "G4UIcmdWithAnInteger.hh"
 #include "G4RunManager.hh"
 
 #include "G4ios.hh"
@@ -112,6 +113,28 @@ DetectorConstructionMessenger(
         fTargetDiskThicknessCmd[i]->SetDefaultValue(0.08);
         fTargetDiskThicknessCmd[i]->SetDefaultUnit("cm");
     }
+
+    fTransferFastSimCmd = new G4UIcmdWithABool("/det/setTransferFastSim",this);
+    fTransferFastSimCmd->SetGuidance("Use the fast simulation of the transfer line.");
+    fTransferFastSimCmd->SetGuidance("The bore envelopes and the fast simulation process are only built when set before the initialization.");
+    fTransferFastSimCmd->SetParameterName("transferfastsim",
+                                          true);
+    fTransferFastSimCmd->SetDefaultValue(true);
+    fTransferFastSimCmd->AvailableForStates(G4State_PreInit);
+
+    fTransferKernelCmd = new G4UIcmdWithAString("/det/setTransferKernel",this);
+    fTransferKernelCmd->SetGuidance("Set the file of the transfer line kernel.");
+    fTransferKernelCmd->SetParameterName("transferkernel",
+                                         true);
+    fTransferKernelCmd->SetDefaultValue("transfer_kernel.dat");
+
+    fBuildTransferKernelCmd = new G4UIcmdWithAnInteger("/det/buildTransferKernel",this);
+    fBuildTransferKernelCmd->SetGuidance("Trace the transfer line kernel and write it to file.");
+    fBuildTransferKernelCmd->SetGuidance("Available after /run/initialize with /det/setTransferFastSim true.");
+    fBuildTransferKernelCmd->SetParameterName("histories",
+                                              true);
+    fBuildTransferKernelCmd->SetDefaultValue(100000);
+    fBuildTransferKernelCmd->SetToBeBroadcasted(false);
 }
 
 //....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo....
@@ -132,6 +155,10 @@ DetectorConstructionMessenger::
         delete fTargetDiskThicknessCmd[i];
     }
 
+    delete fTransferFastSimCmd;
+    delete fTransferKernelCmd;
+    delete fBuildTransferKernelCmd;
+
 }
 
 //....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo....
@@ -179,6 +206,18 @@ void DetectorConstructionMessenger::SetNewValue(G4UIcommand *command,
         }
    }
 
+    if(command==fTransferFastSimCmd ){
+        fTarget->SetTransferFastSim(fTransferFastSimCmd->GetNewBoolValue(newValue));
+    }
+
+    if(command==fTransferKernelCmd ){
+        fTarget->SetTransferKernelFile(newValue);
+    }
+
+    if(command==fBuildTransferKernelCmd ){
+        fTarget->BuildTransferKernel(fBuildTransferKernelCmd->GetNewIntValue(newValue));
+    }
+
 }
 
 //....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo....
@@ -215,6 +254,12 @@ G4String DetectorConstructionMessenger::GetCurrentValue(G4UIcommand * command){
             cv = fTargetDiskThicknessCmd[i]->ConvertToString(fTarget->GetTargetDiskThickness(i),"cm");
         }
     }
+    if( command==fTransferFastSimCmd ){
+        cv = fTransferFastSimCmd->ConvertToString(fTarget->GetTransferFastSim());
+    }
+    if( command==fTransferKernelCmd ){
+        cv = fTarget->GetTransferKernelFile();
+    }
 
     return cv;
 }
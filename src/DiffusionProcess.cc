@@ -37,10 +37,13 @@
 #include "G4Navigator.hh"
 #include "G4TransportationManager.hh"
 #include "G4RandomDirection.hh"
+#include "RandomVariateBuffer.hh"
 
 //....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
 
-DiffusionProcess::DiffusionProcess(const G4String& processName): G4VDiscreteProcess(processName){
+DiffusionProcess::DiffusionProcess(const G4String& processName)
+: G4VDiscreteProcess(processName),
+fTrackData(0){
     kCarTolerance = G4GeometryTolerance::GetInstance()->GetSurfaceTolerance();
     fEffusionID = G4PhysicsModelCatalog::GetIndex("effusion");
     if(fEffusionID == -1){
@@ -84,6 +87,9 @@ DiffusionProcess::~DiffusionProcess(){}
 //....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
 
 EffusionTrackData* DiffusionProcess::GetTrackData(const G4Track& aTrack){
+    if(fTrackData){
+        return fTrackData;
+    }
     EffusionTrackData* trackdata =
     (EffusionTrackData*)(aTrack.GetAuxiliaryTrackInformation(fEffusionID));
     if(trackdata == nullptr){
@@ -95,12 +101,27 @@ EffusionTrackData* DiffusionProcess::GetTrackData(const G4Track& aTrack){
 
 //....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
 
+void DiffusionProcess::StartTracking(G4Track* aTrack){
+    G4VDiscreteProcess::StartTracking(aTrack);
+    fTrackData = 0;
+    fTrackData = GetTrackData(*aTrack);
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void DiffusionProcess::EndTracking(){
+    G4VDiscreteProcess::EndTracking();
+    fTrackData = 0;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
 G4VParticleChange*
 DiffusionProcess::PostStepDoIt(const G4Track& aTrack, const G4Step&)
 {
     aParticleChange.Initialize(aTrack);
 
-    if(aTrack.GetTrackID()==1 && aTrack.GetCurrentStepNumber()!=1) {
+    if(aTrack.GetParentID()==0 && aTrack.GetCurrentStepNumber()!=1) {
         G4double diff_coeff0  = GetDiffusionCoefficient(aTrack);//cm2/s
 
         if(diff_coeff0 == 0.){
@@ -111,7 +132,7 @@ DiffusionProcess::PostStepDoIt(const G4Track& aTrack, const G4Step&)
         G4double activation_energy = 56.4;// kcal/mol/K;
         G4double a_mean = 1.E-2 * CLHEP::nanometer;
         G4double a_sigma = 1.E-3 * CLHEP::nanometer;
-        G4double a = G4RandGauss::shoot(a_mean,a_sigma);
+        G4double a = BufferedGauss(a_mean,a_sigma);
 
         G4double T = aTrack.GetVolume()->GetLogicalVolume()->GetMaterial()->GetTemperature();
         
@@ -129,7 +150,7 @@ DiffusionProcess::PostStepDoIt(const G4Track& aTrack, const G4Step&)
         return &aParticleChange;
     }
     
-    G4ThreeVector newDir = G4RandomDirection();
+    G4ThreeVector newDir = BufferedIsotropic();
     aParticleChange.ProposeMomentumDirection(newDir);
     
     return &aParticleChange;
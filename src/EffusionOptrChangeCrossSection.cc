@@ -64,10 +64,20 @@ fEffusionID(-1)
 
 EffusionOptrChangeCrossSection::~EffusionOptrChangeCrossSection()
 {
-    for ( std::map< const G4BiasingProcessInterface*, G4BOptnChangeCrossSection* >::iterator
-         it = fChangeCrossSectionOperations.begin() ;
-         it != fChangeCrossSectionOperations.end() ;
-         it++ ) delete (*it).second;
+    for ( size_t i = 0 ; i < fChangeCrossSectionOperations.size() ; i++ )
+        delete fChangeCrossSectionOperations[i];
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+G4BOptnChangeCrossSection*
+EffusionOptrChangeCrossSection::GetOperation(const G4BiasingProcessInterface* callingProcess) const
+{
+    for ( size_t i = 0 ; i < fProcesses.size() ; i++ )
+    {
+        if ( fProcesses[i] == callingProcess ) return fChangeCrossSectionOperations[i];
+    }
+    return 0;
 }
 
 //....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
@@ -93,8 +103,8 @@ void EffusionOptrChangeCrossSection::StartRun()
                 (sharedData->GetPhysicsBiasingProcessInterfaces())[i];
                 G4String operationName = "EffusionXSchange-" +
                 wrapperProcess->GetWrappedProcess()->GetProcessName();
-                fChangeCrossSectionOperations[wrapperProcess] =
-                new G4BOptnChangeCrossSection(operationName);
+                fProcesses.push_back(wrapperProcess);
+                fChangeCrossSectionOperations.push_back(new G4BOptnChangeCrossSection(operationName));
             }
         }
         fSetup = false;
@@ -142,7 +152,8 @@ EffusionOptrChangeCrossSection::ProposeOccurenceBiasingOperation(const G4Track*
         analogXS = 1./(analogInteractionLength - pathlength);
     }
 
-    G4BOptnChangeCrossSection*   operation = fChangeCrossSectionOperations[callingProcess];
+    G4BOptnChangeCrossSection*   operation = GetOperation(callingProcess);
+    if ( operation == 0 ) return 0;
     G4VBiasingOperation* previousOperation = callingProcess->GetPreviousOccurenceBiasingOperation();
     
     if ( previousOperation == 0 )
@@ -194,8 +205,8 @@ OperationApplied(const G4BiasingProcessInterface*           callingProcess,
                  G4VBiasingOperation*,
                  const G4VParticleChange*                                  )
 {
-    G4BOptnChangeCrossSection* operation = fChangeCrossSectionOperations[callingProcess];
-    if ( operation ==  occurenceOperationApplied ) operation->SetInteractionOccured();
+    G4BOptnChangeCrossSection* operation = GetOperation(callingProcess);
+    if ( operation != 0 && operation ==  occurenceOperationApplied ) operation->SetInteractionOccured();
 }
 
 //....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
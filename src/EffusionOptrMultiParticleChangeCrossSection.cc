@@ -39,7 +39,11 @@
 //....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
 
 EffusionOptrMultiParticleChangeCrossSection::EffusionOptrMultiParticleChangeCrossSection()
-: G4VBiasingOperator("EffusionXSchange-Many"){}
+: G4VBiasingOperator("EffusionXSchange-Many"),
+fCurrentOperator(0),
+fLastDefinition(0),
+fLastOperator(0),
+fnInteractions(0){}
 
 //....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
 
@@ -61,7 +65,8 @@ void EffusionOptrMultiParticleChangeCrossSection::AddParticle(G4String particleN
     
     EffusionOptrChangeCrossSection* optr = new EffusionOptrChangeCrossSection(particleName);
     fParticlesToBias.push_back( particle );
-    fBOptrForParticle[ particle ] = optr;
+    fBOptrForParticle.push_back( optr );
+    fLastDefinition = 0;
 }
 
 //....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
@@ -91,16 +96,19 @@ void EffusionOptrMultiParticleChangeCrossSection::StartTracking( const G4Track*
     // -- fetch the underneath biasing operator, if any, for the current particle type:
     const G4ParticleDefinition* definition = track->GetParticleDefinition();
 
-    if(track->GetParticleDefinition()->GetParticleType()=="nucleus" &&
-       track->GetParticleDefinition()->GetParticleSubType()=="generic"){
-        definition = G4GenericIon::Definition();
+    if ( definition != fLastDefinition ){
+        fLastDefinition = definition;
+        fLastOperator = 0;
+        // -- the ions built by the ion table share the process manager of the GenericIon:
+        if ( definition->IsGeneralIon() ) definition = G4GenericIon::Definition();
+        for ( size_t i = 0 ; i < fParticlesToBias.size() ; i++ ){
+            if ( fParticlesToBias[i] == definition ){
+                fLastOperator = fBOptrForParticle[i];
+                break;
+            }
+        }
     }
-    std::map < const G4ParticleDefinition*, EffusionOptrChangeCrossSection* > :: iterator it = fBOptrForParticle.find( definition );
-    fCurrentOperator = 0;
-    if ( it != fBOptrForParticle.end() ){
-        fCurrentOperator = (*it).second;
-    }
-    fCurrentOperator = (*it).second;
+    fCurrentOperator = fLastOperator;
     // -- reset count for number of biased interactions:
     fnInteractions = 0;
 }
@@ -11,6 +11,9 @@
 
 #include "EffusionProcess.hh"
 #include "DiffusionProcess.hh"
+#include "G4FastSimulationManagerProcess.hh"
+#include "G4RegionStore.hh"
+#include "BallisticTransportation.hh"
 
 #include "G4BosonConstructor.hh"
 #include "G4LeptonConstructor.hh"
@@ -20,10 +23,21 @@
 #include "G4IonConstructor.hh"
 #include "G4ShortLivedConstructor.hh"
 
+#include "G4Geantino.hh"
+#include "G4ChargedGeantino.hh"
+#include "G4Gamma.hh"
+#include "G4Electron.hh"
+#include "G4Positron.hh"
+#include "G4NeutrinoE.hh"
+#include "G4AntiNeutrinoE.hh"
+#include "G4Proton.hh"
+#include "G4Neutron.hh"
+
 //....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
 
-EffusionPhysicsList::EffusionPhysicsList(G4int)
-:G4VPhysicsConstructor("ef10effusion"){;}
+EffusionPhysicsList::EffusionPhysicsList(G4int,G4bool lean)
+:G4VPhysicsConstructor("ef10effusion"),
+bLean(lean){;}
 
 //....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
 
@@ -32,6 +46,24 @@ EffusionPhysicsList::~EffusionPhysicsList(){;}
 //....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
 
 void EffusionPhysicsList::ConstructParticle(){
+    if(bLean){
+        G4IonConstructor pIonConstructor;
+        pIonConstructor.ConstructParticle();
+        
+        // Products of the radioactive decay, the geantinos are the default
+        // of the particle source
+        G4Geantino::GeantinoDefinition();
+        G4ChargedGeantino::ChargedGeantinoDefinition();
+        G4Gamma::GammaDefinition();
+        G4Electron::ElectronDefinition();
+        G4Positron::PositronDefinition();
+        G4NeutrinoE::NeutrinoEDefinition();
+        G4AntiNeutrinoE::AntiNeutrinoEDefinition();
+        G4Proton::ProtonDefinition();
+        G4Neutron::NeutronDefinition();
+        return;
+    }
+    
     G4BosonConstructor  pBosonConstructor;
     pBosonConstructor.ConstructParticle();
 
@@ -58,6 +90,15 @@ void EffusionPhysicsList::ConstructProcess(){
     
     EffusionProcess* effusion = new EffusionProcess();
     DiffusionProcess* diffusion = new DiffusionProcess();
+    // Fast simulation of the transfer line, see TransferLineModel. The
+    // geometry is built first, the region only exists when it is enabled
+    G4FastSimulationManagerProcess* fastSimulation = 0;
+    if(G4RegionStore::GetInstance()->GetRegion("TransferLine",false)){
+        fastSimulation = new G4FastSimulationManagerProcess("fastSimProcess_massGeom");
+    }
+    // Transportation of the thermal ions in the vacuum of the target, the
+    // same as G4Transportation unless /ballistic/setActive is given
+    BallisticTransportation* ballistic = new BallisticTransportation();
     
     G4ParticleTable::G4PTblDicIterator* aParticleIterator =
     G4ParticleTable::GetParticleTable()->GetIterator();
@@ -68,8 +109,24 @@ void EffusionPhysicsList::ConstructProcess(){
 
         G4ProcessManager* pManager = particle->GetProcessManager();
 
+        if(bLean && particle != G4GenericIon::GenericIon()){
+            continue;
+        }
         pManager->AddDiscreteProcess(effusion);
         pManager->AddDiscreteProcess(diffusion);
+        if(particle->GetParticleType() == "nucleus"){
+            if(fastSimulation){
+                pManager->AddDiscreteProcess(fastSimulation);
+            }
+            
+            G4VProcess* transportation = pManager->GetProcess("Transportation");
+            if(transportation){
+                pManager->RemoveProcess(transportation);
+            }
+            pManager->AddProcess(ballistic);
+            pManager->SetProcessOrderingToFirst(ballistic,idxAlongStep);
+            pManager->SetProcessOrderingToFirst(ballistic,idxPostStep);
+        }
     }
 }
 
@@ -37,17 +37,30 @@
 #include "G4Navigator.hh"
 #include "G4TransportationManager.hh"
 #include "G4RandomTools.hh"
+#include "RandomVariateBuffer.hh"
+#include "G4ProcessManager.hh"
+#include "G4ProcessVector.hh"
+#include "G4BiasingProcessInterface.hh"
+#include "BallisticTransportation.hh"
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+const G4double EffusionProcess::fTimeLimit = 360000. * CLHEP::second;
 
 //....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
 
 EffusionProcess::EffusionProcess(const G4String& processName)
 : G4VDiscreteProcess(processName),
+bThermalEnergy(false),
 theSampledKineticEnergy(0.),
 theLocalNormal(G4ThreeVector()),
 theLocalPoint(G4ThreeVector()),
 theGlobalNormal(G4ThreeVector()),
 theGlobalPoint(G4ThreeVector()),
-validLocalNorm(false){
+validLocalNorm(false),
+fTrackData(0),
+fLastDefinition(0),
+bLastTriggered(false){
     kCarTolerance = G4GeometryTolerance::GetInstance()->GetSurfaceTolerance();
     fEffusionID = G4PhysicsModelCatalog::GetIndex("effusion");
     if(fEffusionID == -1){
@@ -67,12 +80,17 @@ validLocalNorm(false){
     fAdsorptionTimeMessenger->DeclareMethod("loadAdsTime", &EffusionProcess::LoadAdsorptionTime,
                                             "load adsorption time partZ;matZ;time_ns" );
     fAdsorptionTimeMessenger->SetGuidance("particle_Z;material_Z;time_ns");
+    fAdsorptionTimeMessenger->DeclareProperty("setThermalEnergy", bThermalEnergy,
+                                              "re-emit the ions with the thermal energy of the surface" );
 
 }
 
 //....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
 
 EffusionTrackData* EffusionProcess::GetTrackData(const G4Track& aTrack){
+    if(fTrackData){
+        return fTrackData;
+    }
     EffusionTrackData* trackdata =
     (EffusionTrackData*)(aTrack.GetAuxiliaryTrackInformation(fEffusionID));
     if(trackdata == nullptr){
@@ -88,88 +106,34 @@ EffusionProcess::~EffusionProcess(){}
 
 //....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
 
+void EffusionProcess::StartTracking(G4Track* aTrack){
+    G4VDiscreteProcess::StartTracking(aTrack);
+    fTrackData = 0;
+    fTrackData = GetTrackData(*aTrack);
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void EffusionProcess::EndTracking(){
+    G4VDiscreteProcess::EndTracking();
+    fTrackData = 0;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
 G4VParticleChange*
 EffusionProcess::PostStepDoIt(const G4Track& aTrack, const G4Step& aStep)
 {
-    aParticleChange.Initialize(aTrack);
-
-    if(aTrack.GetGlobalTime() > 360000. * CLHEP::second) {
-        G4Exception("EffusionProcess::PostStepDoIt",
-                    "eff0001",
-                    JustWarning,
-                    "Particle killed after 100 hours.");
-        
-        aParticleChange.ProposeEnergy(0.);
-        aParticleChange.ProposeTrackStatus(fStopAndKill);
-        return &aParticleChange;
-    }
-    
-    // Check Boundaries
-    G4StepPoint* pPreStepPoint  = aStep.GetPreStepPoint();
-    G4StepPoint* pPostStepPoint = aStep.GetPostStepPoint();
-    
-    if(pPostStepPoint->GetStepStatus() != fGeomBoundary){
-        return &aParticleChange;
-    }
-
-    // Check StepLength
-    if(aTrack.GetStepLength()<=kCarTolerance/2){
-        return &aParticleChange;
-    }
-
-    // Check Materials of next and previous volumes, if same do nothing.
-    G4Material* aMaterialPre  = pPreStepPoint ->GetPhysicalVolume()->GetLogicalVolume()->GetMaterial();
-    G4Material* aMaterialPost = pPostStepPoint->GetPhysicalVolume()->GetLogicalVolume()->GetMaterial();
-    
-    if(aMaterialPre == aMaterialPost){
-        return &aParticleChange;
+    if(bThermalEnergy){
+        return SurfaceInteraction<ThermalSurfaceModel>(aTrack,aStep);
     }
+    return SurfaceInteraction<DefaultSurfaceModel>(aTrack,aStep);
+}
 
-    ///////////////////////////////////////////////////////////////////////////////////
-    if(pPostStepPoint->GetPhysicalVolume()->GetMotherLogical() == 0){
-        return &aParticleChange;
-    }
-    
-    // If the particle is diffused into the material, it continues its motion
-    if(G4UniformRand() < GetDiffusionProbability(aTrack)){
-        return &aParticleChange;
-    }
-    
-    // If the particle is adsorbed, the average adsorption time is summed to the
-    // particle global time, i.e., the particle re-start to travel after a time
-    // equal to the average adsorption time
-    if(G4UniformRand() < GetAdsorptionProbability(aTrack)){
-        
-        G4double adsorptionTime = GetAdsorptionTime(aTrack);
-        aParticleChange.ProposeGlobalTime(aTrack.GetGlobalTime() + adsorptionTime ) ;
-        GetTrackData(aTrack)->SetTimeSticked(adsorptionTime);
-
-        // If the particle is adsorbed and not released, it is killed
-        if(G4UniformRand() < GetFullAdsorptionProbability(aTrack)){
-            aParticleChange.ProposeEnergy(0.);
-            aParticleChange.ProposeTrackStatus(fStopAndKill);
-            return &aParticleChange;
-        }
-        
-        // Get a random kinetic energy following the Maxwell-Boltzmann distribution
-        // theSampledKineticEnergy is computed by the SampleMaxwellBoltzmannKineticEnergy function
-        //SampleMaxwellBoltzmannKineticEnergy(aTrack);
-        //aParticleChange.ProposeEnergy(theSampledKineticEnergy);
-
-        // Compute the outgoing particle direction following the cosine-law (Lambertian) distribution
-        // theGlobalNormal is computed by the SampleLambertianDirection() function
-        SampleLambertianDirection(aTrack);
-        aParticleChange.ProposeMomentumDirection(G4LambertianRand(theGlobalNormal));
- 
-        return &aParticleChange;
-    }
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
 
-    // Compute the outgoing particle direction following the cosine-law (Lambertian) distribution
-    // theGlobalNormal is computed by the SampleLambertianDirection() function
-    SampleLambertianDirection(aTrack);
-    aParticleChange.ProposeMomentumDirection(G4LambertianRand(theGlobalNormal));
-    
-    return &aParticleChange;
+void EffusionProcess::BuildPhysicsTable(const G4ParticleDefinition&){
+    ThermalEnergyTable::Instance()->Build();
 }
 
 //....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
@@ -182,9 +146,9 @@ void EffusionProcess::SampleMaxwellBoltzmannKineticEnergy(const G4Track& aTrack)
     
     sqrtkTm = std::sqrt(CLHEP::k_Boltzmann * aMaterialPost->GetTemperature()*aTrack.GetDefinition()->GetPDGMass());
     
-    thePx = G4RandGauss::shoot(0.,sqrtkTm);
-    thePy = G4RandGauss::shoot(0.,sqrtkTm);
-    thePz = G4RandGauss::shoot(0.,sqrtkTm);
+    thePx = BufferedGauss(0.,sqrtkTm);
+    thePy = BufferedGauss(0.,sqrtkTm);
+    thePz = BufferedGauss(0.,sqrtkTm);
 
     theSampledKineticEnergy = (thePx*thePx+thePy*thePy+thePz*thePz) * 0.5 / aTrack.GetDefinition()->GetPDGMass();
 }
@@ -193,9 +157,25 @@ void EffusionProcess::SampleMaxwellBoltzmannKineticEnergy(const G4Track& aTrack)
 
 void EffusionProcess::SampleLambertianDirection(const G4Track& aTrack){
 
+    // Normal cached by the BallisticTransportation, which does not leave
+    // the navigator able to compute the exit normal
+    EffusionTrackData* trackdata = GetTrackData(aTrack);
+    if(trackdata->HasSurfaceNormal()){
+        theGlobalNormal = trackdata->GetSurfaceNormal();
+        return;
+    }
+
     // Get the Global Point
     G4StepPoint* pPostStepPoint = aTrack.GetStep()->GetPostStepPoint();
     theGlobalPoint = pPostStepPoint->GetPosition();
+    
+    // Closed form normal of the volume entered, the navigator is used only
+    // for the solids not supported by the provider
+    if(fNormalProvider.GetGlobalNormal(pPostStepPoint->GetPhysicalVolume(),
+                                       theGlobalPoint,
+                                       theGlobalNormal)){
+        return;
+    }
  
     // Get Transport Navigator
     G4Navigator* theNavigator = G4TransportationManager::GetTransportationManager()->GetNavigatorForTracking();
@@ -217,26 +197,37 @@ void EffusionProcess::SampleLambertianDirection(const G4Track& aTrack){
 
 //....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
 
-G4double EffusionProcess::GetMeanFreePath(const G4Track&,
+G4double EffusionProcess::GetMeanFreePath(const G4Track& aTrack,
                                           G4double,
                                           G4ForceCondition* condition)
 {
-    *condition = Forced;
+    if(!IsTriggered(aTrack.GetDefinition()) ||
+       aTrack.GetGlobalTime() > fTimeLimit){
+        *condition = Forced;
+    }
+    else{
+        *condition = NotForced;
+    }
     return DBL_MAX;
 }
 
 //....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
 
-G4double EffusionProcess::GetDiffusionProbability(const G4Track&)
+G4bool EffusionProcess::IsTriggered(const G4ParticleDefinition* particle)
 {
-    return 0.;
-}
-
-//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
-
-G4double EffusionProcess::GetAdsorptionProbability(const G4Track&)
-{
-    return 1.;
+    if(particle == fLastDefinition){
+        return bLastTriggered;
+    }
+    std::unordered_map<const G4ParticleDefinition*, G4bool>::iterator it =
+    fTriggered.find(particle);
+    if(it == fTriggered.end()){
+        G4VProcess* transportation = particle->GetProcessManager()->GetProcess("Transportation");
+        G4bool triggered = (dynamic_cast<BallisticTransportation*>(transportation) != 0);
+        it = fTriggered.insert({particle,triggered}).first;
+    }
+    fLastDefinition = particle;
+    bLastTriggered = it->second;
+    return bLastTriggered;
 }
 
 //....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
@@ -265,9 +256,19 @@ G4double EffusionProcess::GetAdsorptionTime(const G4Track& aTrack)
 
 //....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
 
-G4double EffusionProcess::GetFullAdsorptionProbability(const G4Track&)
+EffusionProcess* EffusionProcess::GetEffusionProcess(const G4ParticleDefinition* particle)
 {
-    return 0.;
+    G4ProcessVector* processes = particle->GetProcessManager()->GetProcessList();
+    for(G4int i0=0;i0<G4int(processes->size());i0++){
+        G4VProcess* process = (*processes)[i0];
+        G4BiasingProcessInterface* wrapper = dynamic_cast<G4BiasingProcessInterface*>(process);
+        if(wrapper && wrapper->GetWrappedProcess()){
+            process = wrapper->GetWrappedProcess();
+        }
+        EffusionProcess* effusion = dynamic_cast<EffusionProcess*>(process);
+        if(effusion) return effusion;
+    }
+    return 0;
 }
 
 //....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
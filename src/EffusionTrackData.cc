@@ -27,10 +27,18 @@
 #include "EffusionProcess.hh"
 #include "G4SystemOfUnits.hh"
 
+#ifdef G4MULTITHREADED
+G4ThreadLocal G4Allocator<EffusionTrackData>* EffusionTrackDataAllocator = 0;
+#else
+G4Allocator<EffusionTrackData> EffusionTrackDataAllocator;
+#endif
+
 EffusionTrackData::EffusionTrackData()
 : G4VAuxiliaryTrackInformation(),
 fTimeSticked(0.),
-fTotalTimeSticked(0.){;}
+fTotalTimeSticked(0.),
+fSurfaceNormal(),
+bSurfaceNormal(false){;}
 
 //....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo....
 
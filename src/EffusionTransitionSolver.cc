@@ -0,0 +1,563 @@
+//
+// ********************************************************************
+// * License and Disclaimer                                           *
+// *                                                                  *
+// * The  Geant4 software  is  copyright of the Copyright Holders  of *
+// * the Geant4 Collaboration.  It is provided  under  the terms  and *
+// * conditions of the Geant4 Software License,  included in the file *
+// * LICENSE and available at  http://cern.ch/geant4/license .  These *
+// * include a list of copyright holders.                             *
+// *                                                                  *
+// * Neither the authors of this software system, nor their employing *
+// * institutes,nor the agencies providing financial support for this *
+// * work  make  any representation or  warranty, express or implied, *
+// * regarding  this  software system or assume any liability for its *
+// * use.  Please see the license in the file  LICENSE  and URL above *
+// * for the full disclaimer and the limitation of liability.         *
+// *                                                                  *
+// * This  code  implementation is the result of  the  scientific and *
+// * technical work of the GEANT4 collaboration.                      *
+// * By using,  copying,  modifying or  distributing the software (or *
+// * any work based  on the software)  you  agree  to acknowledge its *
+// * use  in  resulting  scientific  publications,  and indicate your *
+// * acceptance of all terms of the Geant4 Software license.          *
+// ********************************************************************
+//
+//
+/// \file EffusionTransitionSolver.cc
+/// \brief Implementation of the EffusionTransitionSolver class
+
+#include "EffusionTransitionSolver.hh"
+#include "EffusionProcess.hh"
+
+#include "G4TransportationManager.hh"
+#include "G4Navigator.hh"
+#include "G4VPhysicalVolume.hh"
+#include "G4LogicalVolume.hh"
+#include "G4VSolid.hh"
+#include "G4VisExtent.hh"
+#include "G4AffineTransform.hh"
+#include "G4Material.hh"
+#include "G4Element.hh"
+#include "G4GenericIon.hh"
+#include "G4IonTable.hh"
+#include "G4RandomDirection.hh"
+#include "G4RandomTools.hh"
+#include "G4PhysicalConstants.hh"
+#include "G4SystemOfUnits.hh"
+#include "Randomize.hh"
+
+#include <cmath>
+#include <sstream>
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+EffusionTransitionSolver::EffusionTransitionSolver():
+fNavigator(0),
+fDetector(0),
+fColumns(0),
+fSegments(4),
+fRaysPerPatch(10000),
+fKineticEnergy(0.2421 * CLHEP::eV){
+    fMessenger = new G4GenericMessenger(this,
+                                        "/solver/",
+                                        "Transition matrix solver of the effusion" );
+    
+    fMessenger->DeclareProperty("setSegments", fSegments,
+                                "number of patches along the local z of each volume" ).SetToBeBroadcasted(false);
+    fMessenger->DeclareProperty("setRaysPerPatch", fRaysPerPatch,
+                                "number of rays traced from each patch and source" ).SetToBeBroadcasted(false);
+    fMessenger->DeclarePropertyWithUnit("setKineticEnergy", "eV", fKineticEnergy,
+                                        "kinetic energy of the ions" ).SetToBeBroadcasted(false);
+    fMessenger->DeclareMethod("buildTransitions", &EffusionTransitionSolver::BuildTransitions,
+                              "trace the rays of the current geometry" ).SetToBeBroadcasted(false);
+    fMessenger->DeclareMethod("solve", &EffusionTransitionSolver::Solve,
+                              "solve for the ion Z;A" ).SetToBeBroadcasted(false);
+    fMessenger->DeclareMethod("scanAdsorptionTime", &EffusionTransitionSolver::ScanAdsorptionTime,
+                              "solve for the ion Z;A;matZ;min_ns;max_ns;steps" ).SetToBeBroadcasted(false);
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+EffusionTransitionSolver::~EffusionTransitionSolver(){
+    delete fMessenger;
+    delete fNavigator;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void EffusionTransitionSolver::BuildPatches(){
+    fPatches.clear();
+    fFirstPatch.clear();
+    fExtent.clear();
+    fSources.clear();
+    fDetector = 0;
+    
+    G4VPhysicalVolume* world = G4TransportationManager::GetTransportationManager()->
+        GetNavigatorForTracking()->GetWorldVolume();
+    if(!fNavigator){
+        fNavigator = new G4Navigator();
+    }
+    fNavigator->SetWorldVolume(world);
+    
+    // The sensitive detectors live in the worker threads, the detector
+    // and the disks are found by name as in DetectorConstruction
+    G4LogicalVolume* worldLogical = world->GetLogicalVolume();
+    for(size_t i0=0;i0<worldLogical->GetNoDaughters();i0++){
+        G4VPhysicalVolume* volume = worldLogical->GetDaughter(i0);
+        G4LogicalVolume* logical = volume->GetLogicalVolume();
+        const std::string name = logical->GetName();
+        
+        if(name == "Detector.Logic"){
+            fDetector = volume;
+            continue;
+        }
+        // Vacuum envelopes, as the ones of the transfer line, are transparent
+        if(logical->GetMaterial() == worldLogical->GetMaterial()) continue;
+        if(name.compare(0,4,"Disk") == 0){
+            fSources.push_back(volume);
+        }
+        
+        const G4ElementVector* theElementVector = logical->GetMaterial()->GetElementVector();
+        G4int matZ = G4int(std::round((*theElementVector)[0]->GetZ()));
+        
+        G4VisExtent extent = logical->GetSolid()->GetExtent();
+        fFirstPatch[volume] = G4int(fPatches.size());
+        fExtent[volume] = std::make_pair(extent.GetZmin(),extent.GetZmax());
+        for(G4int i1=0;i1<fSegments;i1++){
+            Patch patch;
+            patch.fVolume = volume;
+            patch.fSegment = i1;
+            patch.fMaterialZ = matZ;
+            fPatches.push_back(patch);
+        }
+    }
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+G4int EffusionTransitionSolver::FindPatch(G4VPhysicalVolume* volume,
+                                          const G4ThreeVector& globalPoint) const{
+    auto first = fFirstPatch.find(volume);
+    if(first == fFirstPatch.end()) return kEscaped;
+    
+    G4AffineTransform transform(volume->GetRotation(),volume->GetTranslation());
+    G4ThreeVector localPoint = transform.Inverse().TransformPoint(globalPoint);
+    
+    const std::pair<G4double,G4double>& extent = fExtent.at(volume);
+    G4int segment = G4int((localPoint.z() - extent.first) /
+                          (extent.second - extent.first) * fSegments);
+    segment = std::max(0,std::min(segment,fSegments - 1));
+    return first->second + segment;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+G4int EffusionTransitionSolver::TraceRay(G4ThreeVector point,
+                                         const G4ThreeVector& direction,
+                                         G4double& length){
+    // Same rules of EffusionProcess: a bounce happens when entering a
+    // volume placed in the world with a material different from the
+    // current one, the detector volume has the world material
+    length = 0.;
+    G4VPhysicalVolume* current = fNavigator->LocateGlobalPointAndSetup(point,&direction,false,false);
+    
+    for(G4int i0=0;i0<1000;i0++){
+        if(!current) return kEscaped;
+        
+        G4double safety = 0.;
+        G4double step = fNavigator->ComputeStep(point,direction,kInfinity,safety);
+        if(step == kInfinity) return kEscaped;
+        
+        point += step * direction;
+        length += step;
+        fNavigator->SetGeometricallyLimitedStep();
+        G4VPhysicalVolume* next = fNavigator->LocateGlobalPointAndSetup(point,&direction,true);
+        
+        if(!next) return kEscaped;
+        if(next == fDetector) return kDetector;
+        if(next->GetMotherLogical() != 0 &&
+           next->GetLogicalVolume()->GetMaterial() != current->GetLogicalVolume()->GetMaterial()){
+            return FindPatch(next,point);
+        }
+        current = next;
+    }
+    return kEscaped;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void EffusionTransitionSolver::Tally(size_t row,G4int outcome,G4double length){
+    size_t column = fPatches.size() + 1;
+    if(outcome >= 0){
+        column = size_t(outcome);
+    }
+    else if(outcome == kDetector){
+        column = fPatches.size();
+    }
+    
+    size_t index = row * fColumns + column;
+    fCounts[index] += 1.;
+    fSumLength[index] += length;
+    fSumLength2[index] += length * length;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void EffusionTransitionSolver::BuildTransitions(){
+    BuildPatches();
+    
+    const size_t patches = fPatches.size();
+    const size_t rows = patches + fSources.size();
+    fColumns = patches + 2;
+    fEmitted.assign(rows,0.);
+    fCounts.assign(rows * fColumns,0.);
+    fSumLength.assign(rows * fColumns,0.);
+    fSumLength2.assign(rows * fColumns,0.);
+    
+    const G4double offset = 1.e-6 * CLHEP::mm;
+    const G4int samples = fRaysPerPatch * fSegments;
+    
+    // Lambertian emission from the surface of every volume, the points on
+    // faces in contact with another volume are discarded
+    for(size_t i0=0;i0<patches;i0+=fSegments){
+        G4VPhysicalVolume* volume = fPatches[i0].fVolume;
+        G4VSolid* solid = volume->GetLogicalVolume()->GetSolid();
+        G4AffineTransform transform(volume->GetRotation(),volume->GetTranslation());
+        
+        for(G4int i1=0;i1<samples;i1++){
+            G4ThreeVector localPoint = solid->GetPointOnSurface();
+            G4ThreeVector normal = transform.TransformAxis(solid->SurfaceNormal(localPoint));
+            G4ThreeVector point = transform.TransformPoint(localPoint);
+            G4int patch = FindPatch(volume,point);
+            
+            point += normal * offset;
+            G4VPhysicalVolume* located = fNavigator->LocateGlobalPointAndSetup(point,0,false,true);
+            if(!located || located->GetMotherLogical() != 0) continue;
+            
+            G4double length = 0.;
+            G4int outcome = TraceRay(point,G4LambertianRand(normal),length);
+            fEmitted[patch] += 1.;
+            Tally(patch,outcome,length);
+        }
+    }
+    
+    // Isotropic emission from the inside of the disks, the nuclei fly
+    // through the disk material without interactions
+    for(size_t i0=0;i0<fSources.size();i0++){
+        G4VPhysicalVolume* volume = fSources[i0];
+        G4VSolid* solid = volume->GetLogicalVolume()->GetSolid();
+        G4AffineTransform transform(volume->GetRotation(),volume->GetTranslation());
+        G4VisExtent extent = solid->GetExtent();
+        size_t row = patches + i0;
+        
+        for(G4int i1=0;i1<samples;i1++){
+            G4ThreeVector localPoint;
+            do{
+                localPoint.set(extent.GetXmin() + (extent.GetXmax() - extent.GetXmin()) * G4UniformRand(),
+                               extent.GetYmin() + (extent.GetYmax() - extent.GetYmin()) * G4UniformRand(),
+                               extent.GetZmin() + (extent.GetZmax() - extent.GetZmin()) * G4UniformRand());
+            } while(solid->Inside(localPoint) != kInside);
+            
+            G4double length = 0.;
+            G4int outcome = TraceRay(transform.TransformPoint(localPoint),G4RandomDirection(),length);
+            fEmitted[row] += 1.;
+            Tally(row,outcome,length);
+        }
+    }
+    
+    G4cout << "--- Solver: " << patches << " patches and " << fSources.size()
+    << " sources traced with " << samples << " rays each" << G4endl;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+G4bool EffusionTransitionSolver::Factorize(std::vector<G4double>& a,
+                                           std::vector<size_t>& pivot,
+                                           size_t n){
+    pivot.resize(n);
+    for(size_t k=0;k<n;k++){
+        size_t p = k;
+        for(size_t i=k+1;i<n;i++){
+            if(std::fabs(a[i*n+k]) > std::fabs(a[p*n+k])) p = i;
+        }
+        pivot[k] = p;
+        if(a[p*n+k] == 0.) return false;
+        if(p != k){
+            for(size_t j=0;j<n;j++) std::swap(a[k*n+j],a[p*n+j]);
+        }
+        
+        // Rank-one update of the trailing rows, contiguous in memory
+        const G4double* rowK = &a[k*n];
+        for(size_t i=k+1;i<n;i++){
+            G4double* rowI = &a[i*n];
+            G4double f = rowI[k] / rowK[k];
+            rowI[k] = f;
+            if(f == 0.) continue;
+            for(size_t j=k+1;j<n;j++){
+                rowI[j] -= f * rowK[j];
+            }
+        }
+    }
+    return true;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void EffusionTransitionSolver::Substitute(const std::vector<G4double>& lu,
+                                          const std::vector<size_t>& pivot,
+                                          size_t n,
+                                          std::vector<G4double>& b,
+                                          size_t k){
+    // All the right-hand sides are processed together, row by row
+    for(size_t i=0;i<n;i++){
+        if(pivot[i] != i){
+            for(size_t j=0;j<k;j++) std::swap(b[i*k+j],b[pivot[i]*k+j]);
+        }
+    }
+    for(size_t i=0;i<n;i++){
+        G4double* rowI = &b[i*k];
+        for(size_t m=0;m<i;m++){
+            const G4double f = lu[i*n+m];
+            if(f == 0.) continue;
+            const G4double* rowM = &b[m*k];
+            for(size_t j=0;j<k;j++) rowI[j] -= f * rowM[j];
+        }
+    }
+    for(size_t i=n;i-->0;){
+        G4double* rowI = &b[i*k];
+        for(size_t m=i+1;m<n;m++){
+            const G4double f = lu[i*n+m];
+            if(f == 0.) continue;
+            const G4double* rowM = &b[m*k];
+            for(size_t j=0;j<k;j++) rowI[j] -= f * rowM[j];
+        }
+        const G4double d = lu[i*n+i];
+        for(size_t j=0;j<k;j++) rowI[j] /= d;
+    }
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+std::vector<EffusionTransitionSolver::Solution>
+EffusionTransitionSolver::SolveChain(G4int Z,G4int A,
+                                     const std::vector<G4double>& adsorptionTime) const{
+    const size_t n = fPatches.size();
+    const size_t detector = n;
+    
+    G4double mass = G4IonTable::GetIonTable()->GetIonMass(Z,A);
+    G4double velocity = CLHEP::c_light * std::sqrt(2. * fKineticEnergy / mass);
+    G4double lambda = 0.;
+    G4ParticleDefinition* ion = G4IonTable::GetIonTable()->GetIon(Z,A);
+    if(ion && ion->GetPDGLifeTime() > 0.){
+        lambda = 1. / ion->GetPDGLifeTime();
+    }
+    
+    // Per transition: probability, first and second moment of the delay
+    // (flight plus adsorption at the patch hit) and mean decay factor,
+    // the latter from the first two cumulants of the flight time
+    auto probability = [&](size_t row,size_t column){
+        if(fEmitted[row] <= 0.) return 0.;
+        return fCounts[row * fColumns + column] / fEmitted[row];
+    };
+    auto flight1 = [&](size_t row,size_t column){
+        size_t index = row * fColumns + column;
+        if(fCounts[index] <= 0.) return 0.;
+        return fSumLength[index] / fCounts[index] / velocity;
+    };
+    auto flight2 = [&](size_t row,size_t column){
+        size_t index = row * fColumns + column;
+        if(fCounts[index] <= 0.) return 0.;
+        return fSumLength2[index] / fCounts[index] / (velocity * velocity);
+    };
+    auto delay1 = [&](size_t row,size_t column){
+        G4double tau = column < n ? adsorptionTime[column] : 0.;
+        return flight1(row,column) + tau;
+    };
+    auto delay2 = [&](size_t row,size_t column){
+        G4double tau = column < n ? adsorptionTime[column] : 0.;
+        G4double t1 = flight1(row,column);
+        return flight2(row,column) + 2. * tau * t1 + tau * tau;
+    };
+    auto survival = [&](size_t row,size_t column){
+        G4double tau = column < n ? adsorptionTime[column] : 0.;
+        G4double t1 = flight1(row,column);
+        G4double variance = std::max(flight2(row,column) - t1 * t1,0.);
+        return std::exp(-lambda * (t1 + tau) + 0.5 * lambda * lambda * variance);
+    };
+
+    // (I - Q) with and without decay
+    std::vector<G4double> chain(n * n,0.);
+    std::vector<G4double> chainDecay(n * n,0.);
+    for(size_t i=0;i<n;i++){
+        chain[i*n+i] = 1.;
+        chainDecay[i*n+i] = 1.;
+        for(size_t j=0;j<n;j++){
+            G4double q = probability(i,j);
+            if(q == 0.) continue;
+            chain[i*n+j] -= q;
+            chainDecay[i*n+j] -= q * survival(i,j);
+        }
+    }
+    
+    std::vector<size_t> pivot;
+    std::vector<size_t> pivotDecay;
+    if(!Factorize(chain,pivot,n) || !Factorize(chainDecay,pivotDecay,n)){
+        G4Exception("EffusionTransitionSolver::SolveChain",
+                    "eff0005",
+                    JustWarning,
+                    "Singular transition matrix, increase the number of rays.");
+        return std::vector<Solution>();
+    }
+    
+    // Release probability p, and with the decay g, share the factorization
+    // of their own matrix; the moments need the previous solution
+    std::vector<G4double> p(n);
+    std::vector<G4double> g(n);
+    for(size_t i=0;i<n;i++){
+        p[i] = probability(i,detector);
+        g[i] = probability(i,detector) * survival(i,detector);
+    }
+    Substitute(chain,pivot,n,p,1);
+    Substitute(chainDecay,pivotDecay,n,g,1);
+    
+    std::vector<G4double> m(n);
+    for(size_t i=0;i<n;i++){
+        m[i] = probability(i,detector) * flight1(i,detector);
+        for(size_t j=0;j<n;j++){
+            G4double q = probability(i,j);
+            if(q != 0.) m[i] += q * delay1(i,j) * p[j];
+        }
+    }
+    Substitute(chain,pivot,n,m,1);
+
+    std::vector<G4double> s(n);
+    for(size_t i=0;i<n;i++){
+        s[i] = probability(i,detector) * flight2(i,detector);
+        for(size_t j=0;j<n;j++){
+            G4double q = probability(i,j);
+            if(q != 0.) s[i] += q * (delay2(i,j) * p[j] + 2. * delay1(i,j) * m[j]);
+        }
+    }
+    Substitute(chain,pivot,n,s,1);
+    
+    // First step from the sources
+    std::vector<Solution> solutions;
+    for(size_t i0=0;i0<fSources.size();i0++){
+        size_t row = n + i0;
+        G4double release = probability(row,detector);
+        G4double first = release * flight1(row,detector);
+        G4double second = release * flight2(row,detector);
+        G4double releaseDecay = release * survival(row,detector);
+        for(size_t j=0;j<n;j++){
+            G4double q = probability(row,j);
+            if(q == 0.) continue;
+            release += q * p[j];
+            first += q * (delay1(row,j) * p[j] + m[j]);
+            second += q * (delay2(row,j) * p[j] + 2. * delay1(row,j) * m[j] + s[j]);
+            releaseDecay += q * survival(row,j) * g[j];
+        }
+        
+        Solution solution;
+        solution.fRelease = release;
+        solution.fMeanDelay = release > 0. ? first / release : 0.;
+        solution.fSigmaDelay = release > 0. ?
+            std::sqrt(std::max(second / release - solution.fMeanDelay * solution.fMeanDelay,0.)) : 0.;
+        solution.fReleaseWithDecay = releaseDecay;
+        solutions.push_back(solution);
+    }
+    return solutions;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void EffusionTransitionSolver::PrintSolutions(G4int Z,G4int A,
+                                              const std::vector<Solution>& solutions) const{
+    for(size_t i0=0;i0<solutions.size();i0++){
+        G4cout << "--- Solver: A = " << A << " Z = " << Z
+        << " disk " << fSources[i0]->GetCopyNo()
+        << " release " << solutions[i0].fRelease
+        << " with decay " << solutions[i0].fReleaseWithDecay
+        << " delay " << solutions[i0].fMeanDelay / CLHEP::s
+        << " +- " << solutions[i0].fSigmaDelay / CLHEP::s << " s" << G4endl;
+    }
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void EffusionTransitionSolver::Solve(std::string s){
+    if (s==""){return;}
+    if(fEmitted.empty()){
+        BuildTransitions();
+    }
+    
+    const char delimiter = ';';
+    std::vector<std::string> tokens;
+    std::string token;
+    std::istringstream tokenStream(s);
+    while (std::getline(tokenStream, token, delimiter)){
+        tokens.push_back(token);
+    }
+    if(tokens.size() < 2){return;}
+    G4int Z = std::stoi(tokens[0]);
+    G4int A = std::stoi(tokens[1]);
+    
+    EffusionProcess* effusion = EffusionProcess::GetEffusionProcess(G4GenericIon::GenericIon());
+    std::vector<G4double> adsorptionTime(fPatches.size(),0.);
+    for(size_t i0=0;i0<fPatches.size();i0++){
+        if(effusion){
+            adsorptionTime[i0] = effusion->GetAdsorptionTime(Z,fPatches[i0].fMaterialZ);
+        }
+    }
+    
+    PrintSolutions(Z,A,SolveChain(Z,A,adsorptionTime));
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void EffusionTransitionSolver::ScanAdsorptionTime(std::string s){
+    if (s==""){return;}
+    if(fEmitted.empty()){
+        BuildTransitions();
+    }
+    
+    const char delimiter = ';';
+    std::vector<std::string> tokens;
+    std::string token;
+    std::istringstream tokenStream(s);
+    while (std::getline(tokenStream, token, delimiter)){
+        tokens.push_back(token);
+    }
+    if(tokens.size() < 6){return;}
+    G4int Z = std::stoi(tokens[0]);
+    G4int A = std::stoi(tokens[1]);
+    G4int matZ = std::stoi(tokens[2]);
+    G4double minTime = std::stod(tokens[3]) * CLHEP::ns;
+    G4double maxTime = std::stod(tokens[4]) * CLHEP::ns;
+    G4int steps = std::max(std::stoi(tokens[5]),1);
+    
+    EffusionProcess* effusion = EffusionProcess::GetEffusionProcess(G4GenericIon::GenericIon());
+    std::vector<G4double> adsorptionTime(fPatches.size(),0.);
+    for(size_t i0=0;i0<fPatches.size();i0++){
+        if(effusion){
+            adsorptionTime[i0] = effusion->GetAdsorptionTime(Z,fPatches[i0].fMaterialZ);
+        }
+    }
+    
+    for(G4int i1=0;i1<steps;i1++){
+        G4double tau = minTime;
+        if(steps > 1 && minTime > 0.){
+            tau = minTime * std::pow(maxTime / minTime,G4double(i1) / (steps - 1));
+        }
+        for(size_t i0=0;i0<fPatches.size();i0++){
+            if(fPatches[i0].fMaterialZ == matZ){
+                adsorptionTime[i0] = tau;
+            }
+        }
+        G4cout << "--- Solver: adsorption time on Z = " << matZ << " "
+        << tau / CLHEP::ns << " ns" << G4endl;
+        PrintSolutions(Z,A,SolveChain(Z,A,adsorptionTime));
+    }
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
@@ -44,6 +44,8 @@
 #include "TargetSensitiveDetectorHit.hh"
 
 #include "Analysis.hh"
+#include "RandomVariateBuffer.hh"
+#include "TrackingAction.hh"
 
 EventAction::EventAction()
 {
@@ -59,7 +61,20 @@ EventAction::~EventAction(){}
 
 //....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo....
 
-void EventAction::BeginOfEventAction(const G4Event*){}
+void EventAction::BeginOfEventAction(const G4Event*){
+    // The variates left by the previous event depend on its seeds
+    if(bUSE_RANDOM_BUFFER){
+        RandomVariateBuffer::Instance()->Reset();
+    }
+    
+    // The track maps of the previous event, also when it belonged to an
+    // earlier run or checkpoint chunk with the same event ID
+    TrackingAction* trackingAction =
+        dynamic_cast<TrackingAction*>(G4EventManager::GetEventManager()->GetUserTrackingAction());
+    if(trackingAction){
+        trackingAction->ClearEvent();
+    }
+}
 
 //....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo....
 
@@ -107,6 +122,8 @@ void EventAction::EndOfEventAction(const G4Event* evt){
             analysisManager->FillNtupleDColumn(0,0, aHit->GetTime()/CLHEP::s);
             analysisManager->FillNtupleDColumn(0,1, aHit->GetA());
             analysisManager->FillNtupleDColumn(0,2, aHit->GetZ());
+            analysisManager->FillNtupleDColumn(0,3, aHit->GetIon());
+            analysisManager->FillNtupleDColumn(0,4, aHit->GetWeight());
             analysisManager->AddNtupleRow(0);
         }
     }
@@ -126,6 +143,8 @@ void EventAction::EndOfEventAction(const G4Event* evt){
                 analysisManager->FillNtupleDColumn(1,5, aHit->GetWorldPos().x());
                 analysisManager->FillNtupleDColumn(1,6, aHit->GetWorldPos().y());
                 analysisManager->FillNtupleDColumn(1,7, aHit->GetWorldPos().z());
+                analysisManager->FillNtupleDColumn(1,8, aHit->GetIon());
+                analysisManager->FillNtupleDColumn(1,9, aHit->GetWeight());
                 analysisManager->AddNtupleRow(1);
             }
             
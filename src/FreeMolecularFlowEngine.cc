@@ -0,0 +1,400 @@
+//
+// ********************************************************************
+// * License and Disclaimer                                           *
+// *                                                                  *
+// * The  Geant4 software  is  copyright of the Copyright Holders  of *
+// * the Geant4 Collaboration.  It is provided  under  the terms  and *
+// * conditions of the Geant4 Software License,  included in the file *
+// * LICENSE and available at  http://cern.ch/geant4/license .  These *
+// * include a list of copyright holders.                             *
+// *                                                                  *
+// * Neither the authors of this software system, nor their employing *
+// * institutes,nor the agencies providing financial support for this *
+// * work  make  any representation or  warranty, express or implied, *
+// * regarding  this  software system or assume any liability for its *
+// * use.  Please see the license in the file  LICENSE  and URL above *
+// * for the full disclaimer and the limitation of liability.         *
+// *                                                                  *
+// * This  code  implementation is the result of  the  scientific and *
+// * technical work of the GEANT4 collaboration.                      *
+// * By using,  copying,  modifying or  distributing the software (or *
+// * any work based  on the software)  you  agree  to acknowledge its *
+// * use  in  resulting  scientific  publications,  and indicate your *
+// * acceptance of all terms of the Geant4 Software license.          *
+// ********************************************************************
+//
+//
+/// \file FreeMolecularFlowEngine.cc
+/// \brief Implementation of the FreeMolecularFlowEngine class
+
+#include "FreeMolecularFlowEngine.hh"
+#include "EffusionProcess.hh"
+#include "Run.hh"
+
+#include "G4TransportationManager.hh"
+#include "G4Navigator.hh"
+#include "G4VPhysicalVolume.hh"
+#include "G4LogicalVolume.hh"
+#include "G4VSolid.hh"
+#include "G4VisExtent.hh"
+#include "G4AffineTransform.hh"
+#include "G4GenericIon.hh"
+#include "G4IonTable.hh"
+#include "G4ParticleDefinition.hh"
+#include "G4RandomDirection.hh"
+#include "G4RandomTools.hh"
+#include "G4PhysicalConstants.hh"
+#include "G4SystemOfUnits.hh"
+#include "Randomize.hh"
+
+#include <cfloat>
+#include <chrono>
+#include <cmath>
+#include <iomanip>
+#include <sstream>
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+const G4double FreeMolecularFlowEngine::fSurfaceOffset = 1.e-7 * CLHEP::mm;
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+FreeMolecularFlowEngine::FreeMolecularFlowEngine():
+bImported(false),
+fVelocity(0.),
+fLifeTime(-1.),
+fLanes(0),
+fResult(0),
+fBounces(0.),
+fRun(0),
+fBatchSize(1024),
+fKineticEnergy(0.2421 * CLHEP::eV){
+    fMessenger = new G4GenericMessenger(this,
+                                        "/fmf/",
+                                        "Standalone free molecular flow in the target" );
+    
+    fMessenger->DeclareProperty("setBatchSize", fBatchSize,
+                                "number of ions transported together" ).SetToBeBroadcasted(false);
+    fMessenger->DeclarePropertyWithUnit("setKineticEnergy", "eV", fKineticEnergy,
+                                        "kinetic energy of the ions" ).SetToBeBroadcasted(false);
+    fMessenger->DeclareMethod("simulate", &FreeMolecularFlowEngine::Simulate,
+                              "simulate Z;A;number of ions;disk (-1 for all the disks)" ).SetToBeBroadcasted(false);
+    fMessenger->DeclareMethod("validate", &FreeMolecularFlowEngine::Validate,
+                              "simulate Z;A;number of ions;disk and compare with the last run" ).SetToBeBroadcasted(false);
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+FreeMolecularFlowEngine::~FreeMolecularFlowEngine(){
+    delete fMessenger;
+    delete fResult;
+    delete fRun;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void FreeMolecularFlowEngine::SetRun(const Run* aRun){
+    delete fRun;
+    fRun = new Run();
+    fRun->Accumulate(aRun);
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void FreeMolecularFlowEngine::Simulate(std::string s){
+    if (s==""){return;}
+    const char delimiter = ';';
+    std::vector<std::string> tokens;
+    std::string token;
+    std::istringstream tokenStream(s);
+    while (std::getline(tokenStream, token, delimiter)){
+        tokens.push_back(token);
+    }
+    if(tokens.size() < 3){return;}
+    G4int disk = tokens.size() > 3 ? std::stoi(tokens[3]) : -1;
+    Transport(std::stoi(tokens[0]),std::stoi(tokens[1]),std::stol(tokens[2]),disk);
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+G4bool FreeMolecularFlowEngine::Transport(G4int Z,G4int A,G4long nIons,G4int disk){
+    if(!bImported){
+        if(!fGeometry.Import()) return false;
+        
+        G4VPhysicalVolume* world = G4TransportationManager::GetTransportationManager()->
+            GetNavigatorForTracking()->GetWorldVolume();
+        G4LogicalVolume* worldLogical = world->GetLogicalVolume();
+        for(size_t i0=0;i0<worldLogical->GetNoDaughters();i0++){
+            G4VPhysicalVolume* volume = worldLogical->GetDaughter(i0);
+            G4LogicalVolume* logical = volume->GetLogicalVolume();
+            if(logical->GetName().compare(0,4,"Disk") == 0){
+                fSources.push_back(volume);
+                fSourceVolume.push_back(logical->GetSolid()->GetCubicVolume());
+            }
+        }
+        bImported = true;
+    }
+    if(fSources.empty()) return false;
+    
+    G4ParticleDefinition* ion = G4IonTable::GetIonTable()->GetIon(Z,A);
+    if(!ion){
+        G4ExceptionDescription ed;
+        ed << "Unknown ion Z = " << Z << " A = " << A << G4endl;
+        G4Exception("FreeMolecularFlowEngine::Transport",
+                    "eff0008",
+                    JustWarning,
+                    ed);
+        return false;
+    }
+    fVelocity = CLHEP::c_light * std::sqrt(2. * fKineticEnergy / ion->GetPDGMass());
+    fLifeTime = ion->GetPDGStable() ? -1. : ion->GetPDGLifeTime();
+    
+    EffusionProcess* effusion = EffusionProcess::GetEffusionProcess(G4GenericIon::GenericIon());
+    const size_t nSolids = fGeometry.GetNumberOfSolids();
+    fAdsorptionTime.assign(nSolids,0.);
+    for(size_t i0=0;i0<nSolids;i0++){
+        if(effusion){
+            fAdsorptionTime[i0] = effusion->GetAdsorptionTime(Z,fGeometry.GetSolid(i0).fMaterialZ);
+        }
+    }
+    
+    delete fResult;
+    fResult = new Run();
+    fBounces = 0.;
+    
+    const size_t batch = size_t(std::max(fBatchSize,1));
+    fCode.resize(batch);
+    fX.resize(batch); fY.resize(batch); fZ.resize(batch);
+    fU.resize(batch); fV.resize(batch); fW.resize(batch);
+    fTime.resize(batch);
+    fDecayTime.resize(batch);
+    fDistance.resize(batch);
+    fHit.resize(batch);
+    fNx.resize(batch); fNy.resize(batch); fNz.resize(batch);
+    
+    G4long started = 0;
+    fLanes = 0;
+    while(fLanes < batch && started < nIons){
+        Generate(fLanes++,Z,A,disk);
+        started++;
+    }
+    
+    auto start = std::chrono::steady_clock::now();
+    
+    while(fLanes > 0){
+        fGeometry.Intersect(fLanes,
+                            fX.data(),fY.data(),fZ.data(),
+                            fU.data(),fV.data(),fW.data(),
+                            fDistance.data(),fHit.data(),
+                            fNx.data(),fNy.data(),fNz.data());
+        
+        // Backwards, so that the lane moved by Release() is already done
+        for(size_t i0=fLanes;i0-->0;){
+            // Stays 0 for the ions reaching the detector
+            G4int reason = 0;
+            G4double time = fTime[i0];
+            const G4int hit = fHit[i0];
+            
+            if(hit < 0){
+                reason = Run::kEscaped;
+            }
+            else{
+                G4double arrival = time + fDistance[i0] / fVelocity;
+                if(arrival > fDecayTime[i0]){
+                    reason = Run::kDecayed;
+                    time = fDecayTime[i0];
+                }
+                else if(fGeometry.GetSolid(hit).bDetector){
+                    fResult->fArrivalTime[fCode[i0]].Fill(arrival);
+                    fResult->fArrivalHistogram[fCode[i0]].Fill(arrival);
+                }
+                else{
+                    fX[i0] += fDistance[i0] * fU[i0];
+                    fY[i0] += fDistance[i0] * fV[i0];
+                    fZ[i0] += fDistance[i0] * fW[i0];
+                    time = arrival + fAdsorptionTime[hit];
+                    fBounces += 1.;
+                    
+                    if(time > fDecayTime[i0]){
+                        reason = Run::kDecayed;
+                        time = fDecayTime[i0];
+                    }
+                    else if(time > EffusionProcess::fTimeLimit){
+                        reason = Run::kTimeLimit;
+                    }
+                    else{
+                        G4ThreeVector normal(fNx[i0],fNy[i0],fNz[i0]);
+                        G4ThreeVector direction = G4LambertianRand(normal);
+                        fU[i0] = direction.x();
+                        fV[i0] = direction.y();
+                        fW[i0] = direction.z();
+                        fX[i0] += fSurfaceOffset * normal.x();
+                        fY[i0] += fSurfaceOffset * normal.y();
+                        fZ[i0] += fSurfaceOffset * normal.z();
+                        fTime[i0] = time;
+                        continue;
+                    }
+                }
+            }
+            
+            if(reason > 0){
+                fResult->FillTermination(reason,fCode[i0],time);
+            }
+            if(started < nIons){
+                Generate(i0,Z,A,disk);
+                started++;
+            }
+            else{
+                Release(i0);
+            }
+        }
+    }
+    
+    std::chrono::duration<G4double> elapsed = std::chrono::steady_clock::now() - start;
+    
+    G4int code = fResult->GetCode(A,Z,-1);
+    G4cout << "--- Free molecular flow of Z = " << Z << " A = " << A << ": "
+    << fResult->GetGenerated(code) << " ions, "
+    << fResult->GetReleased(code) << " released, "
+    << fBounces << " bounces in " << elapsed.count() << " s ("
+    << (elapsed.count() > 0. ? fBounces / elapsed.count() : 0.) << " bounces/s)" << G4endl;
+    fResult->PrintArrivalTimeSummary();
+    return true;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void FreeMolecularFlowEngine::Generate(size_t lane,G4int Z,G4int A,G4int disk){
+    size_t source = 0;
+    if(disk >= 0){
+        for(size_t i0=0;i0<fSources.size();i0++){
+            if(fSources[i0]->GetCopyNo() == disk) source = i0;
+        }
+    }
+    else{
+        G4double total = 0.;
+        for(auto volume : fSourceVolume) total += volume;
+        G4double random = total * G4UniformRand();
+        while(source + 1 < fSources.size() && random >= fSourceVolume[source]){
+            random -= fSourceVolume[source];
+            source++;
+        }
+    }
+    
+    G4VPhysicalVolume* volume = fSources[source];
+    G4VSolid* solid = volume->GetLogicalVolume()->GetSolid();
+    G4VisExtent extent = solid->GetExtent();
+    G4ThreeVector localPoint;
+    do{
+        localPoint.set(extent.GetXmin() + (extent.GetXmax() - extent.GetXmin()) * G4UniformRand(),
+                       extent.GetYmin() + (extent.GetYmax() - extent.GetYmin()) * G4UniformRand(),
+                       extent.GetZmin() + (extent.GetZmax() - extent.GetZmin()) * G4UniformRand());
+    } while(solid->Inside(localPoint) != kInside);
+    
+    // Straight flight out of the disk
+    G4ThreeVector localDirection = G4RandomDirection();
+    G4double length = solid->DistanceToOut(localPoint,localDirection);
+    G4AffineTransform transform(volume->GetRotation(),volume->GetTranslation());
+    G4ThreeVector position = transform.TransformPoint(localPoint + (length + fSurfaceOffset) * localDirection);
+    G4ThreeVector direction = transform.TransformAxis(localDirection);
+    
+    fCode[lane] = fResult->GetCode(A,Z,volume->GetCopyNo());
+    fResult->AddGenerated(fCode[lane]);
+    fX[lane] = position.x();
+    fY[lane] = position.y();
+    fZ[lane] = position.z();
+    fU[lane] = direction.x();
+    fV[lane] = direction.y();
+    fW[lane] = direction.z();
+    fTime[lane] = length / fVelocity;
+    fDecayTime[lane] = fLifeTime > 0. ? - fLifeTime * std::log(1. - G4UniformRand()) : DBL_MAX;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void FreeMolecularFlowEngine::Release(size_t lane){
+    const size_t last = --fLanes;
+    if(lane == last) return;
+    fCode[lane] = fCode[last];
+    fX[lane] = fX[last];
+    fY[lane] = fY[last];
+    fZ[lane] = fZ[last];
+    fU[lane] = fU[last];
+    fV[lane] = fV[last];
+    fW[lane] = fW[last];
+    fTime[lane] = fTime[last];
+    fDecayTime[lane] = fDecayTime[last];
+    fDistance[lane] = fDistance[last];
+    fHit[lane] = fHit[last];
+    fNx[lane] = fNx[last];
+    fNy[lane] = fNy[last];
+    fNz[lane] = fNz[last];
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void FreeMolecularFlowEngine::Validate(std::string s){
+    if(!fRun){
+        G4Exception("FreeMolecularFlowEngine::Validate",
+                    "eff0008",
+                    JustWarning,
+                    "No Geant4 run to compare with.");
+        return;
+    }
+    
+    const char delimiter = ';';
+    std::vector<std::string> tokens;
+    std::string token;
+    std::istringstream tokenStream(s);
+    while (std::getline(tokenStream, token, delimiter)){
+        tokens.push_back(token);
+    }
+    if(tokens.size() < 3){return;}
+    G4int Z = std::stoi(tokens[0]);
+    G4int A = std::stoi(tokens[1]);
+    G4int disk = tokens.size() > 3 ? std::stoi(tokens[3]) : -1;
+    if(!Transport(Z,A,std::stol(tokens[2]),disk)) return;
+    
+    G4int code = fRun->GetCode(A,Z,-1);
+    if(fRun->GetGenerated(code) == 0){
+        G4cout << "--- Validation: no nuclei Z = " << Z << " A = " << A
+        << " generated in the last run" << G4endl;
+        return;
+    }
+    
+    // Difference in units of the combined statistical error
+    auto compare = [](const G4String& name,G4double g4,G4double g4Error,
+                      G4double engine,G4double engineError,G4double unit){
+        // The relative errors are DBL_MAX without enough entries
+        G4bool valid = g4Error < DBL_MAX && engineError < DBL_MAX;
+        G4double g4Sigma = valid ? g4 * g4Error : 0.;
+        G4double engineSigma = valid ? engine * engineError : 0.;
+        G4double sigma = std::sqrt(g4Sigma * g4Sigma + engineSigma * engineSigma);
+        G4double pull = sigma > 0. ? (engine - g4) / sigma : 0.;
+        G4cout << std::setw(16) << name
+        << std::setw(12) << g4 / unit
+        << std::setw(12) << g4Sigma / unit
+        << std::setw(12) << engine / unit
+        << std::setw(12) << engineSigma / unit
+        << std::setw(9) << pull << G4endl;
+    };
+    
+    G4cout << G4endl << "--------------- Validation of the free molecular flow, Z = "
+    << Z << " A = " << A << " ---------------" << G4endl;
+    G4cout << "        quantity      Geant4       error      engine       error     pull" << G4endl;
+    std::ios::fmtflags flags = G4cout.flags();
+    std::streamsize precision = G4cout.precision(4);
+    compare("release fraction",
+            fRun->GetReleaseFraction(code),fRun->GetReleaseRelativeError(code),
+            fResult->GetReleaseFraction(code),fResult->GetReleaseRelativeError(code),1.);
+    compare("mean time [s]",
+            fRun->GetMeanArrivalTime(code),fRun->GetMeanArrivalTimeRelativeError(code),
+            fResult->GetMeanArrivalTime(code),fResult->GetMeanArrivalTimeRelativeError(code),CLHEP::s);
+    compare("median time [s]",
+            fRun->GetMedianArrivalTime(code),fRun->GetMedianArrivalTimeRelativeError(code),
+            fResult->GetMedianArrivalTime(code),fResult->GetMedianArrivalTimeRelativeError(code),CLHEP::s);
+    G4cout.flags(flags);
+    G4cout.precision(precision);
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
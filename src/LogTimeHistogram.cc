@@ -0,0 +1,220 @@
+//
+// ********************************************************************
+// * License and Disclaimer                                           *
+// *                                                                  *
+// * The  Geant4 software  is  copyright of the Copyright Holders  of *
+// * the Geant4 Collaboration.  It is provided  under  the terms  and *
+// * conditions of the Geant4 Software License,  included in the file *
+// * LICENSE and available at  http://cern.ch/geant4/license .  These *
+// * include a list of copyright holders.                             *
+// *                                                                  *
+// * Neither the authors of this software system, nor their employing *
+// * institutes,nor the agencies providing financial support for this *
+// * work  make  any representation or  warranty, express or implied, *
+// * regarding  this  software system or assume any liability for its *
+// * use.  Please see the license in the file  LICENSE  and URL above *
+// * for the full disclaimer and the limitation of liability.         *
+// *                                                                  *
+// * This  code  implementation is the result of  the  scientific and *
+// * technical work of the GEANT4 collaboration.                      *
+// * By using,  copying,  modifying or  distributing the software (or *
+// * any work based  on the software)  you  agree  to acknowledge its *
+// * use  in  resulting  scientific  publications,  and indicate your *
+// * acceptance of all terms of the Geant4 Software license.          *
+// ********************************************************************
+//
+//
+/// \file LogTimeHistogram.cc
+/// \brief Implementation of the LogTimeHistogram class
+
+#include "LogTimeHistogram.hh"
+#include "G4SystemOfUnits.hh"
+
+#include <cmath>
+#include <cstdint>
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+LogTimeHistogram::LogTimeHistogram():
+fEntries(0),
+fContents(GetNumberOfBins() + 2,0.)
+{ }
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+LogTimeHistogram::~LogTimeHistogram()
+{ }
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+G4double LogTimeHistogram::GetMinTime()
+{
+    return 1. * CLHEP::ns;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+G4double LogTimeHistogram::GetMaxTime()
+{
+    return GetMinTime() * std::pow(10.,fDecades);
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+G4double LogTimeHistogram::GetBinLowEdge(G4int bin)
+{
+    // Bin 0 is the underflow, bin GetNumberOfBins()+1 the overflow
+    if(bin <= 0) return 0.;
+    return GetMinTime() * std::pow(10.,G4double(bin - 1) / fBinsPerDecade);
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+G4int LogTimeHistogram::FindBin(G4double time)
+{
+    if(time < GetMinTime()) return 0;
+    G4int bin = 1 + G4int(std::floor(std::log10(time / GetMinTime()) * fBinsPerDecade));
+    if(bin > GetNumberOfBins()) return GetNumberOfBins() + 1;
+    return bin;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void LogTimeHistogram::Fill(G4double time, G4double weight)
+{
+    fContents[FindBin(time)] += weight;
+    fEntries++;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void LogTimeHistogram::Merge(const LogTimeHistogram& right)
+{
+    for(size_t i0=0;i0<fContents.size();i0++){
+        fContents[i0] += right.fContents[i0];
+    }
+    fEntries += right.fEntries;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+G4double LogTimeHistogram::GetSumOfWeights() const
+{
+    G4double sum = 0.;
+    for(auto content : fContents){
+        sum += content;
+    }
+    return sum;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+G4double LogTimeHistogram::GetQuantile(G4double q) const
+{
+    G4double total = GetSumOfWeights();
+    if(total <= 0.) return 0.;
+    
+    G4double target = q * total;
+    G4double sum = 0.;
+    for(size_t i0=0;i0<fContents.size();i0++){
+        if(fContents[i0] <= 0. || sum + fContents[i0] < target){
+            sum += fContents[i0];
+            continue;
+        }
+        if(i0 == 0) return GetMinTime();
+        if(i0 == fContents.size() - 1) return GetMaxTime();
+        G4double fraction = (target - sum) / fContents[i0];
+        return GetBinLowEdge(G4int(i0)) * std::pow(10.,fraction / fBinsPerDecade);
+    }
+    return GetMaxTime();
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+G4double LogTimeHistogram::GetIntegral(G4double time) const
+{
+    // The underflow counts as below any time, the overflow as above
+    G4int bin = FindBin(time);
+    if(bin == 0) return fContents[0];
+    G4double sum = 0.;
+    for(G4int i0=0;i0<bin;i0++){
+        sum += fContents[i0];
+    }
+    if(bin > GetNumberOfBins()) return sum;
+    G4double fraction = std::log10(time / GetBinLowEdge(bin)) * fBinsPerDecade;
+    return sum + fContents[bin] * fraction;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void LogTimeHistogram::Write(std::ostream& out) const
+{
+    size_t filled = 0;
+    for(auto content : fContents){
+        if(content != 0.) filled++;
+    }
+    out << fEntries << " " << filled;
+    for(size_t i0=0;i0<fContents.size();i0++){
+        if(fContents[i0] != 0.){
+            out << " " << i0 << " " << fContents[i0];
+        }
+    }
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+G4bool LogTimeHistogram::Read(std::istream& in)
+{
+    size_t filled = 0;
+    in >> fEntries >> filled;
+    for(size_t i0=0;i0<filled;i0++){
+        size_t bin = 0;
+        G4double content = 0.;
+        in >> bin >> content;
+        if(in.fail() || bin >= fContents.size()) return false;
+        fContents[bin] = content;
+    }
+    return !in.fail();
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void LogTimeHistogram::WriteBinary(std::ostream& out) const
+{
+    int64_t entries = fEntries;
+    uint16_t filled = 0;
+    for(auto content : fContents){
+        if(content != 0.) filled++;
+    }
+    out.write(reinterpret_cast<const char*>(&entries),sizeof(entries));
+    out.write(reinterpret_cast<const char*>(&filled),sizeof(filled));
+    for(size_t i0=0;i0<fContents.size();i0++){
+        if(fContents[i0] != 0.){
+            uint16_t bin = uint16_t(i0);
+            out.write(reinterpret_cast<const char*>(&bin),sizeof(bin));
+            out.write(reinterpret_cast<const char*>(&fContents[i0]),sizeof(G4double));
+        }
+    }
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+G4bool LogTimeHistogram::ReadBinary(std::istream& in)
+{
+    int64_t entries = 0;
+    uint16_t filled = 0;
+    in.read(reinterpret_cast<char*>(&entries),sizeof(entries));
+    in.read(reinterpret_cast<char*>(&filled),sizeof(filled));
+    fEntries = entries;
+    for(size_t i0=0;i0<filled;i0++){
+        uint16_t bin = 0;
+        G4double content = 0.;
+        in.read(reinterpret_cast<char*>(&bin),sizeof(bin));
+        in.read(reinterpret_cast<char*>(&content),sizeof(content));
+        if(in.fail() || bin >= fContents.size()) return false;
+        fContents[bin] = content;
+    }
+    return !in.fail();
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
@@ -0,0 +1,171 @@
+//
+// ********************************************************************
+// * License and Disclaimer                                           *
+// *                                                                  *
+// * The  Geant4 software  is  copyright of the Copyright Holders  of *
+// * the Geant4 Collaboration.  It is provided  under  the terms  and *
+// * conditions of the Geant4 Software License,  included in the file *
+// * LICENSE and available at  http://cern.ch/geant4/license .  These *
+// * include a list of copyright holders.                             *
+// *                                                                  *
+// * Neither the authors of this software system, nor their employing *
+// * institutes,nor the agencies providing financial support for this *
+// * work  make  any representation or  warranty, express or implied, *
+// * regarding  this  software system or assume any liability for its *
+// * use.  Please see the license in the file  LICENSE  and URL above *
+// * for the full disclaimer and the limitation of liability.         *
+// *                                                                  *
+// * This  code  implementation is the result of  the  scientific and *
+// * technical work of the GEANT4 collaboration.                      *
+// * By using,  copying,  modifying or  distributing the software (or *
+// * any work based  on the software)  you  agree  to acknowledge its *
+// * use  in  resulting  scientific  publications,  and indicate your *
+// * acceptance of all terms of the Geant4 Software license.          *
+// ********************************************************************
+//
+//
+/// \file MomentAccumulator.cc
+/// \brief Implementation of the MomentAccumulator class
+
+#include "MomentAccumulator.hh"
+
+#include <cmath>
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+MomentAccumulator::MomentAccumulator():
+fEntries(0),
+fSumW(0.),
+fSumW2(0.),
+fMean(0.),
+fM2(0.),
+fM3(0.),
+fM4(0.)
+{ }
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+MomentAccumulator::~MomentAccumulator()
+{ }
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void MomentAccumulator::Fill(G4double x, G4double weight)
+{
+    if(weight <= 0.) return;
+    
+    // Merge with an accumulator holding the single value x
+    G4double sumW = fSumW + weight;
+    G4double delta = x - fMean;
+    G4double deltaW = delta * weight / sumW;
+    G4double term = delta * deltaW * fSumW;
+    
+    fMean += deltaW;
+    fM4 += term * deltaW * deltaW * (fSumW * fSumW - fSumW * weight + weight * weight) / (weight * weight)
+        + 6. * deltaW * deltaW * fM2
+        - 4. * deltaW * fM3;
+    fM3 += term * deltaW * (fSumW - weight) / weight
+        - 3. * deltaW * fM2;
+    fM2 += term;
+
+    fSumW = sumW;
+    fSumW2 += weight * weight;
+    fEntries++;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void MomentAccumulator::Merge(const MomentAccumulator& right)
+{
+    if(right.fSumW <= 0.) return;
+    if(fSumW <= 0.){
+        *this = right;
+        return;
+    }
+    
+    G4double wA = fSumW;
+    G4double wB = right.fSumW;
+    G4double w = wA + wB;
+    G4double delta = right.fMean - fMean;
+    G4double delta2 = delta * delta;
+    
+    G4double m2 = fM2 + right.fM2 + delta2 * wA * wB / w;
+    G4double m3 = fM3 + right.fM3
+        + delta2 * delta * wA * wB * (wA - wB) / (w * w)
+        + 3. * delta * (wA * right.fM2 - wB * fM2) / w;
+    G4double m4 = fM4 + right.fM4
+        + delta2 * delta2 * wA * wB * (wA * wA - wA * wB + wB * wB) / (w * w * w)
+        + 6. * delta2 * (wA * wA * right.fM2 + wB * wB * fM2) / (w * w)
+        + 4. * delta * (wA * right.fM3 - wB * fM3) / w;
+    
+    fMean += delta * wB / w;
+    fM2 = m2;
+    fM3 = m3;
+    fM4 = m4;
+    fSumW = w;
+    fSumW2 += right.fSumW2;
+    fEntries += right.fEntries;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+G4double MomentAccumulator::GetEffectiveEntries() const
+{
+    if(fSumW2 <= 0.) return 0.;
+    return fSumW * fSumW / fSumW2;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+G4double MomentAccumulator::GetVariance() const
+{
+    // Unbiased estimator for reliability weights, equal to M2/(n-1)
+    // for unit weights
+    G4double denominator = fSumW - fSumW2 / fSumW;
+    if(fSumW <= 0. || denominator <= 0.) return 0.;
+    return fM2 / denominator;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+G4double MomentAccumulator::GetMeanError() const
+{
+    G4double entries = GetEffectiveEntries();
+    if(entries <= 0.) return 0.;
+    return std::sqrt(GetVariance() / entries);
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+G4double MomentAccumulator::GetSkewness() const
+{
+    if(fM2 <= 0.) return 0.;
+    return std::sqrt(fSumW) * fM3 / std::pow(fM2,1.5);
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+G4double MomentAccumulator::GetKurtosis() const
+{
+    // Excess kurtosis
+    if(fM2 <= 0.) return 0.;
+    return fSumW * fM4 / (fM2 * fM2) - 3.;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void MomentAccumulator::Write(std::ostream& out) const
+{
+    out << fEntries << " " << fSumW << " " << fSumW2 << " "
+    << fMean << " " << fM2 << " " << fM3 << " " << fM4;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+G4bool MomentAccumulator::Read(std::istream& in)
+{
+    in >> fEntries >> fSumW >> fSumW2 >> fMean >> fM2 >> fM3 >> fM4;
+    return !in.fail();
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
@@ -37,12 +37,15 @@
 
 //....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
 
-PhysicsList::PhysicsList():G4VModularPhysicsList(){
+PhysicsList::PhysicsList(G4bool lean):G4VModularPhysicsList(){
   SetVerboseLevel(2);
 
-  RegisterPhysics(new G4DecayPhysics(0));
+  // The decay of the unstable particles is not needed for the release
+  if(!lean){
+    RegisterPhysics(new G4DecayPhysics(0));
+  }
   RegisterPhysics(new G4RadioactiveDecayPhysics(1));
-  RegisterPhysics(new EffusionPhysicsList());
+  RegisterPhysics(new EffusionPhysicsList(1,lean));
 }
 
 //....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
@@ -29,23 +29,226 @@
 //....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
 
 #include "PrimaryGeneratorAction.hh"
+#include "StratifiedSource.hh"
+#include "PrimaryParticleInformation.hh"
+#include "QuasiRandomSequence.hh"
+#include "CommonRandomNumbers.hh"
+
+#include "G4GenericMessenger.hh"
+#include "G4Event.hh"
+#include "G4PrimaryVertex.hh"
+#include "G4PrimaryParticle.hh"
+#include "G4SingleParticleSource.hh"
+#include "G4SPSPosDistribution.hh"
+#include "G4SPSAngDistribution.hh"
+#include "G4PhysicalConstants.hh"
+#include "G4ParticleDefinition.hh"
+#include "G4SystemOfUnits.hh"
+#include "G4RunManager.hh"
+#include "G4Run.hh"
+#include "Randomize.hh"
+
+#include <algorithm>
 
 //....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
 
 PrimaryGeneratorAction::PrimaryGeneratorAction(){
     fParticleGPS = new G4GeneralParticleSource();
+    
+    fIonsPerEvent = 1;
+    fMessenger = new G4GenericMessenger(this,
+                                        "/primary/",
+                                        "Primary generator control");
+    fMessenger->DeclareProperty("setIonsPerEvent",
+                                fIonsPerEvent,
+                                "Number of ions generated in each event.");
+    fMessenger->DeclareMethod("loadVertices",
+                              &PrimaryGeneratorAction::LoadVertices,
+                              "Sample the primary vertices from a vertex file.");
+    bVerticesChecked = false;
+    
+    fProductionYield = 0.;
+    fSimulatedIons = 0.;
+    fMessenger->DeclareProperty("setProductionYield",
+                                fProductionYield,
+                                "Production yield of the isotope, each ion is weighted with yield / simulated ions, 0 for unit weights.");
+    fMessenger->DeclareProperty("setSimulatedIons",
+                                fSimulatedIons,
+                                "Ions sharing the production yield, 0 for the ions of the current run.");
+    
+    fStratified = new StratifiedSource();
+    fQuasiRandom = new QuasiRandomSequence();
+    bQuasiRandomWarned = false;
 }
 
 //....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
 
 PrimaryGeneratorAction::~PrimaryGeneratorAction(){
     delete fParticleGPS;
+    delete fMessenger;
+    delete fStratified;
+    delete fQuasiRandom;
 }
 
 //....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
 
 void PrimaryGeneratorAction::GeneratePrimaries(G4Event* anEvent){
-    fParticleGPS->GeneratePrimaryVertex(anEvent);
+    const G4Run* run = G4RunManager::GetRunManager()->GetCurrentRun();
+    G4long runIons = G4long(run->GetNumberOfEventToBeProcessed()) * fIonsPerEvent;
+    
+    // Paired runs: the source of the event has its own stream, whatever the
+    // thread and the events processed before
+    CommonRandomNumbers* crn = CommonRandomNumbers::Instance();
+    if(crn->IsActive()){
+        crn->Reseed(crn->GetKey(anEvent->GetEventID(),CommonRandomNumbers::kSource,0));
+    }
+    
+    // In the weighted mode the yield of the isotope is shared among the
+    // simulated ions, the statistics no longer follows the production
+    G4double weight = 1.;
+    if(fProductionYield > 0.){
+        G4double ions = fSimulatedIons;
+        if(ions <= 0.){
+            ions = G4double(runIons);
+        }
+        weight = fProductionYield / ions;
+    }
+    
+    for(G4int i = 0; i < fIonsPerEvent; i++){
+        fParticleGPS->GeneratePrimaryVertex(anEvent);
+        G4PrimaryVertex* vertex = anEvent->GetPrimaryVertex(anEvent->GetNumberOfPrimaryVertex() - 1);
+        G4PrimaryParticle* primary = vertex->GetPrimary();
+        G4long index = G4long(anEvent->GetEventID()) * fIonsPerEvent + i;
+        
+        // Quasi-random point of the ion for the position and the direction,
+        // the transport keeps the pseudo-random engine
+        G4double point[QuasiRandomSequence::fDimensions];
+        G4int replicate = -1;
+        if(fQuasiRandom->IsActive()){
+            G4long offset = QuasiRandomSequence::GetEventOffset() * fIonsPerEvent;
+            replicate = fQuasiRandom->GetPoint(offset + index,point);
+        }
+        
+        // The stratum follows from the global index of the ion, the Run
+        // finds it in the information of the primary
+        G4int stratum = -1;
+        if(fStratified->IsActive()){
+            stratum = fStratified->GetStratum(index,runIons);
+        }
+        // With a vertex file the records of the stratum are drawn with
+        // their weight, which is then already in the share of the stratum
+        const VertexFile::Record* stratumRecord = nullptr;
+        if(stratum >= 0){
+            stratumRecord = fStratified->SampleRecord(stratum,replicate >= 0 ? point[0] : G4UniformRand());
+        }
+        if(stratumRecord != nullptr){
+            vertex->SetPosition(stratumRecord->fPosition[0] * CLHEP::mm,
+                                stratumRecord->fPosition[1] * CLHEP::mm,
+                                stratumRecord->fPosition[2] * CLHEP::mm);
+            vertex->SetT0(stratumRecord->fTime * CLHEP::ns);
+        }
+        else if(stratum >= 0){
+            G4ThreeVector position = fStratified->SamplePosition(stratum,replicate >= 0 ? point : nullptr);
+            vertex->SetPosition(position.x(),position.y(),position.z());
+        }
+        // The vertices are drawn uniformly and carry their own weight
+        else if(fVertices.IsOpen()){
+            G4long entries = fVertices.GetNumberOfRecords();
+            G4long entry = std::min(G4long(G4UniformRand() * entries),entries - 1);
+            const VertexFile::Record& record = fVertices.GetRecord(entry);
+            vertex->SetPosition(record.fPosition[0] * CLHEP::mm,
+                                record.fPosition[1] * CLHEP::mm,
+                                record.fPosition[2] * CLHEP::mm);
+            vertex->SetT0(record.fTime * CLHEP::ns);
+            vertex->SetWeight(vertex->GetWeight() * record.fWeight);
+        }
+        else if(replicate >= 0){
+            SetQuasiRandomPosition(vertex,point);
+        }
+        if(replicate >= 0){
+            SetQuasiRandomDirection(primary,point + 3);
+        }
+        if(stratum >= 0 || replicate >= 0){
+            G4double share = (stratum >= 0) ? fStratified->GetShare(stratum) : 1.;
+            primary->SetUserInformation(new PrimaryParticleInformation(stratum,share,replicate));
+        }
+        if(weight != 1.){
+            vertex->SetWeight(vertex->GetWeight() * weight);
+        }
+    }
+    
+    if(fVertices.IsOpen() && !bVerticesChecked){
+        bVerticesChecked = true;
+        G4ParticleDefinition* particle = fParticleGPS->GetParticleDefinition();
+        if(particle->GetAtomicMass()*1000 + particle->GetAtomicNumber() !=
+           fVertices.GetCode() % 1000000){
+            G4Exception("PrimaryGeneratorAction::GeneratePrimaries",
+                        "eff0010",
+                        JustWarning,
+                        "The vertex file belongs to another isotope.");
+        }
+    }
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void PrimaryGeneratorAction::SetQuasiRandomPosition(G4PrimaryVertex* vertex,const G4double* u){
+    // Uniform cylinder of the release macros, along z as the GPS default
+    G4SPSPosDistribution* position = fParticleGPS->GetCurrentSource()->GetPosDist();
+    if(position->GetPosDisType() == "Point"){
+        return;
+    }
+    if(position->GetPosDisType() != "Volume" || position->GetPosDisShape() != "Cylinder"){
+        WarnQuasiRandom("position");
+        return;
+    }
+    G4double r = position->GetRadius() * std::sqrt(u[0]);
+    G4double phi = CLHEP::twopi * u[1];
+    G4double z = position->GetHalfZ() * (2. * u[2] - 1.);
+    G4ThreeVector point = position->GetCentreCoords() + G4ThreeVector(r * std::cos(phi),r * std::sin(phi),z);
+    vertex->SetPosition(point.x(),point.y(),point.z());
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void PrimaryGeneratorAction::SetQuasiRandomDirection(G4PrimaryParticle* primary,const G4double* u){
+    G4SPSAngDistribution* angular = fParticleGPS->GetCurrentSource()->GetAngDist();
+    if(angular->GetDistType() != "iso"){
+        WarnQuasiRandom("direction");
+        return;
+    }
+    G4double cosTheta = 1. - 2. * u[0];
+    G4double sinTheta = std::sqrt(std::max(0.,1. - cosTheta * cosTheta));
+    G4double phi = CLHEP::twopi * u[1];
+    primary->SetMomentumDirection(G4ThreeVector(sinTheta * std::cos(phi),
+                                                sinTheta * std::sin(phi),
+                                                cosTheta));
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void PrimaryGeneratorAction::WarnQuasiRandom(const G4String& what){
+    if(bQuasiRandomWarned){
+        return;
+    }
+    bQuasiRandomWarned = true;
+    G4Exception("PrimaryGeneratorAction::GeneratePrimaries",
+                "eff0012",
+                JustWarning,
+                ("Quasi-random " + what + " not supported for this GPS source, the GPS sampling is kept.").c_str());
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void PrimaryGeneratorAction::LoadVertices(std::string fileName){
+    bVerticesChecked = false;
+    G4bool opened = fVertices.Open(fileName);
+    fStratified->SetVertices(fVertices.IsOpen() ? &fVertices : nullptr);
+    if(opened){
+        G4cout << "--- PrimaryGeneratorAction: " << fVertices.GetNumberOfRecords()
+        << " vertices of isotope code " << fVertices.GetCode()
+        << " from " << fileName << G4endl;
+    }
 }
 
 
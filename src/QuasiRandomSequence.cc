@@ -0,0 +1,109 @@
+//
+// ********************************************************************
+// * License and Disclaimer                                           *
+// *                                                                  *
+// * The  Geant4 software  is  copyright of the Copyright Holders  of *
+// * the Geant4 Collaboration.  It is provided  under  the terms  and *
+// * conditions of the Geant4 Software License,  included in the file *
+// * LICENSE and available at  http://cern.ch/geant4/license .  These *
+// * include a list of copyright holders.                             *
+// *                                                                  *
+// * Neither the authors of this software system, nor their employing *
+// * institutes,nor the agencies providing financial support for this *
+// * work  make  any representation or  warranty, express or implied, *
+// * regarding  this  software system or assume any liability for its *
+// * use.  Please see the license in the file  LICENSE  and URL above *
+// * for the full disclaimer and the limitation of liability.         *
+// *                                                                  *
+// * This  code  implementation is the result of  the  scientific and *
+// * technical work of the GEANT4 collaboration.                      *
+// * By using,  copying,  modifying or  distributing the software (or *
+// * any work based  on the software)  you  agree  to acknowledge its *
+// * use  in  resulting  scientific  publications,  and indicate your *
+// * acceptance of all terms of the Geant4 Software license.          *
+// ********************************************************************
+//
+//
+/// \file QuasiRandomSequence.cc
+/// \brief Implementation of the QuasiRandomSequence class
+
+#include "QuasiRandomSequence.hh"
+
+#include <algorithm>
+#include <cmath>
+
+namespace
+{
+    const G4int kPrimes[QuasiRandomSequence::fDimensions] = {2,3,5,7,11};
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+G4long QuasiRandomSequence::fEventOffset = 0;
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+QuasiRandomSequence::QuasiRandomSequence():
+bActive(false),
+fReplicates(16),
+fSeed(1){
+    fMessenger = new G4GenericMessenger(this,
+                                        "/qmc/",
+                                        "Randomized quasi-Monte Carlo sampling of the primary ions" );
+    
+    fMessenger->DeclareProperty("setActive", bActive,
+                                "sample the position and direction of the primaries from shifted Halton points" );
+    fMessenger->DeclareProperty("setReplicates", fReplicates,
+                                "number of independently shifted replicates for the error estimate" );
+    fMessenger->DeclareProperty("setSeed", fSeed,
+                                "seed of the random shifts" );
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+QuasiRandomSequence::~QuasiRandomSequence(){
+    delete fMessenger;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+G4int QuasiRandomSequence::GetPoint(G4long index,G4double* point) const{
+    G4int replicates = std::max(fReplicates,1);
+    G4int replicate = G4int(index % replicates);
+    // The first point of the sequence is the origin, it is skipped
+    uint64_t sequence = uint64_t(index / replicates) + 1;
+    for(G4int i0=0;i0<fDimensions;i0++){
+        G4double u = RadicalInverse(sequence,kPrimes[i0]) + GetShift(replicate,i0);
+        point[i0] = u - std::floor(u);
+    }
+    return replicate;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+G4double QuasiRandomSequence::RadicalInverse(uint64_t index,G4int base){
+    G4double inverse = 1. / base;
+    G4double factor = inverse;
+    G4double value = 0.;
+    while(index > 0){
+        value += (index % base) * factor;
+        index /= base;
+        factor *= inverse;
+    }
+    return value;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+G4double QuasiRandomSequence::GetShift(G4int replicate,G4int dimension) const{
+    // SplitMix64 finalizer of seed, replicate and dimension, the same in
+    // every thread without touching the random engine
+    uint64_t z = (uint64_t(uint32_t(fSeed)) << 32) ^
+        (uint64_t(replicate) * fDimensions + dimension + 1) * 0x9E3779B97F4A7C15ULL;
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+    z = z ^ (z >> 31);
+    return (z >> 11) * (1. / 9007199254740992.);
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
@@ -0,0 +1,120 @@
+//
+// ********************************************************************
+// * License and Disclaimer                                           *
+// *                                                                  *
+// * The  Geant4 software  is  copyright of the Copyright Holders  of *
+// * the Geant4 Collaboration.  It is provided  under  the terms  and *
+// * conditions of the Geant4 Software License,  included in the file *
+// * LICENSE and available at  http://cern.ch/geant4/license .  These *
+// * include a list of copyright holders.                             *
+// *                                                                  *
+// * Neither the authors of this software system, nor their employing *
+// * institutes,nor the agencies providing financial support for this *
+// * work  make  any representation or  warranty, express or implied, *
+// * regarding  this  software system or assume any liability for its *
+// * use.  Please see the license in the file  LICENSE  and URL above *
+// * for the full disclaimer and the limitation of liability.         *
+// *                                                                  *
+// * This  code  implementation is the result of  the  scientific and *
+// * technical work of the GEANT4 collaboration.                      *
+// * By using,  copying,  modifying or  distributing the software (or *
+// * any work based  on the software)  you  agree  to acknowledge its *
+// * use  in  resulting  scientific  publications,  and indicate your *
+// * acceptance of all terms of the Geant4 Software license.          *
+// ********************************************************************
+//
+//
+/// \file RandomVariateBuffer.cc
+/// \brief Implementation of the RandomVariateBuffer class
+
+#include "RandomVariateBuffer.hh"
+
+#include "G4PhysicalConstants.hh"
+
+#include <algorithm>
+#include <cmath>
+
+G4ThreadLocal RandomVariateBuffer* RandomVariateBuffer::fInstance = 0;
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+RandomVariateBuffer* RandomVariateBuffer::Instance(){
+    if(!fInstance){
+        fInstance = new RandomVariateBuffer();
+    }
+    return fInstance;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+RandomVariateBuffer::RandomVariateBuffer(){
+    Reset();
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+RandomVariateBuffer::~RandomVariateBuffer(){;}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void RandomVariateBuffer::Reset(){
+    fNextUniform = fBlockSize;
+    fNextGauss = fBlockSize;
+    fNextIsotropic = fBlockSize;
+    fNextLambertian = fBlockSize;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void RandomVariateBuffer::FillUniform(){
+    G4Random::getTheEngine()->flatArray(fBlockSize,fUniform);
+    fNextUniform = 0;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void RandomVariateBuffer::FillGauss(){
+    // Box-Muller, 1-u in the logarithm as some engines can return 0
+    const G4int half = fBlockSize / 2;
+    G4Random::getTheEngine()->flatArray(fBlockSize,fFlat);
+    for(G4int i0=0;i0<half;i0++){
+        G4double r = std::sqrt(-2. * std::log(1. - fFlat[i0]));
+        G4double phi = CLHEP::twopi * fFlat[half + i0];
+        fGauss[i0] = r * std::cos(phi);
+        fGauss[half + i0] = r * std::sin(phi);
+    }
+    fNextGauss = 0;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void RandomVariateBuffer::FillIsotropic(){
+    G4Random::getTheEngine()->flatArray(2*fBlockSize,fFlat);
+    for(G4int i0=0;i0<fBlockSize;i0++){
+        G4double cost = 1. - 2. * fFlat[i0];
+        G4double sint = std::sqrt(std::max(0.,(1. - cost) * (1. + cost)));
+        G4double phi = CLHEP::twopi * fFlat[fBlockSize + i0];
+        fIsotropicX[i0] = sint * std::cos(phi);
+        fIsotropicY[i0] = sint * std::sin(phi);
+        fIsotropicZ[i0] = cost;
+    }
+    fNextIsotropic = 0;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void RandomVariateBuffer::FillLambertian(){
+    // cos(theta)^2 is uniform for the cosine law
+    G4Random::getTheEngine()->flatArray(2*fBlockSize,fFlat);
+    for(G4int i0=0;i0<fBlockSize;i0++){
+        G4double cost = std::sqrt(fFlat[i0]);
+        G4double sint = std::sqrt(1. - fFlat[i0]);
+        G4double phi = CLHEP::twopi * fFlat[fBlockSize + i0];
+        fLambertianX[i0] = sint * std::cos(phi);
+        fLambertianY[i0] = sint * std::sin(phi);
+        fLambertianZ[i0] = cost;
+    }
+    fNextLambertian = 0;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
@@ -38,14 +38,29 @@
 #include "G4HCofThisEvent.hh"
 #include "G4THitsMap.hh"
 #include "G4SystemOfUnits.hh"
+#include "G4ios.hh"
 #include "G4SDManager.hh"
 #include "TargetSensitiveDetectorHit.hh"
+#include "PrimaryParticleInformation.hh"
+#include "G4PrimaryVertex.hh"
+#include "G4PrimaryParticle.hh"
+
+#include <algorithm>
+#include <cstdint>
+#include <fstream>
+#include <cfloat>
+#include <iomanip>
+#include <map>
+#include <set>
 
 //....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
 
 Run::Run()
  : G4Run(),
 fUCx_ID(-1),
+fTelescope_ID(-1),
+bRecordVertices(false),
+bRecordOutcomes(false),
 fIsotopes(0.)
 { }
 
@@ -68,9 +83,16 @@ void Run::RecordEvent(const G4Event* event)
             fUCx_ID = SDman->GetCollectionID(sdName="ucx/collection");
         }
     }
+    if(fTelescope_ID == -1) {
+        G4String sdName;
+        if(SDman->FindSensitiveDetector(sdName="telescope",0)){
+            fTelescope_ID = SDman->GetCollectionID(sdName="telescope/collection");
+        }
+    }
 
     G4HCofThisEvent * HCE = event->GetHCofThisEvent();
     TargetSensitiveDetectorHitsCollection* fUCx = 0;
+    TargetSensitiveDetectorHitsCollection* fTelescope = 0;
 
     if(HCE)
     {
@@ -78,16 +100,33 @@ void Run::RecordEvent(const G4Event* event)
             G4VHitsCollection* aHCUCx = HCE->GetHC(fUCx_ID);
             fUCx = (TargetSensitiveDetectorHitsCollection*)(aHCUCx);
         }
+        if(fTelescope_ID != -1){
+            G4VHitsCollection* aHCTelescope = HCE->GetHC(fTelescope_ID);
+            fTelescope = (TargetSensitiveDetectorHitsCollection*)(aHCTelescope);
+        }
     }
     
     
+    // Disk where each track of the event has been produced
+    std::map<int,int> origin;
+
     if(fUCx)
     {
         int n_hit_sd = fUCx->entries();
         for(int i1=0;i1<n_hit_sd;i1++)
         {
             TargetSensitiveDetectorHit* aHit = (*fUCx)[i1];
-            fIsotopes[GetCode(aHit->GetA(),aHit->GetZ(),aHit->GetDiskNumber())] += 1;
+            AddGenerated(GetCode(aHit->GetA(),aHit->GetZ(),aHit->GetDiskNumber()),aHit->GetWeight());
+            origin[aHit->GetTrackID()] = aHit->GetDiskNumber();
+            if(bRecordVertices && aHit->GetA() > 0 && aHit->GetZ() > 0){
+                VertexFile::Record record;
+                record.fPosition[0] = aHit->GetWorldPos().x() / CLHEP::mm;
+                record.fPosition[1] = aHit->GetWorldPos().y() / CLHEP::mm;
+                record.fPosition[2] = aHit->GetWorldPos().z() / CLHEP::mm;
+                record.fWeight = aHit->GetWeight();
+                record.fTime = aHit->GetTime() / CLHEP::ns;
+                fVertices[GetCode(aHit->GetA(),aHit->GetZ(),aHit->GetDiskNumber())].push_back(record);
+            }
 //            auto search = fIsotopes.find(GetCode(aHit->GetA(),aHit->GetZ(),aHit->GetDiskNumber()));
 //
 //            if(search != fIsotopes.end()) {
@@ -100,6 +139,77 @@ void Run::RecordEvent(const G4Event* event)
         }
     }
 
+    // Stratum and replicate of the primary ions of a stratified or
+    // quasi-random source, by track ID
+    std::map<int,const PrimaryParticleInformation*> sampling;
+    // Outcome of each primary ion, by track ID
+    std::map<int,size_t> outcome;
+    for(G4int i1=0;i1<event->GetNumberOfPrimaryVertex();i1++){
+        G4PrimaryVertex* vertex = event->GetPrimaryVertex(i1);
+        G4PrimaryParticle* primary = vertex->GetPrimary();
+        for(;primary;primary=primary->GetNext()){
+            if(bRecordOutcomes){
+                CommonRandomNumbers::Outcome record;
+                record.fPair = CommonRandomNumbers::Instance()->GetPair();
+                record.fEvent = event->GetEventID();
+                record.fIon = primary->GetTrackID();
+                record.fWeight = vertex->GetWeight() * primary->GetWeight();
+                record.fTime = -1.;
+                outcome[primary->GetTrackID()] = fOutcomes.size();
+                fOutcomes.push_back(record);
+            }
+            const PrimaryParticleInformation* info =
+                dynamic_cast<const PrimaryParticleInformation*>(primary->GetUserInformation());
+            if(!info) continue;
+            sampling[primary->GetTrackID()] = info;
+            if(info->GetStratum() >= 0){
+                fStratumShare[info->GetStratum()] = info->GetShare();
+                fStratumGenerated[info->GetStratum()] += 1;
+            }
+            if(info->GetReplicate() >= 0){
+                fReplicateGenerated[info->GetReplicate()] += 1;
+            }
+        }
+    }
+
+    // A track crossing the telescope more than once is released only once,
+    // the arrival time is the one of the first crossing
+    if(fTelescope)
+    {
+        std::set<int> released;
+        int n_hit_sd = fTelescope->entries();
+        for(int i1=0;i1<n_hit_sd;i1++)
+        {
+            TargetSensitiveDetectorHit* aHit = (*fTelescope)[i1];
+            if(!released.insert(aHit->GetTrackID()).second) continue;
+            
+            G4int disk = -1;
+            auto search = origin.find(aHit->GetTrackID());
+            if(search != origin.end()) disk = search->second;
+            G4int code = GetCode(aHit->GetA(),aHit->GetZ(),disk);
+            fArrivalTime[code].Fill(aHit->GetTime(),aHit->GetWeight());
+            fArrivalHistogram[code].Fill(aHit->GetTime(),aHit->GetWeight());
+            
+            if(aHit->GetTrackID() == aHit->GetIon()){
+                auto search = outcome.find(aHit->GetIon());
+                if(search != outcome.end()){
+                    fOutcomes[search->second].fTime = aHit->GetTime();
+                }
+            }
+            
+            auto primary = sampling.find(aHit->GetIon());
+            if(primary != sampling.end()){
+                const PrimaryParticleInformation* info = primary->second;
+                if(info->GetStratum() >= 0){
+                    fStratumReleased[GetStratumCode(info->GetStratum(),code % 1000000)] += 1;
+                }
+                if(info->GetReplicate() >= 0){
+                    fReplicateReleased[GetReplicateCode(info->GetReplicate(),code % 1000000)] += 1;
+                }
+            }
+        }
+    }
+
    
   G4Run::RecordEvent(event);      
 }  
@@ -110,11 +220,713 @@ void Run::Merge(const G4Run* aRun)
 {
   const Run* localRun = static_cast<const Run*>(aRun);
     
-    for (auto it : localRun->fIsotopes){
-        fIsotopes[it.first] += it.second;
+    Accumulate(localRun);
+    for (auto& it : localRun->fVertices){
+        fVertices[it.first].insert(fVertices[it.first].end(),
+                                   it.second.begin(),it.second.end());
     }
+    fOutcomes.insert(fOutcomes.end(),localRun->fOutcomes.begin(),localRun->fOutcomes.end());
 
   G4Run::Merge(aRun); 
 } 
 
 //....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void Run::Accumulate(const Run* aRun)
+{
+    for (auto it : aRun->fIsotopes){
+        fIsotopes[it.first] += it.second;
+    }
+    for (auto it : aRun->fIsotopesWeight){
+        fIsotopesWeight[it.first] += it.second;
+    }
+    for (auto it : aRun->fStratumShare){
+        fStratumShare[it.first] = it.second;
+    }
+    for (auto it : aRun->fStratumGenerated){
+        fStratumGenerated[it.first] += it.second;
+    }
+    for (auto it : aRun->fStratumReleased){
+        fStratumReleased[it.first] += it.second;
+    }
+    for (auto it : aRun->fReplicateGenerated){
+        fReplicateGenerated[it.first] += it.second;
+    }
+    for (auto it : aRun->fReplicateReleased){
+        fReplicateReleased[it.first] += it.second;
+    }
+    for (auto& it : aRun->fArrivalTime){
+        fArrivalTime[it.first].Merge(it.second);
+    }
+    for (auto& it : aRun->fArrivalHistogram){
+        fArrivalHistogram[it.first].Merge(it.second);
+    }
+    for (auto& it : aRun->fTerminationHistogram){
+        fTerminationHistogram[it.first].Merge(it.second);
+    }
+    for (auto& it : aRun->fCompartmentHistogram){
+        fCompartmentHistogram[it.first].Merge(it.second);
+    }
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void Run::WriteCheckpoint(std::ostream& out) const
+{
+    out << "isotopes " << fIsotopes.size() << std::endl;
+    for (auto it : fIsotopes){
+        out << it.first << " " << it.second << std::endl;
+    }
+    out << "isotopesweight " << fIsotopesWeight.size() << std::endl;
+    for (auto it : fIsotopesWeight){
+        out << it.first << " " << it.second << std::endl;
+    }
+    out << "stratumshare " << fStratumShare.size() << std::endl;
+    for (auto it : fStratumShare){
+        out << it.first << " " << it.second << std::endl;
+    }
+    out << "stratumgenerated " << fStratumGenerated.size() << std::endl;
+    for (auto it : fStratumGenerated){
+        out << it.first << " " << it.second << std::endl;
+    }
+    out << "stratumreleased " << fStratumReleased.size() << std::endl;
+    for (auto it : fStratumReleased){
+        out << it.first << " " << it.second << std::endl;
+    }
+    out << "replicategenerated " << fReplicateGenerated.size() << std::endl;
+    for (auto it : fReplicateGenerated){
+        out << it.first << " " << it.second << std::endl;
+    }
+    out << "replicatereleased " << fReplicateReleased.size() << std::endl;
+    for (auto it : fReplicateReleased){
+        out << it.first << " " << it.second << std::endl;
+    }
+    out << "arrival " << fArrivalTime.size() << std::endl;
+    for (auto& it : fArrivalTime){
+        out << it.first << " ";
+        it.second.Write(out);
+        out << std::endl;
+    }
+    out << "arrivalhistogram " << fArrivalHistogram.size() << std::endl;
+    for (auto& it : fArrivalHistogram){
+        out << it.first << " ";
+        it.second.Write(out);
+        out << std::endl;
+    }
+    out << "terminationhistogram " << fTerminationHistogram.size() << std::endl;
+    for (auto& it : fTerminationHistogram){
+        out << it.first << " ";
+        it.second.Write(out);
+        out << std::endl;
+    }
+    out << "compartmenthistogram " << fCompartmentHistogram.size() << std::endl;
+    for (auto& it : fCompartmentHistogram){
+        out << it.first << " ";
+        it.second.Write(out);
+        out << std::endl;
+    }
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+G4bool Run::ReadCheckpoint(std::istream& in)
+{
+    std::string key;
+    size_t entries = 0;
+    // The checkpoints written before the weighted tallies have unit weights
+    std::unordered_map<int,int> counts;
+    G4bool weights = false;
+    
+    while(in >> key){
+        if(key == "isotopes"){
+            in >> entries;
+            for(size_t i0=0;i0<entries;i0++){
+                int code = 0;
+                int count = 0;
+                in >> code >> count;
+                fIsotopes[code] += count;
+                counts[code] += count;
+            }
+        }
+        else if(key == "isotopesweight"){
+            in >> entries;
+            for(size_t i0=0;i0<entries;i0++){
+                int code = 0;
+                G4double weight = 0.;
+                in >> code >> weight;
+                fIsotopesWeight[code] += weight;
+            }
+            weights = true;
+        }
+        else if(key == "stratumshare"){
+            in >> entries;
+            for(size_t i0=0;i0<entries;i0++){
+                int code = 0;
+                G4double share = 0.;
+                in >> code >> share;
+                fStratumShare[code] = share;
+            }
+        }
+        else if(key == "stratumgenerated" || key == "stratumreleased" ||
+                key == "replicategenerated" || key == "replicatereleased"){
+            std::unordered_map<int,int>& tally =
+                (key == "stratumgenerated") ? fStratumGenerated :
+                (key == "stratumreleased") ? fStratumReleased :
+                (key == "replicategenerated") ? fReplicateGenerated : fReplicateReleased;
+            in >> entries;
+            for(size_t i0=0;i0<entries;i0++){
+                int code = 0;
+                int count = 0;
+                in >> code >> count;
+                tally[code] += count;
+            }
+        }
+        else if(key == "arrival"){
+            in >> entries;
+            for(size_t i0=0;i0<entries;i0++){
+                int code = 0;
+                MomentAccumulator accumulator;
+                in >> code;
+                if(!accumulator.Read(in)) return false;
+                fArrivalTime[code].Merge(accumulator);
+            }
+        }
+        else if(key == "arrivalhistogram" || key == "terminationhistogram" ||
+                key == "compartmenthistogram"){
+            std::unordered_map<int,LogTimeHistogram>& histograms =
+                (key == "arrivalhistogram") ? fArrivalHistogram :
+                (key == "terminationhistogram") ? fTerminationHistogram : fCompartmentHistogram;
+            in >> entries;
+            for(size_t i0=0;i0<entries;i0++){
+                int code = 0;
+                LogTimeHistogram histogram;
+                in >> code;
+                if(!histogram.Read(in)) return false;
+                histograms[code].Merge(histogram);
+            }
+        }
+        else if(key == "end"){
+            if(!weights){
+                for (auto it : counts){
+                    fIsotopesWeight[it.first] += it.second;
+                }
+            }
+            return !in.fail();
+        }
+        else{
+            return false;
+        }
+    }
+    return false;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+std::vector<G4int> Run::GetReleasedIsotopes() const
+{
+    std::vector<G4int> codes;
+    for (auto& it : fArrivalTime){
+        codes.push_back(it.first % 1000000);
+    }
+    std::sort(codes.begin(),codes.end());
+    codes.erase(std::unique(codes.begin(),codes.end()),codes.end());
+    return codes;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+MomentAccumulator Run::GetArrivalTime(G4int code) const
+{
+    MomentAccumulator accumulator;
+    for (auto& it : fArrivalTime){
+        if(it.first % 1000000 == code){
+            accumulator.Merge(it.second);
+        }
+    }
+    return accumulator;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+G4int Run::GetGenerated(G4int code) const
+{
+    G4int generated = 0;
+    for (auto it : fIsotopes){
+        if(it.first % 1000000 == code){
+            generated += it.second;
+        }
+    }
+    return generated;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+G4int Run::GetReleased(G4int code) const
+{
+    return G4int(GetArrivalTime(code).GetEntries());
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+G4double Run::GetGeneratedWeight(G4int code) const
+{
+    G4double generated = 0.;
+    for (auto it : fIsotopesWeight){
+        if(it.first % 1000000 == code){
+            generated += it.second;
+        }
+    }
+    return generated;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+G4double Run::GetReleasedWeight(G4int code) const
+{
+    return GetArrivalTime(code).GetSumOfWeights();
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+G4double Run::GetReleaseFraction(G4int code) const
+{
+    G4double generated = GetGeneratedWeight(code);
+    if(generated <= 0.) return 0.;
+    return GetReleasedWeight(code) / generated;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+G4double Run::GetReleaseRelativeError(G4int code) const
+{
+    // Binomial error on p = r/n: sqrt(p(1-p)/n)/p = sqrt((1-p)/r), with
+    // the effective number of released nuclei for weighted primaries.
+    // Nuclei produced outside the disks (decays in flight) can give p > 1
+    G4double released = GetArrivalTime(code).GetEffectiveEntries();
+    if(released <= 0. || GetGeneratedWeight(code) <= 0.) return DBL_MAX;
+    G4double p = std::min(GetReleaseFraction(code),1.);
+    return std::sqrt((1. - p) / released);
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+G4double Run::GetMeanArrivalTime(G4int code) const
+{
+    return GetArrivalTime(code).GetMean();
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+G4double Run::GetMeanArrivalTimeRelativeError(G4int code) const
+{
+    MomentAccumulator accumulator = GetArrivalTime(code);
+    if(accumulator.GetEntries() < 2 || accumulator.GetMean() <= 0.) return DBL_MAX;
+    return accumulator.GetMeanError() / accumulator.GetMean();
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+LogTimeHistogram Run::GetArrivalTimeHistogram(G4int code) const
+{
+    LogTimeHistogram histogram;
+    for (auto& it : fArrivalHistogram){
+        if(it.first % 1000000 == code){
+            histogram.Merge(it.second);
+        }
+    }
+    return histogram;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+G4double Run::GetMedianArrivalTime(G4int code) const
+{
+    return GetArrivalTimeHistogram(code).GetQuantile(0.5);
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+G4double Run::GetMedianArrivalTimeRelativeError(G4int code) const
+{
+    // The ranks n/2 +- sqrt(n)/2 bound a one sigma interval of the median
+    LogTimeHistogram histogram = GetArrivalTimeHistogram(code);
+    if(histogram.GetEntries() < 2) return DBL_MAX;
+    G4double median = histogram.GetQuantile(0.5);
+    if(median <= 0.) return DBL_MAX;
+    G4double width = 0.5 / std::sqrt(G4double(histogram.GetEntries()));
+    G4double upper = histogram.GetQuantile(std::min(0.5 + width,1.));
+    G4double lower = histogram.GetQuantile(std::max(0.5 - width,0.));
+    return 0.5 * (upper - lower) / median;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void Run::AddGenerated(G4int code,G4double weight)
+{
+    fIsotopes[code] += 1;
+    fIsotopesWeight[code] += weight;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void Run::FillTermination(G4int reason,G4int code,G4double time,G4double weight)
+{
+    fTerminationHistogram[reason * 100000000 + code].Fill(time,weight);
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void Run::FillCompartment(G4int Z,G4bool first,G4int from,G4int to,G4double time,
+                          G4double weight)
+{
+    fCompartmentHistogram[GetCompartmentCode(Z,first,from,to)].Fill(time,weight);
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void Run::WriteHistograms(const G4String& fileName) const
+{
+    // Layout (native byte order):
+    //   char[8] "EFF10LTH", int32 version, int32 bins, int32 bins per decade,
+    //   double min time [ns], double max time [ns],
+    //   int32 n, n x (int32 code, int64 generated, double generated weight),
+    //   int32 n, n x (int32 reason, int32 code, histogram)
+    // with reason 0 for the arrival at the telescope and histogram as in
+    // LogTimeHistogram::WriteBinary()
+    std::ofstream fFileOut;
+    fFileOut.open(fileName,std::ofstream::out | std::ofstream::binary | std::ofstream::trunc);
+
+    const char magic[8] = {'E','F','F','1','0','L','T','H'};
+    int32_t header[3] = {2,LogTimeHistogram::GetNumberOfBins(),
+        LogTimeHistogram::GetBinsPerDecade()};
+    G4double range[2] = {LogTimeHistogram::GetMinTime() / CLHEP::ns,
+        LogTimeHistogram::GetMaxTime() / CLHEP::ns};
+    fFileOut.write(magic,sizeof(magic));
+    fFileOut.write(reinterpret_cast<const char*>(header),sizeof(header));
+    fFileOut.write(reinterpret_cast<const char*>(range),sizeof(range));
+
+    int32_t entries = int32_t(fIsotopes.size());
+    fFileOut.write(reinterpret_cast<const char*>(&entries),sizeof(entries));
+    for (auto it : fIsotopes){
+        int32_t code = it.first;
+        int64_t generated = it.second;
+        G4double weight = 0.;
+        auto search = fIsotopesWeight.find(it.first);
+        if(search != fIsotopesWeight.end()) weight = search->second;
+        fFileOut.write(reinterpret_cast<const char*>(&code),sizeof(code));
+        fFileOut.write(reinterpret_cast<const char*>(&generated),sizeof(generated));
+        fFileOut.write(reinterpret_cast<const char*>(&weight),sizeof(weight));
+    }
+
+    entries = int32_t(fArrivalHistogram.size() + fTerminationHistogram.size());
+    fFileOut.write(reinterpret_cast<const char*>(&entries),sizeof(entries));
+    for (auto& it : fArrivalHistogram){
+        int32_t key[2] = {0,it.first};
+        fFileOut.write(reinterpret_cast<const char*>(key),sizeof(key));
+        it.second.WriteBinary(fFileOut);
+    }
+    for (auto& it : fTerminationHistogram){
+        int32_t key[2] = {it.first / 100000000,it.first % 100000000};
+        fFileOut.write(reinterpret_cast<const char*>(key),sizeof(key));
+        it.second.WriteBinary(fFileOut);
+    }
+    fFileOut.close();
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+G4bool Run::ReadHistograms(const G4String& fileName)
+{
+    std::ifstream fFileIn;
+    fFileIn.open(fileName,std::ifstream::in | std::ifstream::binary);
+    
+    char magic[8];
+    int32_t header[3];
+    G4double range[2];
+    fFileIn.read(magic,sizeof(magic));
+    fFileIn.read(reinterpret_cast<char*>(header),sizeof(header));
+    fFileIn.read(reinterpret_cast<char*>(range),sizeof(range));
+    // Version 1 has no generated weights, the primaries had unit weight
+    if(fFileIn.fail() || std::string(magic,8) != "EFF10LTH" ||
+       (header[0] != 1 && header[0] != 2) ||
+       header[1] != LogTimeHistogram::GetNumberOfBins() ||
+       header[2] != LogTimeHistogram::GetBinsPerDecade()){
+        return false;
+    }
+    
+    int32_t entries = 0;
+    fFileIn.read(reinterpret_cast<char*>(&entries),sizeof(entries));
+    for(int32_t i0=0;i0<entries;i0++){
+        int32_t code = 0;
+        int64_t generated = 0;
+        fFileIn.read(reinterpret_cast<char*>(&code),sizeof(code));
+        fFileIn.read(reinterpret_cast<char*>(&generated),sizeof(generated));
+        G4double weight = G4double(generated);
+        if(header[0] == 2){
+            fFileIn.read(reinterpret_cast<char*>(&weight),sizeof(weight));
+        }
+        fIsotopes[code] += G4int(generated);
+        fIsotopesWeight[code] += weight;
+    }
+
+    fFileIn.read(reinterpret_cast<char*>(&entries),sizeof(entries));
+    for(int32_t i0=0;i0<entries;i0++){
+        int32_t key[2];
+        LogTimeHistogram histogram;
+        fFileIn.read(reinterpret_cast<char*>(key),sizeof(key));
+        if(fFileIn.fail() || !histogram.ReadBinary(fFileIn)) return false;
+        if(key[0] == 0){
+            fArrivalHistogram[key[1]].Merge(histogram);
+        }
+        else{
+            fTerminationHistogram[key[0] * 100000000 + key[1]].Merge(histogram);
+        }
+    }
+    return !fFileIn.fail();
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void Run::PrintArrivalTimeSummary() const
+{
+    std::vector<G4int> codes;
+    for (auto& it : fArrivalTime){
+        codes.push_back(it.first);
+    }
+    std::sort(codes.begin(),codes.end(),[](G4int a,G4int b){
+        return (a % 1000000 == b % 1000000) ? (a < b) : (a % 1000000 < b % 1000000);
+    });
+
+    G4cout << G4endl << "------------------------- Arrival time at the telescope [s] -------------------------" << G4endl;
+    G4cout << "   A   Z disk released generated     weight       mean      error      sigma   skewness   kurtosis" << G4endl;
+    
+    std::ios::fmtflags flags = G4cout.flags();
+    std::streamsize precision = G4cout.precision(3);
+    for (auto code : codes){
+        const MomentAccumulator& accumulator = fArrivalTime.at(code);
+        G4int disk = code / 1000000 - 1;
+        G4int generated = 0;
+        auto search = fIsotopes.find(code);
+        if(search != fIsotopes.end()) generated = search->second;
+        
+        G4cout << std::setw(4) << (code / 1000) % 1000
+        << std::setw(4) << code % 1000;
+        if(disk < 0){
+            G4cout << std::setw(5) << "-";
+        }
+        else{
+            G4cout << std::setw(5) << disk;
+        }
+        G4cout << std::setw(9) << accumulator.GetEntries()
+        << std::setw(10) << generated
+        << std::scientific
+        << std::setw(11) << accumulator.GetSumOfWeights()
+        << std::setw(11) << accumulator.GetMean() / CLHEP::s
+        << std::setw(11) << accumulator.GetMeanError() / CLHEP::s
+        << std::setw(11) << std::sqrt(accumulator.GetVariance()) / CLHEP::s
+        << std::setw(11) << accumulator.GetSkewness()
+        << std::setw(11) << accumulator.GetKurtosis()
+        << G4endl;
+        G4cout.flags(flags);
+    }
+    G4cout.precision(precision);
+    G4cout << "-------------------------------------------------------------------------------------" << G4endl;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+G4double Run::GetStratifiedReleaseFraction(G4int code) const
+{
+    G4double fraction = 0.;
+    for (auto it : fStratumGenerated){
+        if(it.second == 0) continue;
+        auto released = fStratumReleased.find(GetStratumCode(it.first,code));
+        if(released == fStratumReleased.end()) continue;
+        fraction += fStratumShare.at(it.first) * released->second / G4double(it.second);
+    }
+    return fraction;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+G4double Run::GetStratifiedReleaseVariance(G4int code) const
+{
+    // Nuclei produced outside the disks (decays in flight) can give p > 1
+    G4double variance = 0.;
+    for (auto it : fStratumGenerated){
+        if(it.second == 0) continue;
+        auto released = fStratumReleased.find(GetStratumCode(it.first,code));
+        if(released == fStratumReleased.end()) continue;
+        G4double share = fStratumShare.at(it.first);
+        G4double p = std::min(released->second / G4double(it.second),1.);
+        variance += share * share * p * (1. - p) / G4double(it.second);
+    }
+    return variance;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+std::vector<G4double> Run::GetStratumSigmas(G4int code) const
+{
+    G4int strata = 0;
+    for (auto it : fStratumShare){
+        strata = std::max(strata,it.first + 1);
+    }
+    std::vector<G4double> sigmas(strata,0.5);
+    for (auto it : fStratumGenerated){
+        G4double released = 0.;
+        auto search = fStratumReleased.find(GetStratumCode(it.first,code));
+        if(search != fStratumReleased.end()) released = search->second;
+        G4double p = std::min((released + 0.5) / (it.second + 1.),1.);
+        sigmas[it.first] = std::sqrt(p * (1. - p));
+    }
+    return sigmas;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+G4int Run::GetStratifiedIsotope() const
+{
+    std::map<int,int> released;
+    for (auto it : fStratumReleased){
+        released[it.first % 1000000] += it.second;
+    }
+    G4int isotope = -1;
+    G4int most = 0;
+    for (auto it : released){
+        if(it.second > most){
+            most = it.second;
+            isotope = it.first;
+        }
+    }
+    return isotope;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void Run::PrintStratifiedSummary() const
+{
+    if(fStratumGenerated.empty()) return;
+    
+    G4int generated = 0;
+    G4double covered = 0.;
+    for (auto it : fStratumGenerated){
+        generated += it.second;
+        if(it.second > 0) covered += fStratumShare.at(it.first);
+    }
+    
+    // The strata without ion are missing from the sums of the estimator,
+    // their share of the production would be counted as not released
+    if(covered < 1. - 1.e-6){
+        G4ExceptionDescription ed;
+        ed << "The strata without primary ion hold " << 1. - covered
+        << " of the production, the stratified release fraction is not estimated.";
+        G4Exception("Run::PrintStratifiedSummary",
+                    "eff0011",
+                    JustWarning,
+                    ed);
+        return;
+    }
+    std::set<int> codes;
+    for (auto it : fStratumReleased){
+        codes.insert(it.first % 1000000);
+    }
+    
+    G4cout << G4endl << "------------------------- Stratified release fraction -------------------------" << G4endl;
+    G4cout << fStratumGenerated.size() << " strata, " << generated << " primary ions" << G4endl;
+    G4cout << "   A   Z   fraction      error  rel.error" << G4endl;
+    
+    std::ios::fmtflags flags = G4cout.flags();
+    std::streamsize precision = G4cout.precision(3);
+    for (auto code : codes){
+        G4double fraction = GetStratifiedReleaseFraction(code);
+        G4double error = std::sqrt(GetStratifiedReleaseVariance(code));
+        G4cout << std::setw(4) << (code / 1000) % 1000
+        << std::setw(4) << code % 1000
+        << std::scientific
+        << std::setw(11) << fraction
+        << std::setw(11) << error
+        << std::setw(11) << (fraction > 0. ? error / fraction : 0.)
+        << G4endl;
+        G4cout.flags(flags);
+    }
+    G4cout.precision(precision);
+    G4cout << "-------------------------------------------------------------------------------" << G4endl;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+G4double Run::GetQuasiRandomReleaseFraction(G4int code) const
+{
+    G4double fraction = 0.;
+    G4int replicates = 0;
+    for (auto it : fReplicateGenerated){
+        if(it.second == 0) continue;
+        auto released = fReplicateReleased.find(GetReplicateCode(it.first,code));
+        if(released != fReplicateReleased.end()){
+            fraction += released->second / G4double(it.second);
+        }
+        replicates++;
+    }
+    return (replicates > 0) ? fraction / replicates : 0.;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+G4double Run::GetQuasiRandomReleaseError(G4int code) const
+{
+    G4double mean = GetQuasiRandomReleaseFraction(code);
+    G4double sum = 0.;
+    G4int replicates = 0;
+    for (auto it : fReplicateGenerated){
+        if(it.second == 0) continue;
+        G4double p = 0.;
+        auto released = fReplicateReleased.find(GetReplicateCode(it.first,code));
+        if(released != fReplicateReleased.end()){
+            p = released->second / G4double(it.second);
+        }
+        sum += (p - mean) * (p - mean);
+        replicates++;
+    }
+    if(replicates < 2) return 0.;
+    return std::sqrt(sum / (replicates * (replicates - 1.)));
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void Run::PrintQuasiRandomSummary() const
+{
+    if(fReplicateGenerated.empty()) return;
+    
+    G4int generated = 0;
+    for (auto it : fReplicateGenerated){
+        generated += it.second;
+    }
+    std::set<int> codes;
+    for (auto it : fReplicateReleased){
+        codes.insert(it.first % 1000000);
+    }
+    
+    G4cout << G4endl << "------------------------ Quasi-random release fraction ------------------------" << G4endl;
+    G4cout << fReplicateGenerated.size() << " replicates, " << generated << " primary ions" << G4endl;
+    G4cout << "   A   Z   fraction      error  rel.error" << G4endl;
+    
+    std::ios::fmtflags flags = G4cout.flags();
+    std::streamsize precision = G4cout.precision(3);
+    for (auto code : codes){
+        G4double fraction = GetQuasiRandomReleaseFraction(code);
+        G4double error = GetQuasiRandomReleaseError(code);
+        G4cout << std::setw(4) << (code / 1000) % 1000
+        << std::setw(4) << code % 1000
+        << std::scientific
+        << std::setw(11) << fraction
+        << std::setw(11) << error
+        << std::setw(11) << (fraction > 0. ? error / fraction : 0.)
+        << G4endl;
+        G4cout.flags(flags);
+    }
+    G4cout.precision(precision);
+    G4cout << "-------------------------------------------------------------------------------" << G4endl;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
@@ -25,20 +25,66 @@
 //
 
 #include "RunAction.hh"
+#include "RunActionMessenger.hh"
+#include "BeamScheduleConvolver.hh"
+#include "EffusionTransitionSolver.hh"
+#include "FreeMolecularFlowEngine.hh"
+#include "CompartmentModel.hh"
+#include "VertexFile.hh"
+#include "CommonRandomNumbers.hh"
+#include "QuasiRandomSequence.hh"
 
 #include "G4Run.hh"
 #include "G4RunManager.hh"
+#include "G4UImanager.hh"
+#include "G4Threading.hh"
 #include "G4UnitsTable.hh"
 #include "G4SystemOfUnits.hh"
+#include "Randomize.hh"
 #include "Run.hh"
 
 #include "Analysis.hh"
 
+#include <chrono>
+#include <cfloat>
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+
 //....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
 
-RunAction::RunAction(): G4UserRunAction(){
+RunAction::RunAction(): G4UserRunAction(),
+fConvolver(0),
+fSolver(0),
+fEngine(0),
+fCompartmentModel(0),
+fCumulativeRun(0),
+fEventsDone(0),
+fEventsTarget(0),
+bCheckpoint(false),
+bConvergence(false),
+fCheckpointFile("checkpoint.dat"),
+fEventsPerChunk(100000),
+bOutputPerRun(false),
+fConvergenceTarget(0.05),
+fConvergenceObservable("release"),
+fMaxWallTime(0.),
+fHistogramFile("release_histograms.bin"){
     G4RunManager::GetRunManager()->SetPrintProgress(100);
     
+    fMessenger = new RunActionMessenger(this);
+    // The /crn/ commands must exist in every thread before the macros
+    CommonRandomNumbers::Instance();
+    
+    // The convolution with the beam schedules runs on the merged tallies,
+    // the transition matrix solver on the master geometry
+    if(G4Threading::IsMasterThread()){
+        fConvolver = new BeamScheduleConvolver();
+        fSolver = new EffusionTransitionSolver();
+        fEngine = new FreeMolecularFlowEngine();
+        fCompartmentModel = new CompartmentModel();
+    }
+    
     auto analysisManager = G4AnalysisManager::Instance();
     G4cout << "Using " << analysisManager->GetType() << G4endl;
     //analysisManager->SetNtupleMerging(true);
@@ -51,6 +97,8 @@ RunAction::RunAction(): G4UserRunAction(){
     analysisManager->CreateNtupleDColumn("t");
     analysisManager->CreateNtupleDColumn("A");
     analysisManager->CreateNtupleDColumn("Z");
+    analysisManager->CreateNtupleDColumn("ion");
+    analysisManager->CreateNtupleDColumn("w");
     analysisManager->FinishNtuple();
 
     if(bSAVEALLPRIMARIES){
@@ -63,6 +111,8 @@ RunAction::RunAction(): G4UserRunAction(){
         analysisManager->CreateNtupleDColumn("x");
         analysisManager->CreateNtupleDColumn("y");
         analysisManager->CreateNtupleDColumn("z");
+        analysisManager->CreateNtupleDColumn("ion");
+        analysisManager->CreateNtupleDColumn("w");
         analysisManager->FinishNtuple();
     }
     
@@ -73,18 +123,50 @@ RunAction::RunAction(): G4UserRunAction(){
 
 RunAction::~RunAction(){
     delete G4AnalysisManager::Instance();
+    delete fCumulativeRun;
+    delete fMessenger;
+    delete fConvolver;
+    delete fSolver;
+    delete fEngine;
+    delete fCompartmentModel;
 }
 
 G4Run* RunAction::GenerateRun()
-{ return new Run; }
+{
+    Run* run = new Run;
+    run->SetRecordVertices(!fVertexPrefix.empty());
+    run->SetRecordOutcomes(!CommonRandomNumbers::Instance()->GetOutputFile().empty());
+    return run;
+}
 
 //....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
 
 //....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
 
-void RunAction::BeginOfRunAction(const G4Run* /*run*/){
+void RunAction::BeginOfRunAction(const G4Run* run){
     auto analysisManager = G4AnalysisManager::Instance();
-    analysisManager->OpenFile("output");
+    if(bOutputPerRun){
+        analysisManager->OpenFile("output_run" + std::to_string(run->GetRunID()));
+    }
+    else{
+        analysisManager->OpenFile("output");
+    }
+
+    // The isotope table histogram of a checkpointed run restarts from the
+    // tallies of the previous chunks, the workers add the current one
+    if(IsMaster() && bCheckpoint){
+        for (auto it : fCumulativeRun->fIsotopes){
+            G4int A = (it.first / 1000) % 1000;
+            G4int Z = it.first % 1000;
+            analysisManager->FillH2(0,Z,A,it.second);
+        }
+    }
+    
+    // The quasi-random points continue after the events of the previous
+    // chunks, also those read from the checkpoint of an earlier session
+    if(IsMaster() && bCheckpoint){
+        QuasiRandomSequence::SetEventOffset(fEventsDone);
+    }
 }
 
 //....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
@@ -99,13 +181,294 @@ void RunAction::EndOfRunAction(const G4Run* run){
     if (IsMaster())
     {
         std::ofstream fFileOut;
-        fFileOut.open("isotope_table.dat",std::ofstream::out | std::ofstream::app);
-        for (auto it : run_spes->fIsotopes){
-            fFileOut << it.first << " , " << it.second << std::endl;
+        if(bCheckpoint){
+            fCumulativeRun->Accumulate(run_spes);
+            fEventsDone += run->GetNumberOfEvent();
+            WriteCheckpoint();
+
+            // The table of a checkpointed run holds the totals of all the chunks
+            fFileOut.open("isotope_table.dat",std::ofstream::out | std::ofstream::trunc);
+            for (auto it : fCumulativeRun->fIsotopes){
+                fFileOut << it.first << " , " << it.second << std::endl;
+            }
+        }
+        else{
+            fFileOut.open("isotope_table.dat",std::ofstream::out | std::ofstream::app);
+            for (auto it : run_spes->fIsotopes){
+                fFileOut << it.first << " , " << it.second << std::endl;
+            }
         }
         fFileOut.close();
+        
+        // The next BeamOn takes the following quasi-random points
+        QuasiRandomSequence::SetEventOffset(bCheckpoint ? fEventsDone :
+                                            QuasiRandomSequence::GetEventOffset() + run->GetNumberOfEvent());
+
+        if(bCheckpoint){
+            fCumulativeRun->PrintArrivalTimeSummary();
+            fCumulativeRun->WriteHistograms(fHistogramFile);
+            fConvolver->SetRun(fCumulativeRun);
+            fEngine->SetRun(fCumulativeRun);
+            fCompartmentModel->SetRun(fCumulativeRun);
+        }
+        else{
+            run_spes->PrintArrivalTimeSummary();
+            run_spes->WriteHistograms(fHistogramFile);
+            fConvolver->SetRun(run_spes);
+            fEngine->SetRun(run_spes);
+            fCompartmentModel->SetRun(run_spes);
+        }
+        if(fConvolver->HasSchedules()){
+            fConvolver->Convolve();
+        }
+
+        // Stratified runs: the standard deviations of the release in the
+        // strata drive the Neyman allocation of the next run or chunk
+        const Run* result = bCheckpoint ? fCumulativeRun : run_spes;
+        result->PrintStratifiedSummary();
+        result->PrintQuasiRandomSummary();
+        G4int isotope = result->GetStratifiedIsotope();
+        if(isotope >= 0){
+            std::ostringstream sigmas;
+            for (auto sigma : result->GetStratumSigmas(isotope)){
+                if(sigmas.tellp() > 0) sigmas << ";";
+                sigmas << sigma;
+            }
+            G4UImanager::GetUIpointer()->ApplyCommand("/stratified/setSigmas " + sigmas.str());
+        }
+
+        // The vertices are not kept in the cumulative run, each run is
+        // appended to the files and dropped
+        if(!fVertexPrefix.empty()){
+            for (auto& it : run_spes->fVertices){
+                G4String fileName = fVertexPrefix + "_" + std::to_string(it.first) + ".vtx";
+                VertexFile::Append(fileName,it.first,it.second,
+                                   fVertexCodes.insert(it.first).second);
+            }
+        }
+        CommonRandomNumbers::Instance()->WriteOutcomes(run_spes->fOutcomes);
     }
 
 }
 
 //....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void RunAction::BeamOnWithCheckpoints(G4long nEvents){
+    delete fCumulativeRun;
+    fCumulativeRun = new Run();
+    fEventsDone = 0;
+    fEventsTarget = nEvents;
+    ProcessChunks();
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void RunAction::Resume(){
+    if(ReadCheckpoint()){
+        ProcessChunks();
+    }
+    bConvergence = false;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void RunAction::TopUp(G4long nEvents){
+    if(ReadCheckpoint()){
+        fEventsTarget = std::max(fEventsTarget,fEventsDone) + nEvents;
+        ProcessChunks();
+    }
+    bConvergence = false;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void RunAction::BeamOnUntilConverged(G4long nMaxEvents){
+    delete fCumulativeRun;
+    fCumulativeRun = new Run();
+    fEventsDone = 0;
+    fEventsTarget = nMaxEvents;
+    bConvergence = true;
+    ProcessChunks();
+    bConvergence = false;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void RunAction::AddConvergenceIsotope(G4int A,G4int Z){
+    fConvergenceIsotopes.push_back(A*1000 + Z);
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+G4bool RunAction::IsConverged(){
+    // Without a list of isotopes every released isotope is checked, the
+    // ones never reaching the telescope cannot give an error estimate
+    std::vector<G4int> codes = fConvergenceIsotopes;
+    if(codes.empty()){
+        codes = fCumulativeRun->GetReleasedIsotopes();
+    }
+    if(codes.empty()){
+        return false;
+    }
+
+    G4bool bRelease = (fConvergenceObservable == "release" || fConvergenceObservable == "all");
+    G4bool bMean = (fConvergenceObservable == "mean" || fConvergenceObservable == "all");
+    G4bool bMedian = (fConvergenceObservable == "median" || fConvergenceObservable == "all");
+    
+    G4double worstError = 0.;
+    G4int worstCode = codes.front();
+    for (auto code : codes){
+        G4double error = 0.;
+        if(bRelease){
+            error = std::max(error,fCumulativeRun->GetReleaseRelativeError(code));
+        }
+        if(bMean){
+            error = std::max(error,fCumulativeRun->GetMeanArrivalTimeRelativeError(code));
+        }
+        if(bMedian){
+            error = std::max(error,fCumulativeRun->GetMedianArrivalTimeRelativeError(code));
+        }
+        if(error > worstError){
+            worstError = error;
+            worstCode = code;
+        }
+    }
+
+    G4cout << "--- Convergence: largest relative error ";
+    if(worstError == DBL_MAX){
+        G4cout << "undefined";
+    }
+    else{
+        G4cout << worstError;
+    }
+    G4cout << " for A = " << worstCode / 1000 << " Z = " << worstCode % 1000
+    << " (target " << fConvergenceTarget << ")" << G4endl;
+
+    return worstError <= fConvergenceTarget;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void RunAction::ProcessChunks(){
+    G4RunManager* runManager = G4RunManager::GetRunManager();
+
+    // Every chunk is a separate run, the ntuples of each one go to their own
+    // file. The previous naming is restored for the runs that follow
+    G4bool outputPerRun = bOutputPerRun;
+    G4UImanager::GetUIpointer()->ApplyCommand("/checkpoint/setOutputPerRun true");
+    
+    auto startTime = std::chrono::steady_clock::now();
+    G4long eventsStart = fEventsDone;
+
+    bCheckpoint = true;
+    while(fEventsDone < fEventsTarget){
+        G4long eventsBefore = fEventsDone;
+        G4long nEvents = std::min<G4long>(fEventsPerChunk,fEventsTarget - fEventsDone);
+        runManager->BeamOn(G4int(nEvents));
+        
+        if(fEventsDone == eventsBefore){
+            G4Exception("RunAction::ProcessChunks",
+                        "eff0002",
+                        JustWarning,
+                        "No events processed, checkpointed run stopped.");
+            break;
+        }
+        G4cout << "--- Checkpoint: " << fEventsDone << " / " << fEventsTarget
+        << " events written to " << fCheckpointFile << G4endl;
+
+        if(bConvergence){
+            if(IsConverged()){
+                G4cout << "--- Convergence: target reached after "
+                << fEventsDone << " events" << G4endl;
+                break;
+            }
+            // Stop if the next chunk, at the rate measured so far, would
+            // not end within the wall-time budget
+            std::chrono::duration<G4double> elapsed = std::chrono::steady_clock::now() - startTime;
+            G4double nextChunk = elapsed.count() / G4double(fEventsDone - eventsStart) *
+                G4double(std::min<G4long>(fEventsPerChunk,fEventsTarget - fEventsDone));
+            if(fMaxWallTime > 0. && elapsed.count() + nextChunk > fMaxWallTime){
+                G4cout << "--- Convergence: wall-time budget exhausted after "
+                << fEventsDone << " events" << G4endl;
+                break;
+            }
+        }
+    }
+    bCheckpoint = false;
+    G4UImanager::GetUIpointer()->ApplyCommand(G4String("/checkpoint/setOutputPerRun ") +
+                                              (outputPerRun ? "true" : "false"));
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void RunAction::WriteCheckpoint(){
+    // Write temporary files and rename them, so that a job killed while
+    // writing leaves the previous checkpoint intact
+    G4String fileName = fCheckpointFile + ".tmp";
+    G4String engineName = fCheckpointFile + ".rndm";
+    
+    std::ofstream fFileOut;
+    fFileOut.open(fileName,std::ofstream::out | std::ofstream::trunc);
+    fFileOut.precision(17);
+    fFileOut << "eff10_checkpoint 2" << std::endl;
+    fFileOut << "target " << fEventsTarget << std::endl;
+    fFileOut << "done " << fEventsDone << std::endl;
+    fFileOut << "convergence " << (bConvergence ? 1 : 0) << std::endl;
+    fCumulativeRun->WriteCheckpoint(fFileOut);
+    fFileOut << "end" << std::endl;
+    fFileOut.close();
+
+    G4Random::saveEngineStatus((engineName + ".tmp").c_str());
+    std::rename((engineName + ".tmp").c_str(),engineName.c_str());
+    std::rename(fileName.c_str(),fCheckpointFile.c_str());
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+G4bool RunAction::ReadCheckpoint(){
+    std::ifstream fFileIn;
+    fFileIn.open(fCheckpointFile,std::ifstream::in);
+    
+    std::string key;
+    G4int version = 0;
+    fFileIn >> key >> version;
+    if(!fFileIn.good() || key != "eff10_checkpoint" || version < 1 || version > 2){
+        G4ExceptionDescription ed;
+        ed << "Cannot read checkpoint file `" << fCheckpointFile << "'" << G4endl;
+        G4Exception("RunAction::ReadCheckpoint",
+                    "eff0003",
+                    JustWarning,
+                    ed);
+        return false;
+    }
+    
+    delete fCumulativeRun;
+    fCumulativeRun = new Run();
+    fFileIn >> key >> fEventsTarget;
+    fFileIn >> key >> fEventsDone;
+    // Version 1 checkpoints come from runs with a fixed number of events
+    G4int convergence = 0;
+    if(version >= 2){
+        fFileIn >> key >> convergence;
+    }
+    bConvergence = (convergence != 0);
+    if(!fCumulativeRun->ReadCheckpoint(fFileIn)){
+        G4ExceptionDescription ed;
+        ed << "Checkpoint file `" << fCheckpointFile << "' is corrupted" << G4endl;
+        G4Exception("RunAction::ReadCheckpoint",
+                    "eff0003",
+                    JustWarning,
+                    ed);
+        return false;
+    }
+    fFileIn.close();
+
+    // The master engine seeds the worker streams of the next chunk
+    G4Random::restoreEngineStatus((fCheckpointFile + ".rndm").c_str());
+
+    G4cout << "--- Checkpoint: resuming from " << fEventsDone << " / " << fEventsTarget
+    << " events" << G4endl;
+    return true;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
@@ -0,0 +1,290 @@
+//
+// ********************************************************************
+// * License and Disclaimer                                           *
+// *                                                                  *
+// * The  Geant4 software  is  copyright of the Copyright Holders  of *
+// * the Geant4 Collaboration.  It is provided  under  the terms  and *
+// * conditions of the Geant4 Software License,  included in the file *
+// * LICENSE and available at  http://cern.ch/geant4/license .  These *
+// * include a list of copyright holders.                             *
+// *                                                                  *
+// * Neither the authors of this software system, nor their employing *
+// * institutes,nor the agencies providing financial support for this *
+// * work  make  any representation or  warranty, express or implied, *
+// * regarding  this  software system or assume any liability for its *
+// * use.  Please see the license in the file  LICENSE  and URL above *
+// * for the full disclaimer and the limitation of liability.         *
+// *                                                                  *
+// * This  code  implementation is the result of  the  scientific and *
+// * technical work of the GEANT4 collaboration.                      *
+// * By using,  copying,  modifying or  distributing the software (or *
+// * any work based  on the software)  you  agree  to acknowledge its *
+// * use  in  resulting  scientific  publications,  and indicate your *
+// * acceptance of all terms of the Geant4 Software license.          *
+// ********************************************************************
+//
+
+#include "RunActionMessenger.hh"
+#include "RunAction.hh"
+#include "G4UIdirectory.hh"
+#include "G4UIcmdWithAString.hh"
+#include "G4UIcmdWithAnInteger.hh"
+#include "G4UIcmdWithADouble.hh"
+#include "G4UIcmdWithABool.hh"
+#include "G4UIcmdWithoutParameter.hh"
+#include "G4UIcmdWithADoubleAndUnit.hh"
+#include "G4UIcommand.hh"
+#include "G4UIparameter.hh"
+#include "G4SystemOfUnits.hh"
+#include "G4Tokenizer.hh"
+
+#include "G4ios.hh"
+
+RunActionMessenger::
+RunActionMessenger(
+                   RunAction* mpga)
+:fTarget(mpga){
+    fCheckpointDirectory = new G4UIdirectory("/checkpoint/");
+    fCheckpointDirectory->SetGuidance("Checkpoint, resume and top-up of long runs.");
+
+    // The run control commands are executed by the master only, the
+    // workers receive the single runs issued by the master
+    fCheckpointFileCmd = new G4UIcmdWithAString("/checkpoint/setFile",this);
+    fCheckpointFileCmd->SetGuidance("Set checkpoint file name.");
+    fCheckpointFileCmd->SetParameterName("checkpointfile",
+                                         true);
+    fCheckpointFileCmd->SetDefaultValue("checkpoint.dat");
+    fCheckpointFileCmd->SetToBeBroadcasted(false);
+
+    fEventsPerChunkCmd = new G4UIcmdWithAnInteger("/checkpoint/setEventsPerChunk",this);
+    fEventsPerChunkCmd->SetGuidance("Set number of events between two checkpoints.");
+    fEventsPerChunkCmd->SetParameterName("eventsperchunk",
+                                         true);
+    fEventsPerChunkCmd->SetDefaultValue(100000);
+    fEventsPerChunkCmd->SetRange("eventsperchunk>0");
+    fEventsPerChunkCmd->SetToBeBroadcasted(false);
+
+    fBeamOnCmd = new G4UIcmdWithADouble("/checkpoint/beamOn",this);
+    fBeamOnCmd->SetGuidance("Start a checkpointed run of the given number of events.");
+    fBeamOnCmd->SetParameterName("numberofevents",
+                                 false);
+    fBeamOnCmd->SetRange("numberofevents>0");
+    fBeamOnCmd->AvailableForStates(G4State_Idle);
+    fBeamOnCmd->SetToBeBroadcasted(false);
+
+    fResumeCmd = new G4UIcmdWithoutParameter("/checkpoint/resume",this);
+    fResumeCmd->SetGuidance("Resume a checkpointed run from the checkpoint file.");
+    fResumeCmd->AvailableForStates(G4State_Idle);
+    fResumeCmd->SetToBeBroadcasted(false);
+
+    fTopUpCmd = new G4UIcmdWithADouble("/checkpoint/topUp",this);
+    fTopUpCmd->SetGuidance("Add events to a checkpointed run and merge them.");
+    fTopUpCmd->SetParameterName("numberofevents",
+                                false);
+    fTopUpCmd->SetRange("numberofevents>0");
+    fTopUpCmd->AvailableForStates(G4State_Idle);
+    fTopUpCmd->SetToBeBroadcasted(false);
+
+    fOutputPerRunCmd = new G4UIcmdWithABool("/checkpoint/setOutputPerRun",this);
+    fOutputPerRunCmd->SetGuidance("Write the analysis output of each run to its own file.");
+    fOutputPerRunCmd->SetParameterName("outputperrun",
+                                       true);
+    fOutputPerRunCmd->SetDefaultValue(true);
+
+    fConvergenceDirectory = new G4UIdirectory("/convergence/");
+    fConvergenceDirectory->SetGuidance("Run until the statistical error is below a target.");
+
+    fConvergenceTargetCmd = new G4UIcmdWithADouble("/convergence/setTarget",this);
+    fConvergenceTargetCmd->SetGuidance("Set target relative standard error.");
+    fConvergenceTargetCmd->SetParameterName("target",
+                                            true);
+    fConvergenceTargetCmd->SetDefaultValue(0.05);
+    fConvergenceTargetCmd->SetRange("target>0");
+    fConvergenceTargetCmd->SetToBeBroadcasted(false);
+
+    fConvergenceObservableCmd = new G4UIcmdWithAString("/convergence/setObservable",this);
+    fConvergenceObservableCmd->SetGuidance("Set observable checked for convergence:");
+    fConvergenceObservableCmd->SetGuidance("release fraction at the telescope, mean or median arrival time, all of them.");
+    fConvergenceObservableCmd->SetParameterName("observable",
+                                                true);
+    fConvergenceObservableCmd->SetDefaultValue("release");
+    fConvergenceObservableCmd->SetCandidates("release mean median all");
+    fConvergenceObservableCmd->SetToBeBroadcasted(false);
+
+    fAddIsotopeCmd = new G4UIcommand("/convergence/addIsotope",this);
+    fAddIsotopeCmd->SetGuidance("Add isotope to the convergence check.");
+    fAddIsotopeCmd->SetGuidance("Without isotopes every released isotope is checked.");
+    G4UIparameter* parA = new G4UIparameter("A",'i',false);
+    parA->SetParameterRange("A>0");
+    fAddIsotopeCmd->SetParameter(parA);
+    G4UIparameter* parZ = new G4UIparameter("Z",'i',false);
+    parZ->SetParameterRange("Z>0");
+    fAddIsotopeCmd->SetParameter(parZ);
+    fAddIsotopeCmd->SetToBeBroadcasted(false);
+
+    fClearIsotopesCmd = new G4UIcmdWithoutParameter("/convergence/clearIsotopes",this);
+    fClearIsotopesCmd->SetGuidance("Remove all the isotopes from the convergence check.");
+    fClearIsotopesCmd->SetToBeBroadcasted(false);
+
+    fMaxWallTimeCmd = new G4UIcmdWithADoubleAndUnit("/convergence/setMaxWallTime",this);
+    fMaxWallTimeCmd->SetGuidance("Set wall-time budget, zero for no limit.");
+    fMaxWallTimeCmd->SetParameterName("maxwalltime",
+                                      true);
+    fMaxWallTimeCmd->SetDefaultValue(0.);
+    fMaxWallTimeCmd->SetRange("maxwalltime>=0");
+    fMaxWallTimeCmd->SetDefaultUnit("s");
+    fMaxWallTimeCmd->SetToBeBroadcasted(false);
+
+    fConvergenceBeamOnCmd = new G4UIcmdWithADouble("/convergence/beamOn",this);
+    fConvergenceBeamOnCmd->SetGuidance("Run until convergence, with at most the given number of events.");
+    fConvergenceBeamOnCmd->SetParameterName("maxnumberofevents",
+                                            false);
+    fConvergenceBeamOnCmd->SetRange("maxnumberofevents>0");
+    fConvergenceBeamOnCmd->AvailableForStates(G4State_Idle);
+    fConvergenceBeamOnCmd->SetToBeBroadcasted(false);
+
+    fHistogramDirectory = new G4UIdirectory("/histogram/");
+    fHistogramDirectory->SetGuidance("Log-time histograms of arrival and termination.");
+
+    fHistogramFileCmd = new G4UIcmdWithAString("/histogram/setFile",this);
+    fHistogramFileCmd->SetGuidance("Set binary histogram file name.");
+    fHistogramFileCmd->SetParameterName("histogramfile",
+                                        true);
+    fHistogramFileCmd->SetDefaultValue("release_histograms.bin");
+    fHistogramFileCmd->SetToBeBroadcasted(false);
+
+    fVertexDirectory = new G4UIdirectory("/vertex/");
+    fVertexDirectory->SetGuidance("Birth vertices of the production stage.");
+
+    // Broadcasted, the workers record the vertices and the master writes
+    // one file per isotope and disk
+    fVertexPrefixCmd = new G4UIcmdWithAString("/vertex/setFilePrefix",this);
+    fVertexPrefixCmd->SetGuidance("Record the birth vertices in the disks to binary files");
+    fVertexPrefixCmd->SetGuidance("<prefix>_<code>.vtx, none to stop recording.");
+    fVertexPrefixCmd->SetParameterName("vertexprefix",
+                                       true);
+    fVertexPrefixCmd->SetDefaultValue("vertices");
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo....
+
+RunActionMessenger::
+~RunActionMessenger(){
+    delete fCheckpointFileCmd;
+    delete fEventsPerChunkCmd;
+    delete fBeamOnCmd;
+    delete fResumeCmd;
+    delete fTopUpCmd;
+    delete fOutputPerRunCmd;
+    delete fCheckpointDirectory;
+    delete fConvergenceTargetCmd;
+    delete fConvergenceObservableCmd;
+    delete fAddIsotopeCmd;
+    delete fClearIsotopesCmd;
+    delete fMaxWallTimeCmd;
+    delete fConvergenceBeamOnCmd;
+    delete fConvergenceDirectory;
+    delete fHistogramFileCmd;
+    delete fHistogramDirectory;
+    delete fVertexPrefixCmd;
+    delete fVertexDirectory;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo....
+
+void RunActionMessenger::SetNewValue(G4UIcommand *command,
+                                     G4String newValue){
+    if(command==fCheckpointFileCmd ){
+        fTarget->SetCheckpointFile(newValue);
+    }
+
+    if(command==fEventsPerChunkCmd ){
+        fTarget->SetEventsPerChunk(fEventsPerChunkCmd->GetNewIntValue(newValue));
+    }
+
+    if(command==fBeamOnCmd ){
+        fTarget->BeamOnWithCheckpoints(G4long(fBeamOnCmd->GetNewDoubleValue(newValue)));
+    }
+
+    if(command==fResumeCmd ){
+        fTarget->Resume();
+    }
+
+    if(command==fTopUpCmd ){
+        fTarget->TopUp(G4long(fTopUpCmd->GetNewDoubleValue(newValue)));
+    }
+
+    if(command==fOutputPerRunCmd ){
+        fTarget->SetOutputPerRun(fOutputPerRunCmd->GetNewBoolValue(newValue));
+    }
+
+    if(command==fConvergenceTargetCmd ){
+        fTarget->SetConvergenceTarget(fConvergenceTargetCmd->GetNewDoubleValue(newValue));
+    }
+
+    if(command==fConvergenceObservableCmd ){
+        fTarget->SetConvergenceObservable(newValue);
+    }
+
+    if(command==fAddIsotopeCmd ){
+        G4Tokenizer next(newValue);
+        G4int A = G4UIcommand::ConvertToInt(next());
+        G4int Z = G4UIcommand::ConvertToInt(next());
+        fTarget->AddConvergenceIsotope(A,Z);
+    }
+
+    if(command==fClearIsotopesCmd ){
+        fTarget->ClearConvergenceIsotopes();
+    }
+
+    if(command==fMaxWallTimeCmd ){
+        fTarget->SetMaxWallTime(fMaxWallTimeCmd->GetNewDoubleValue(newValue)/CLHEP::s);
+    }
+
+    if(command==fConvergenceBeamOnCmd ){
+        fTarget->BeamOnUntilConverged(G4long(fConvergenceBeamOnCmd->GetNewDoubleValue(newValue)));
+    }
+
+    if(command==fHistogramFileCmd ){
+        fTarget->SetHistogramFile(newValue);
+    }
+
+    if(command==fVertexPrefixCmd ){
+        fTarget->SetVertexPrefix(newValue == "none" ? G4String() : newValue);
+    }
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo....
+
+G4String RunActionMessenger::GetCurrentValue(G4UIcommand * command){
+    G4String cv;
+    
+    if( command==fCheckpointFileCmd ){
+        cv = fTarget->GetCheckpointFile();
+    }
+    if( command==fEventsPerChunkCmd ){
+        cv = fEventsPerChunkCmd->ConvertToString(fTarget->GetEventsPerChunk());
+    }
+    if( command==fOutputPerRunCmd ){
+        cv = fOutputPerRunCmd->ConvertToString(fTarget->GetOutputPerRun());
+    }
+    if( command==fConvergenceTargetCmd ){
+        cv = fConvergenceTargetCmd->ConvertToString(fTarget->GetConvergenceTarget());
+    }
+    if( command==fConvergenceObservableCmd ){
+        cv = fTarget->GetConvergenceObservable();
+    }
+    if( command==fMaxWallTimeCmd ){
+        cv = fMaxWallTimeCmd->ConvertToString(fTarget->GetMaxWallTime()*CLHEP::s,"s");
+    }
+    if( command==fHistogramFileCmd ){
+        cv = fTarget->GetHistogramFile();
+    }
+    if( command==fVertexPrefixCmd ){
+        cv = fTarget->GetVertexPrefix();
+    }
+
+    return cv;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo....
@@ -64,7 +64,7 @@ StackingAction::ClassifyNewTrack(const G4Track* aTrack){
         }
     }
     else if(fKillSecondary == 2){
-        if(aTrack->GetTrackID()>1){
+        if(aTrack->GetParentID()>0){
             status = fKill;
         }
     }
@@ -0,0 +1,116 @@
+//
+// ********************************************************************
+// * License and Disclaimer                                           *
+// *                                                                  *
+// * The  Geant4 software  is  copyright of the Copyright Holders  of *
+// * the Geant4 Collaboration.  It is provided  under  the terms  and *
+// * conditions of the Geant4 Software License,  included in the file *
+// * LICENSE and available at  http://cern.ch/geant4/license .  These *
+// * include a list of copyright holders.                             *
+// *                                                                  *
+// * Neither the authors of this software system, nor their employing *
+// * institutes,nor the agencies providing financial support for this *
+// * work  make  any representation or  warranty, express or implied, *
+// * regarding  this  software system or assume any liability for its *
+// * use.  Please see the license in the file  LICENSE  and URL above *
+// * for the full disclaimer and the limitation of liability.         *
+// *                                                                  *
+// * This  code  implementation is the result of  the  scientific and *
+// * technical work of the GEANT4 collaboration.                      *
+// * By using,  copying,  modifying or  distributing the software (or *
+// * any work based  on the software)  you  agree  to acknowledge its *
+// * use  in  resulting  scientific  publications,  and indicate your *
+// * acceptance of all terms of the Geant4 Software license.          *
+// ********************************************************************
+//
+//
+/// \file SteppingAction.cc
+/// \brief Implementation of the SteppingAction class
+
+#include "SteppingAction.hh"
+#include "CompartmentModel.hh"
+#include "Run.hh"
+#include "TrackingAction.hh"
+
+#include "G4Step.hh"
+#include "G4Track.hh"
+#include "G4VProcess.hh"
+#include "G4RunManager.hh"
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+SteppingAction::SteppingAction():
+fDefinition(0),
+bNucleus(false),
+fCompartment(CompartmentModel::kOutside),
+fEntryTime(0.),
+bFirst(false){;}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+SteppingAction::~SteppingAction(){;}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+G4int SteppingAction::GetCompartment(const G4VPhysicalVolume* volume){
+    auto search = fCompartments.find(volume);
+    if(search != fCompartments.end()) return search->second;
+    G4int compartment = CompartmentModel::GetCompartment(volume);
+    fCompartments[volume] = compartment;
+    return compartment;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void SteppingAction::UserSteppingAction(const G4Step* aStep){
+    G4Track* aTrack = aStep->GetTrack();
+    // The type of the particle is only compared when the definition changes
+    const G4ParticleDefinition* definition = aTrack->GetParticleDefinition();
+    if(definition != fDefinition){
+        fDefinition = definition;
+        bNucleus = (definition->GetParticleType() == "nucleus");
+    }
+    if(!bNucleus){
+        return;
+    }
+    
+    const G4StepPoint* preStepPoint = aStep->GetPreStepPoint();
+    const G4StepPoint* postStepPoint = aStep->GetPostStepPoint();
+    
+    if(aTrack->GetCurrentStepNumber() == 1){
+        fCompartment = GetCompartment(preStepPoint->GetPhysicalVolume());
+        fEntryTime = preStepPoint->GetGlobalTime();
+        bFirst = true;
+    }
+    
+    G4int compartment = GetCompartment(postStepPoint->GetPhysicalVolume());
+    if(aTrack->GetTrackStatus() == fStopAndKill && compartment != CompartmentModel::kOutside){
+        const G4VProcess* process = postStepPoint->GetProcessDefinedStep();
+        if(process && process->GetProcessType() == fDecay){
+            return;
+        }
+        compartment = CompartmentModel::kLost;
+    }
+    if(compartment == fCompartment){
+        return;
+    }
+    
+    // Weighted with the source, not with the biasing of the decay
+    const TrackingAction* trackingAction =
+        static_cast<const TrackingAction*>(G4RunManager::GetRunManager()->GetUserTrackingAction());
+    G4double weight = trackingAction ? trackingAction->GetSourceWeight(aTrack->GetTrackID()) : 1.;
+    
+    Run* run = static_cast<Run*>(G4RunManager::GetRunManager()->GetNonConstCurrentRun());
+    run->FillCompartment(aTrack->GetDefinition()->GetAtomicNumber(),
+                         bFirst,
+                         fCompartment,
+                         compartment,
+                         postStepPoint->GetGlobalTime() - fEntryTime,
+                         weight);
+    
+    fCompartment = compartment;
+    fEntryTime = postStepPoint->GetGlobalTime();
+    bFirst = false;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
@@ -0,0 +1,364 @@
+//
+// ********************************************************************
+// * License and Disclaimer                                           *
+// *                                                                  *
+// * The  Geant4 software  is  copyright of the Copyright Holders  of *
+// * the Geant4 Collaboration.  It is provided  under  the terms  and *
+// * conditions of the Geant4 Software License,  included in the file *
+// * LICENSE and available at  http://cern.ch/geant4/license .  These *
+// * include a list of copyright holders.                             *
+// *                                                                  *
+// * Neither the authors of this software system, nor their employing *
+// * institutes,nor the agencies providing financial support for this *
+// * work  make  any representation or  warranty, express or implied, *
+// * regarding  this  software system or assume any liability for its *
+// * use.  Please see the license in the file  LICENSE  and URL above *
+// * for the full disclaimer and the limitation of liability.         *
+// *                                                                  *
+// * This  code  implementation is the result of  the  scientific and *
+// * technical work of the GEANT4 collaboration.                      *
+// * By using,  copying,  modifying or  distributing the software (or *
+// * any work based  on the software)  you  agree  to acknowledge its *
+// * use  in  resulting  scientific  publications,  and indicate your *
+// * acceptance of all terms of the Geant4 Software license.          *
+// ********************************************************************
+//
+//
+/// \file StratifiedSource.cc
+/// \brief Implementation of the StratifiedSource class
+
+#include "StratifiedSource.hh"
+
+#include "G4TransportationManager.hh"
+#include "G4Navigator.hh"
+#include "G4VPhysicalVolume.hh"
+#include "G4LogicalVolume.hh"
+#include "G4Tubs.hh"
+#include "G4AffineTransform.hh"
+#include "G4SystemOfUnits.hh"
+#include "Randomize.hh"
+
+#include <algorithm>
+#include <cmath>
+#include <sstream>
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+StratifiedSource::StratifiedSource():
+fVertices(nullptr),
+fTotal(-1),
+bChanged(true),
+fBuiltRadialZones(0),
+fBuiltDepthZones(0),
+bActive(false),
+fRadialZones(4),
+fDepthZones(1),
+fAllocation("proportional"){
+    fMessenger = new G4GenericMessenger(this,
+                                        "/stratified/",
+                                        "Stratified sampling of the primary ions in the disks" );
+    
+    fMessenger->DeclareProperty("setActive", bActive,
+                                "sample the primary positions by strata of disk, radius and depth" );
+    fMessenger->DeclareProperty("setRadialZones", fRadialZones,
+                                "number of rings of equal area per disk" );
+    fMessenger->DeclareProperty("setDepthZones", fDepthZones,
+                                "number of slabs of equal thickness per disk" );
+    fMessenger->DeclareProperty("setAllocation", fAllocation,
+                                "ions per stratum proportional to the share or neyman" ).SetCandidates("proportional neyman");
+    fMessenger->DeclareMethod("setDiskShare", &StratifiedSource::SetDiskShare,
+                              "disk;share of the production, the other disks are not sampled" );
+    fMessenger->DeclareMethod("clearDiskShares", &StratifiedSource::ClearDiskShares,
+                              "production shares proportional to the volume of the disks" );
+    fMessenger->DeclareMethod("setSigmas", &StratifiedSource::SetSigmas,
+                              "standard deviation of the release per stratum, separated by ;" );
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+StratifiedSource::~StratifiedSource(){
+    delete fMessenger;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void StratifiedSource::SetDiskShare(std::string s){
+    std::istringstream tokenStream(s);
+    std::string disk, share;
+    if(!std::getline(tokenStream,disk,';') || !std::getline(tokenStream,share,';')){
+        return;
+    }
+    fDiskShare[std::stoi(disk)] = std::stod(share);
+    bChanged = true;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void StratifiedSource::ClearDiskShares(){
+    fDiskShare.clear();
+    bChanged = true;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void StratifiedSource::SetVertices(const VertexFile* vertices){
+    fVertices = vertices;
+    bChanged = true;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void StratifiedSource::SetSigmas(std::string s){
+    fSigma.clear();
+    std::istringstream tokenStream(s);
+    std::string token;
+    while(std::getline(tokenStream,token,';')){
+        fSigma.push_back(std::stod(token));
+    }
+    fTotal = -1;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+G4bool StratifiedSource::Setup(){
+    fStrata.clear();
+    fTotal = -1;
+    bChanged = false;
+    fBuiltRadialZones = fRadialZones;
+    fBuiltDepthZones = fDepthZones;
+    
+    G4int radialZones = std::max(fRadialZones,1);
+    G4int depthZones = std::max(fDepthZones,1);
+    
+    G4VPhysicalVolume* world = G4TransportationManager::GetTransportationManager()->
+        GetNavigatorForTracking()->GetWorldVolume();
+    G4LogicalVolume* worldLogical = world->GetLogicalVolume();
+    
+    std::vector<G4VPhysicalVolume*> disks;
+    std::vector<G4double> shares;
+    G4double total = 0.;
+    for(size_t i0=0;i0<worldLogical->GetNoDaughters();i0++){
+        G4VPhysicalVolume* volume = worldLogical->GetDaughter(i0);
+        G4LogicalVolume* logical = volume->GetLogicalVolume();
+        if(logical->GetName().compare(0,4,"Disk") != 0 ||
+           dynamic_cast<G4Tubs*>(logical->GetSolid()) == nullptr){
+            continue;
+        }
+        G4double share = logical->GetSolid()->GetCubicVolume();
+        if(!fDiskShare.empty()){
+            auto search = fDiskShare.find(volume->GetCopyNo());
+            share = (search != fDiskShare.end()) ? search->second : 0.;
+        }
+        if(share <= 0.){
+            continue;
+        }
+        disks.push_back(volume);
+        shares.push_back(share);
+        total += share;
+    }
+    if(disks.empty()){
+        G4Exception("StratifiedSource::Setup",
+                    "eff0011",
+                    JustWarning,
+                    "No disk to sample for the stratified source.");
+        return false;
+    }
+    
+    for(size_t i0=0;i0<disks.size();i0++){
+        G4Tubs* tubs = static_cast<G4Tubs*>(disks[i0]->GetLogicalVolume()->GetSolid());
+        G4double rMin2 = tubs->GetInnerRadius() * tubs->GetInnerRadius();
+        G4double rMax2 = tubs->GetOuterRadius() * tubs->GetOuterRadius();
+        G4double dz = tubs->GetZHalfLength();
+        for(G4int ir=0;ir<radialZones;ir++){
+            for(G4int iz=0;iz<depthZones;iz++){
+                Stratum stratum;
+                stratum.fVolume = disks[i0];
+                stratum.fRMin = std::sqrt(rMin2 + (rMax2 - rMin2) * ir / radialZones);
+                stratum.fRMax = std::sqrt(rMin2 + (rMax2 - rMin2) * (ir + 1) / radialZones);
+                stratum.fZMin = -dz + 2. * dz * iz / depthZones;
+                stratum.fZMax = -dz + 2. * dz * (iz + 1) / depthZones;
+                stratum.fPhiStart = tubs->GetStartPhiAngle();
+                stratum.fPhiDelta = tubs->GetDeltaPhiAngle();
+                stratum.fShare = shares[i0] / total / (radialZones * depthZones);
+                fStrata.push_back(stratum);
+            }
+        }
+    }
+    
+    if(fVertices != nullptr){
+        AssignVertices(disks,radialZones,depthZones);
+        if(fStrata.empty()){
+            G4Exception("StratifiedSource::Setup",
+                        "eff0011",
+                        JustWarning,
+                        "No vertex of the vertex file in the disks to sample.");
+            return false;
+        }
+    }
+    
+    G4cout << "--- StratifiedSource: " << fStrata.size() << " strata in "
+    << disks.size() << " disks" << G4endl;
+    return true;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void StratifiedSource::AssignVertices(const std::vector<G4VPhysicalVolume*>& disks,
+                                      G4int radialZones,G4int depthZones){
+    std::vector<G4AffineTransform> toLocal;
+    for(auto disk : disks){
+        toLocal.push_back(G4AffineTransform(disk->GetRotation(),disk->GetTranslation()).Inverse());
+    }
+    
+    // Stratum of each record from its position in the frame of the disk,
+    // the strata of a disk are stored radius first then depth
+    G4long outside = 0;
+    G4int strataPerDisk = radialZones * depthZones;
+    for(G4long i0=0;i0<fVertices->GetNumberOfRecords();i0++){
+        const VertexFile::Record& record = fVertices->GetRecord(i0);
+        if(record.fWeight <= 0.){
+            continue;
+        }
+        G4ThreeVector position(record.fPosition[0] * mm,
+                               record.fPosition[1] * mm,
+                               record.fPosition[2] * mm);
+        G4int stratum = -1;
+        for(size_t i1=0;i1<disks.size() && stratum < 0;i1++){
+            G4Tubs* tubs = static_cast<G4Tubs*>(disks[i1]->GetLogicalVolume()->GetSolid());
+            G4ThreeVector local = toLocal[i1].TransformPoint(position);
+            if(tubs->Inside(local) == kOutside){
+                continue;
+            }
+            G4double rMin2 = tubs->GetInnerRadius() * tubs->GetInnerRadius();
+            G4double rMax2 = tubs->GetOuterRadius() * tubs->GetOuterRadius();
+            G4double dz = tubs->GetZHalfLength();
+            G4int ir = G4int((local.perp2() - rMin2) / (rMax2 - rMin2) * radialZones);
+            G4int iz = G4int((local.z() + dz) / (2. * dz) * depthZones);
+            ir = std::min(std::max(ir,0),radialZones - 1);
+            iz = std::min(std::max(iz,0),depthZones - 1);
+            stratum = G4int(i1) * strataPerDisk + ir * depthZones + iz;
+        }
+        if(stratum < 0){
+            outside++;
+            continue;
+        }
+        Stratum& s = fStrata[stratum];
+        G4double cumulative = s.fRecordCumulative.empty() ? 0. : s.fRecordCumulative.back();
+        s.fRecords.push_back(i0);
+        s.fRecordCumulative.push_back(cumulative + record.fWeight);
+    }
+    
+    // Share of the production from the weight of the records, the strata
+    // without record are never sampled
+    G4double total = 0.;
+    for(auto& s : fStrata){
+        total += s.fRecordCumulative.empty() ? 0. : s.fRecordCumulative.back();
+    }
+    std::vector<Stratum> strata;
+    for(auto& s : fStrata){
+        if(s.fRecords.empty()) continue;
+        s.fShare = s.fRecordCumulative.back() / total;
+        strata.push_back(std::move(s));
+    }
+    fStrata.swap(strata);
+    
+    if(outside > 0){
+        G4cout << "--- StratifiedSource: " << outside
+        << " vertices outside the sampled disks are ignored" << G4endl;
+    }
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void StratifiedSource::BuildAllocation(G4long total){
+    fTotal = total;
+    fBuiltAllocation = fAllocation;
+    
+    size_t strata = fStrata.size();
+    G4bool neyman = (fAllocation == "neyman");
+    if(neyman && fSigma.size() != strata){
+        G4Exception("StratifiedSource::BuildAllocation",
+                    "eff0011",
+                    JustWarning,
+                    "No sigma for each stratum, the allocation is proportional.");
+        neyman = false;
+    }
+    
+    std::vector<G4double> weight(strata);
+    G4double sum = 0.;
+    for(size_t i0=0;i0<strata;i0++){
+        weight[i0] = fStrata[i0].fShare * (neyman ? fSigma[i0] : 1.);
+        sum += weight[i0];
+    }
+    if(sum <= 0.){
+        for(size_t i0=0;i0<strata;i0++){
+            weight[i0] = fStrata[i0].fShare;
+        }
+        sum = 1.;
+    }
+    
+    // One ion per stratum first, so that every stratum has an estimate,
+    // then the others as allocated
+    G4double first = (G4double(total) >= G4double(strata)) ? 1. : 0.;
+    G4double others = G4double(total) - first * strata;
+    if(first == 0.){
+        G4Exception("StratifiedSource::BuildAllocation",
+                    "eff0011",
+                    JustWarning,
+                    "Fewer ions than strata, some strata have no ion and the stratified release fraction is not estimated.");
+    }
+    fCumulative.resize(strata);
+    G4double cumulative = 0.;
+    for(size_t i0=0;i0<strata;i0++){
+        cumulative += first + others * weight[i0] / sum;
+        fCumulative[i0] = cumulative;
+    }
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+G4int StratifiedSource::GetStratum(G4long index,G4long total){
+    if(bChanged || fBuiltRadialZones != fRadialZones || fBuiltDepthZones != fDepthZones){
+        if(!Setup()) return -1;
+    }
+    if(fStrata.empty() || total <= 0){
+        return -1;
+    }
+    if(total != fTotal || fBuiltAllocation != fAllocation){
+        BuildAllocation(total);
+    }
+    
+    // Systematic assignment of the ions of the run, the stratum of an ion
+    // depends only on its index and not on the thread simulating it
+    G4double position = G4double(index % total) + 0.5;
+    size_t stratum = std::upper_bound(fCumulative.begin(),fCumulative.end(),position) - fCumulative.begin();
+    return G4int(std::min(stratum,fStrata.size() - 1));
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+const VertexFile::Record* StratifiedSource::SampleRecord(G4int stratum,G4double u) const{
+    const Stratum& s = fStrata[stratum];
+    if(s.fRecords.empty()){
+        return nullptr;
+    }
+    size_t entry = std::upper_bound(s.fRecordCumulative.begin(),s.fRecordCumulative.end(),
+                                    u * s.fRecordCumulative.back()) - s.fRecordCumulative.begin();
+    return &fVertices->GetRecord(s.fRecords[std::min(entry,s.fRecords.size() - 1)]);
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+G4ThreeVector StratifiedSource::SamplePosition(G4int stratum,const G4double* u) const{
+    const Stratum& s = fStrata[stratum];
+    G4double u0 = u ? u[0] : G4UniformRand();
+    G4double u1 = u ? u[1] : G4UniformRand();
+    G4double u2 = u ? u[2] : G4UniformRand();
+    G4double r = std::sqrt(s.fRMin * s.fRMin + (s.fRMax * s.fRMax - s.fRMin * s.fRMin) * u0);
+    G4double phi = s.fPhiStart + s.fPhiDelta * u1;
+    G4double z = s.fZMin + (s.fZMax - s.fZMin) * u2;
+    G4AffineTransform transform(s.fVolume->GetRotation(),s.fVolume->GetTranslation());
+    return transform.TransformPoint(G4ThreeVector(r * std::cos(phi),r * std::sin(phi),z));
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
@@ -0,0 +1,180 @@
+//
+// ********************************************************************
+// * License and Disclaimer                                           *
+// *                                                                  *
+// * The  Geant4 software  is  copyright of the Copyright Holders  of *
+// * the Geant4 Collaboration.  It is provided  under  the terms  and *
+// * conditions of the Geant4 Software License,  included in the file *
+// * LICENSE and available at  http://cern.ch/geant4/license .  These *
+// * include a list of copyright holders.                             *
+// *                                                                  *
+// * Neither the authors of this software system, nor their employing *
+// * institutes,nor the agencies providing financial support for this *
+// * work  make  any representation or  warranty, express or implied, *
+// * regarding  this  software system or assume any liability for its *
+// * use.  Please see the license in the file  LICENSE  and URL above *
+// * for the full disclaimer and the limitation of liability.         *
+// *                                                                  *
+// * This  code  implementation is the result of  the  scientific and *
+// * technical work of the GEANT4 collaboration.                      *
+// * By using,  copying,  modifying or  distributing the software (or *
+// * any work based  on the software)  you  agree  to acknowledge its *
+// * use  in  resulting  scientific  publications,  and indicate your *
+// * acceptance of all terms of the Geant4 Software license.          *
+// ********************************************************************
+//
+//
+/// \file SurfaceNormalProvider.cc
+/// \brief Implementation of the SurfaceNormalProvider class
+
+#include "SurfaceNormalProvider.hh"
+
+#include "G4TransportationManager.hh"
+#include "G4Navigator.hh"
+#include "G4VPhysicalVolume.hh"
+#include "G4LogicalVolume.hh"
+#include "G4Tubs.hh"
+#include "G4CutTubs.hh"
+#include "G4Box.hh"
+#include "G4PhysicalConstants.hh"
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+SurfaceNormalProvider::SurfaceNormalProvider()
+: bImported(false),
+fLastVolume(0),
+fLastEntry(0){;}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+SurfaceNormalProvider::~SurfaceNormalProvider(){;}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void SurfaceNormalProvider::MakeEntry(const G4VSolid* solid,Entry& entry){
+    entry.fType = kUnsupported;
+    entry.fRmin = 0.;
+    entry.fRmax = 0.;
+    entry.fDz = 0.;
+    entry.fLowNorm = G4ThreeVector(0.,0.,-1.);
+    entry.fHighNorm = G4ThreeVector(0.,0.,1.);
+    
+    if(const G4CutTubs* cutTubs = dynamic_cast<const G4CutTubs*>(solid)){
+        if(cutTubs->GetDeltaPhiAngle() < CLHEP::twopi - 1.e-9) return;
+        entry.fType = kTube;
+        entry.fRmin = cutTubs->GetInnerRadius();
+        entry.fRmax = cutTubs->GetOuterRadius();
+        entry.fDz = cutTubs->GetZHalfLength();
+        entry.fLowNorm = cutTubs->GetLowNorm();
+        entry.fHighNorm = cutTubs->GetHighNorm();
+    }
+    else if(const G4Tubs* tubs = dynamic_cast<const G4Tubs*>(solid)){
+        if(tubs->GetDeltaPhiAngle() < CLHEP::twopi - 1.e-9) return;
+        entry.fType = kTube;
+        entry.fRmin = tubs->GetInnerRadius();
+        entry.fRmax = tubs->GetOuterRadius();
+        entry.fDz = tubs->GetZHalfLength();
+    }
+    else if(const G4Box* box = dynamic_cast<const G4Box*>(solid)){
+        entry.fType = kBox;
+        entry.fHalf = G4ThreeVector(box->GetXHalfLength(),
+                                    box->GetYHalfLength(),
+                                    box->GetZHalfLength());
+    }
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void SurfaceNormalProvider::Import(){
+    bImported = true;
+    fEntries.clear();
+    fIndex.clear();
+    fLastVolume = 0;
+    fLastEntry = 0;
+    
+    G4VPhysicalVolume* world = G4TransportationManager::GetTransportationManager()->
+        GetNavigatorForTracking()->GetWorldVolume();
+    if(!world) return;
+    G4LogicalVolume* worldLogical = world->GetLogicalVolume();
+    
+    fEntries.resize(worldLogical->GetNoDaughters());
+    for(size_t i0=0;i0<worldLogical->GetNoDaughters();i0++){
+        G4VPhysicalVolume* volume = worldLogical->GetDaughter(i0);
+        Entry& entry = fEntries[i0];
+        MakeEntry(volume->GetLogicalVolume()->GetSolid(),entry);
+        entry.fToGlobal = G4AffineTransform(volume->GetRotation(),volume->GetTranslation());
+        entry.fToLocal = entry.fToGlobal.Inverse();
+        fIndex[volume] = i0;
+    }
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+G4bool SurfaceNormalProvider::GetGlobalNormal(const G4VPhysicalVolume* volume,
+                                              const G4ThreeVector& globalPoint,
+                                              G4ThreeVector& globalNormal){
+    if(volume != fLastVolume){
+        if(!bImported) Import();
+        std::unordered_map<const G4VPhysicalVolume*,size_t>::const_iterator it =
+        fIndex.find(volume);
+        fLastVolume = volume;
+        fLastEntry = (it == fIndex.end()) ? 0 : &fEntries[it->second];
+    }
+    if(!fLastEntry || fLastEntry->fType == kUnsupported) return false;
+    
+    G4ThreeVector localPoint = fLastEntry->fToLocal.TransformPoint(globalPoint);
+    G4ThreeVector localNormal = (fLastEntry->fType == kTube) ?
+        TubeNormal(*fLastEntry,localPoint) : BoxNormal(*fLastEntry,localPoint);
+    globalNormal = fLastEntry->fToGlobal.TransformAxis(localNormal);
+    return true;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+G4ThreeVector SurfaceNormalProvider::TubeNormal(const Entry& entry,
+                                                const G4ThreeVector& p){
+    G4double rho = p.perp();
+    
+    // Outer surface
+    G4double distance = std::fabs(rho - entry.fRmax);
+    G4ThreeVector normal = (rho > 0.) ? G4ThreeVector(p.x()/rho,p.y()/rho,0.)
+                                      : G4ThreeVector(1.,0.,0.);
+    
+    // Inner surface
+    if(entry.fRmin > 0. && std::fabs(rho - entry.fRmin) < distance){
+        distance = std::fabs(rho - entry.fRmin);
+        normal = -normal;
+    }
+    
+    // Cuts through (0,0,-fDz) and (0,0,+fDz), planar ends for G4Tubs
+    G4double low = std::fabs(entry.fLowNorm.dot(p - G4ThreeVector(0.,0.,-entry.fDz)));
+    if(low < distance){
+        distance = low;
+        normal = entry.fLowNorm;
+    }
+    G4double high = std::fabs(entry.fHighNorm.dot(p - G4ThreeVector(0.,0.,entry.fDz)));
+    if(high < distance){
+        normal = entry.fHighNorm;
+    }
+    return normal;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+G4ThreeVector SurfaceNormalProvider::BoxNormal(const Entry& entry,
+                                               const G4ThreeVector& p){
+    G4int axis = 0;
+    G4double distance = DBL_MAX;
+    for(G4int i0=0;i0<3;i0++){
+        G4double d = std::fabs(entry.fHalf[i0] - std::fabs(p[i0]));
+        if(d < distance){
+            distance = d;
+            axis = i0;
+        }
+    }
+    G4ThreeVector normal;
+    normal[axis] = (p[axis] < 0.) ? -1. : 1.;
+    return normal;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
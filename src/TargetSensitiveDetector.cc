@@ -42,6 +42,7 @@
 
 #include "G4TrajectoryContainer.hh"
 #include "G4RunManager.hh"
+#include "TrackingAction.hh"
 
 TargetSensitiveDetector::TargetSensitiveDetector(G4String name,G4int type):G4VSensitiveDetector(name),
 detType(type)
@@ -103,7 +104,7 @@ bool TargetSensitiveDetector::ProcessHits(G4Step *aStep,G4TouchableHistory* /*RO
     TargetSensitiveDetectorHit* aHit = new TargetSensitiveDetectorHit();
     aHit->SetTrackID(vTrack->GetTrackID());
     
-    if(vTrack->GetTrackID() == 1 ){
+    if(vTrack->GetParentID() == 0 ){
         aHit->SetAP(-1);
         aHit->SetZP(-1);
     }
@@ -122,6 +123,15 @@ bool TargetSensitiveDetector::ProcessHits(G4Step *aStep,G4TouchableHistory* /*RO
     G4VPhysicalVolume* thePhysical = theTouchable->GetVolume(0);
     G4int copyNo = thePhysical->GetCopyNo();
     aHit->SetDiskNumber(copyNo);
+    
+    // Primary ion of the track, the tracking action follows the ancestry
+    // of all the tracks while the detector only sees the ones inside it
+    const TrackingAction* trackingAction =
+        static_cast<const TrackingAction*>(G4RunManager::GetRunManager()->GetUserTrackingAction());
+    if(trackingAction){
+        aHit->SetIon(trackingAction->GetIon(vTrack->GetTrackID()));
+        aHit->SetWeight(trackingAction->GetSourceWeight(vTrack->GetTrackID()));
+    }
 
     fHitsCollection->insert(aHit);
 
@@ -57,6 +57,8 @@ TargetSensitiveDetectorHit::TargetSensitiveDetectorHit()
     fWorldPos = G4ThreeVector(0.,0.,0.);
     fLocalPos = G4ThreeVector(0.,0.,0.);
     fEnergy = 0.;
+    fIon = -1;
+    fWeight = 1.;
 }
 
 //....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo....
@@ -82,6 +84,8 @@ TargetSensitiveDetectorHit::TargetSensitiveDetectorHit(const TargetSensitiveDete
     fTime = right.fTime;
     fEnergy = right.fEnergy;
     fEnergyPrevious = right.fEnergyPrevious;
+    fIon = right.fIon;
+    fWeight = right.fWeight;
 }
 
 //....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo....
@@ -98,6 +102,8 @@ const TargetSensitiveDetectorHit& TargetSensitiveDetectorHit::operator=(const Ta
     fTime = right.fTime;
     fEnergy = right.fEnergy;
     fEnergyPrevious = right.fEnergyPrevious;
+    fIon = right.fIon;
+    fWeight = right.fWeight;
     return *this;
 }
 
@@ -0,0 +1,110 @@
+//
+// ********************************************************************
+// * License and Disclaimer                                           *
+// *                                                                  *
+// * The  Geant4 software  is  copyright of the Copyright Holders  of *
+// * the Geant4 Collaboration.  It is provided  under  the terms  and *
+// * conditions of the Geant4 Software License,  included in the file *
+// * LICENSE and available at  http://cern.ch/geant4/license .  These *
+// * include a list of copyright holders.                             *
+// *                                                                  *
+// * Neither the authors of this software system, nor their employing *
+// * institutes,nor the agencies providing financial support for this *
+// * work  make  any representation or  warranty, express or implied, *
+// * regarding  this  software system or assume any liability for its *
+// * use.  Please see the license in the file  LICENSE  and URL above *
+// * for the full disclaimer and the limitation of liability.         *
+// *                                                                  *
+// * This  code  implementation is the result of  the  scientific and *
+// * technical work of the GEANT4 collaboration.                      *
+// * By using,  copying,  modifying or  distributing the software (or *
+// * any work based  on the software)  you  agree  to acknowledge its *
+// * use  in  resulting  scientific  publications,  and indicate your *
+// * acceptance of all terms of the Geant4 Software license.          *
+// ********************************************************************
+//
+//
+/// \file ThermalEnergyTable.cc
+/// \brief Implementation of the ThermalEnergyTable class
+
+#include "ThermalEnergyTable.hh"
+
+#include "G4Material.hh"
+#include "G4PhysicalConstants.hh"
+
+#include <cmath>
+
+G4ThreadLocal ThermalEnergyTable* ThermalEnergyTable::fInstance = 0;
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+ThermalEnergyTable* ThermalEnergyTable::Instance(){
+    if(!fInstance){
+        fInstance = new ThermalEnergyTable();
+    }
+    return fInstance;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+ThermalEnergyTable::ThermalEnergyTable(){
+    G4double x = 0.;
+    for(G4int i0=0;i0<fBins;i0++){
+        x = InverseCDF(G4double(i0) / fBins,x);
+        fInverseCDF[i0] = x;
+    }
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+ThermalEnergyTable::~ThermalEnergyTable(){;}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+G4double ThermalEnergyTable::InverseCDF(G4double u,G4double x){
+    // CDF 1 - (1+x) exp(-x), Newton from the guess x, which is below the
+    // solution when it comes from the previous node
+    if(u <= 0.) return 0.;
+    if(x <= 0.) x = std::sqrt(2. * u);
+    for(G4int i0=0;i0<100;i0++){
+        G4double f = 1. - (1. + x) * std::exp(-x) - u;
+        G4double df = x * std::exp(-x);
+        if(df <= 0.) break;
+        G4double dx = f / df;
+        x -= dx;
+        if(x <= 0.) x = 1.e-12;
+        if(std::fabs(dx) < 1.e-12 * x) break;
+    }
+    return x;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void ThermalEnergyTable::Build(){
+    const G4MaterialTable* materials = G4Material::GetMaterialTable();
+    fkT.resize(materials->size());
+    for(size_t i0=0;i0<materials->size();i0++){
+        fkT[i0] = CLHEP::k_Boltzmann * (*materials)[i0]->GetTemperature();
+    }
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+G4double ThermalEnergyTable::Sample(const G4Material* material,G4double u){
+    if(material->GetIndex() >= fkT.size()){
+        Build();
+    }
+    
+    G4double position = u * fBins;
+    G4int bin = G4int(position);
+    G4double x = 0.;
+    if(bin < fBins - 1){
+        x = fInverseCDF[bin] + (fInverseCDF[bin + 1] - fInverseCDF[bin]) * (position - bin);
+    }
+    else{
+        x = InverseCDF(u,fInverseCDF[fBins - 1]);
+    }
+    return x * fkT[material->GetIndex()];
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
@@ -0,0 +1,196 @@
+//
+// ********************************************************************
+// * License and Disclaimer                                           *
+// *                                                                  *
+// * The  Geant4 software  is  copyright of the Copyright Holders  of *
+// * the Geant4 Collaboration.  It is provided  under  the terms  and *
+// * conditions of the Geant4 Software License,  included in the file *
+// * LICENSE and available at  http://cern.ch/geant4/license .  These *
+// * include a list of copyright holders.                             *
+// *                                                                  *
+// * Neither the authors of this software system, nor their employing *
+// * institutes,nor the agencies providing financial support for this *
+// * work  make  any representation or  warranty, express or implied, *
+// * regarding  this  software system or assume any liability for its *
+// * use.  Please see the license in the file  LICENSE  and URL above *
+// * for the full disclaimer and the limitation of liability.         *
+// *                                                                  *
+// * This  code  implementation is the result of  the  scientific and *
+// * technical work of the GEANT4 collaboration.                      *
+// * By using,  copying,  modifying or  distributing the software (or *
+// * any work based  on the software)  you  agree  to acknowledge its *
+// * use  in  resulting  scientific  publications,  and indicate your *
+// * acceptance of all terms of the Geant4 Software license.          *
+// ********************************************************************
+//
+
+#include "TrackingAction.hh"
+#include "Run.hh"
+#include "CommonRandomNumbers.hh"
+#include "EffusionProcess.hh"
+
+#include "G4Track.hh"
+#include "G4Step.hh"
+#include "G4VProcess.hh"
+#include "G4RunManager.hh"
+#include "G4EventManager.hh"
+#include "G4Event.hh"
+#include "G4PrimaryVertex.hh"
+#include "G4PrimaryParticle.hh"
+#include "G4LogicalVolume.hh"
+#include "G4VSensitiveDetector.hh"
+#include "G4SystemOfUnits.hh"
+#include "G4PhysicsModelCatalog.hh"
+#include "EffusionTrackData.hh"
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+TrackingAction::TrackingAction()
+: fEffusionID(-1){;}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+TrackingAction::~TrackingAction(){;}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void TrackingAction::ClearEvent(){
+    fOriginDisk.clear();
+    fIon.clear();
+    fSourceWeight.clear();
+    fStreamKey.clear();
+    fDaughters.clear();
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void TrackingAction::PreUserTrackingAction(const G4Track* aTrack){
+    const G4Event* event = G4EventManager::GetEventManager()->GetConstCurrentEvent();
+    G4int eventID = event->GetEventID();
+    
+    if(aTrack->GetParentID() == 0){
+        fIon[aTrack->GetTrackID()] = aTrack->GetTrackID();
+        
+        // The source weight is the one of the primary vertex, as in
+        // Run::RecordEvent, the track weight also carries the biasing
+        G4double weight = 1.;
+        for(G4int i0=0;i0<event->GetNumberOfPrimaryVertex();i0++){
+            G4PrimaryVertex* vertex = event->GetPrimaryVertex(i0);
+            for(G4PrimaryParticle* primary = vertex->GetPrimary();primary;primary=primary->GetNext()){
+                if(primary->GetTrackID() == aTrack->GetTrackID()){
+                    weight = vertex->GetWeight() * primary->GetWeight();
+                }
+            }
+        }
+        fSourceWeight[aTrack->GetTrackID()] = weight;
+    }
+    else{
+        fIon[aTrack->GetTrackID()] = GetIon(aTrack->GetParentID());
+    }
+    
+    // Paired runs: each track draws from its own stream, keyed by the
+    // primary ion or by the parent and the rank among its daughters, so
+    // that a change of the configuration does not shift the numbers of
+    // the other tracks. The physics processes sample their interaction
+    // lengths after this action
+    CommonRandomNumbers* crn = CommonRandomNumbers::Instance();
+    if(crn->IsActive()){
+        uint64_t key;
+        if(aTrack->GetParentID() == 0){
+            key = crn->GetKey(eventID,CommonRandomNumbers::kTransport,aTrack->GetTrackID());
+        }
+        else{
+            key = CommonRandomNumbers::GetDaughterKey(fStreamKey[aTrack->GetParentID()],
+                                                      fDaughters[aTrack->GetParentID()]++);
+        }
+        fStreamKey[aTrack->GetTrackID()] = key;
+        crn->Reseed(key);
+    }
+    
+    // Same convention of the ucx sensitive detector, the disk number is
+    // the copy number of the volume where the track starts
+    G4int disk = -1;
+    G4LogicalVolume* logical = aTrack->GetVolume()->GetLogicalVolume();
+    if(logical->GetSensitiveDetector() &&
+       logical->GetSensitiveDetector()->GetName() == "ucx"){
+        disk = aTrack->GetVolume()->GetCopyNo();
+    }
+    fOriginDisk[aTrack->GetTrackID()] = disk;
+    
+    // The track data of the nuclei is created from the pool here, out of
+    // the stepping, and found by the processes at the start of the track
+    if(aTrack->GetParticleDefinition()->GetParticleType() == "nucleus"){
+        if(fEffusionID == -1){
+            fEffusionID = G4PhysicsModelCatalog::GetIndex("effusion");
+        }
+        if(fEffusionID != -1 &&
+           aTrack->GetAuxiliaryTrackInformation(fEffusionID) == nullptr){
+            aTrack->SetAuxiliaryTrackInformation(fEffusionID,new EffusionTrackData());
+        }
+    }
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void TrackingAction::PostUserTrackingAction(const G4Track* aTrack){
+    if(aTrack->GetParticleDefinition()->GetParticleType() != "nucleus"){
+        return;
+    }
+    
+    Run* run = static_cast<Run*>(G4RunManager::GetRunManager()->GetNonConstCurrentRun());
+    
+    G4int code = run->GetCode(aTrack->GetDefinition()->GetAtomicMass(),
+                              aTrack->GetDefinition()->GetAtomicNumber(),
+                              fOriginDisk[aTrack->GetTrackID()]);
+    run->FillTermination(GetTerminationReason(aTrack),code,aTrack->GetGlobalTime(),
+                         GetSourceWeight(aTrack->GetTrackID()));
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+G4double TrackingAction::GetSourceWeight(G4int trackID) const{
+    std::unordered_map<G4int,G4double>::const_iterator it = fSourceWeight.find(GetIon(trackID));
+    if(it == fSourceWeight.end()){
+        return 1.;
+    }
+    return it->second;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+G4int TrackingAction::GetIon(G4int trackID) const{
+    std::unordered_map<G4int,G4int>::const_iterator it = fIon.find(trackID);
+    if(it == fIon.end()){
+        return -1;
+    }
+    return it->second;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+G4int TrackingAction::GetTerminationReason(const G4Track* aTrack){
+    const G4StepPoint* postStepPoint = aTrack->GetStep()->GetPostStepPoint();
+    
+    if(postStepPoint->GetStepStatus() == fWorldBoundary){
+        return Run::kEscaped;
+    }
+    
+    const G4VProcess* process = postStepPoint->GetProcessDefinedStep();
+    if(!process){
+        return Run::kOther;
+    }
+    if(process->GetProcessType() == fDecay){
+        return Run::kDecayed;
+    }
+    // The effusion process kills the nuclei fully adsorbed on a surface and
+    // the ones still in the target after 100 hours
+    if(process->GetProcessName().find("effusion") != std::string::npos){
+        if(aTrack->GetGlobalTime() > EffusionProcess::fTimeLimit){
+            return Run::kTimeLimit;
+        }
+        return Run::kAdsorbed;
+    }
+    return Run::kOther;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
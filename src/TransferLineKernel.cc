@@ -0,0 +1,322 @@
+//
+// ********************************************************************
+// * License and Disclaimer                                           *
+// *                                                                  *
+// * The  Geant4 software  is  copyright of the Copyright Holders  of *
+// * the Geant4 Collaboration.  It is provided  under  the terms  and *
+// * conditions of the Geant4 Software License,  included in the file *
+// * LICENSE and available at  http://cern.ch/geant4/license .  These *
+// * include a list of copyright holders.                             *
+// *                                                                  *
+// * Neither the authors of this software system, nor their employing *
+// * institutes,nor the agencies providing financial support for this *
+// * work  make  any representation or  warranty, express or implied, *
+// * regarding  this  software system or assume any liability for its *
+// * use.  Please see the license in the file  LICENSE  and URL above *
+// * for the full disclaimer and the limitation of liability.         *
+// *                                                                  *
+// * This  code  implementation is the result of  the  scientific and *
+// * technical work of the GEANT4 collaboration.                      *
+// * By using,  copying,  modifying or  distributing the software (or *
+// * any work based  on the software)  you  agree  to acknowledge its *
+// * use  in  resulting  scientific  publications,  and indicate your *
+// * acceptance of all terms of the Geant4 Software license.          *
+// ********************************************************************
+//
+//
+/// \file TransferLineKernel.cc
+/// \brief Implementation of the TransferLineKernel class
+
+#include "TransferLineKernel.hh"
+
+#include "G4VPhysicalVolume.hh"
+#include "G4LogicalVolume.hh"
+#include "G4PhysicalVolumeStore.hh"
+#include "G4LogicalVolumeStore.hh"
+#include "G4CutTubs.hh"
+#include "G4Material.hh"
+#include "G4Element.hh"
+#include "G4RandomTools.hh"
+#include "G4SystemOfUnits.hh"
+#include "Randomize.hh"
+
+#include <cmath>
+#include <cstdint>
+#include <fstream>
+
+// Tolerance on the position of the entrance and on the geometry key,
+// and on the cosine between the exit normal and the cut normals
+const G4double TransferLineKernel::fTolerance = 1.e-6 * CLHEP::mm;
+const G4double TransferLineKernel::fNormalTolerance = 1.e-9;
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+TransferLineKernel::TransferLineKernel():
+fWallZ(0){
+    fBore[0] = fBore[1] = 0;
+    fSolid[0] = fSolid[1] = 0;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+TransferLineKernel::~TransferLineKernel(){}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+G4bool TransferLineKernel::SetupGeometry(){
+    fGeometryKey.clear();
+    const char* names[2] = {"TransferBore1.Physical","TransferBore2.Physical"};
+    for(G4int i0=0;i0<2;i0++){
+        fBore[i0] = G4PhysicalVolumeStore::GetInstance()->GetVolume(names[i0],false);
+        if(!fBore[i0]) return false;
+        fSolid[i0] = dynamic_cast<const G4CutTubs*>(fBore[i0]->GetLogicalVolume()->GetSolid());
+        if(!fSolid[i0]) return false;
+        
+        // The envelopes are placed in the world
+        fToGlobal[i0] = G4AffineTransform(fBore[i0]->GetRotation(),fBore[i0]->GetTranslation());
+        fToLocal[i0] = fToGlobal[i0].Inverse();
+        
+        G4ThreeVector lowNorm = fSolid[i0]->GetLowNorm();
+        G4ThreeVector highNorm = fSolid[i0]->GetHighNorm();
+        G4ThreeVector translation = fBore[i0]->GetTranslation();
+        G4RotationMatrix rotation;
+        if(fBore[i0]->GetRotation()) rotation = *fBore[i0]->GetRotation();
+        G4double key[] = {fSolid[i0]->GetOuterRadius(),fSolid[i0]->GetZHalfLength(),
+            lowNorm.x(),lowNorm.y(),lowNorm.z(),
+            highNorm.x(),highNorm.y(),highNorm.z(),
+            translation.x(),translation.y(),translation.z(),
+            rotation.xx(),rotation.xy(),rotation.xz(),
+            rotation.yx(),rotation.yy(),rotation.yz(),
+            rotation.zx(),rotation.zy(),rotation.zz()};
+        fGeometryKey.insert(fGeometryKey.end(),key,key + sizeof(key) / sizeof(G4double));
+    }
+    
+    fWallZ = 0;
+    G4LogicalVolume* wall = G4LogicalVolumeStore::GetInstance()->GetVolume("Transfer1.Logic",false);
+    if(wall){
+        const G4ElementVector* theElementVector = wall->GetMaterial()->GetElementVector();
+        fWallZ = G4int(std::round((*theElementVector)[0]->GetZ()));
+    }
+    return true;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+G4bool TransferLineKernel::Trace(Entry& entry) const{
+    entry.fTransmitted = false;
+    entry.fLength = 0.;
+    entry.fHits = 0;
+    
+    // Uniform point on the entrance and cosine law around its inner normal
+    const G4ThreeVector lowNorm = fSolid[0]->GetLowNorm();
+    G4double radius = fSolid[0]->GetOuterRadius() * std::sqrt(G4UniformRand());
+    G4double phi = CLHEP::twopi * G4UniformRand();
+    G4double x = radius * std::cos(phi);
+    G4double y = radius * std::sin(phi);
+    G4double z = - fSolid[0]->GetZHalfLength() - (lowNorm.x() * x + lowNorm.y() * y) / lowNorm.z();
+    G4ThreeVector point(x,y,z);
+    G4ThreeVector direction = G4LambertianRand(-lowNorm);
+    
+    G4int section = 0;
+    for(G4int i0=0;i0<fMaxSteps;i0++){
+        const G4CutTubs* solid = fSolid[section];
+        G4bool validNorm = false;
+        G4ThreeVector normal;
+        G4double step = solid->DistanceToOut(point,direction,true,&validNorm,&normal);
+        point += step * direction;
+        entry.fLength += step;
+        
+        G4bool low = normal.dot(solid->GetLowNorm()) > 1. - fNormalTolerance;
+        G4bool high = normal.dot(solid->GetHighNorm()) > 1. - fNormalTolerance;
+        if((low && section == 0) || (high && section == 1)){
+            entry.fTransmitted = (section == 1);
+            entry.fPosition = point;
+            entry.fDirection = direction;
+            return true;
+        }
+        if(low || high){
+            // Junction between the two sections
+            G4int next = 1 - section;
+            point = fToLocal[next].TransformPoint(fToGlobal[section].TransformPoint(point));
+            direction = fToLocal[next].TransformAxis(fToGlobal[section].TransformAxis(direction));
+            section = next;
+            continue;
+        }
+        
+        // Wall hit, the outward normal is flipped as in EffusionProcess
+        entry.fHits++;
+        direction = G4LambertianRand(-normal);
+    }
+    return false;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+G4bool TransferLineKernel::Build(G4int histories){
+    fEntries.clear();
+    if(!SetupGeometry()){
+        G4Exception("TransferLineKernel::Build",
+                    "eff0006",
+                    JustWarning,
+                    "Transfer line envelopes not found, they are built with /det/setTransferFastSim true.");
+        return false;
+    }
+    
+    fEntries.reserve(histories);
+    G4int lost = 0;
+    G4double hits = 0.;
+    for(G4int i0=0;i0<histories;i0++){
+        Entry entry;
+        if(Trace(entry)){
+            fEntries.push_back(entry);
+            hits += entry.fHits;
+        }
+        else{
+            lost++;
+        }
+    }
+    
+    G4cout << "--- TransferLineKernel: " << fEntries.size() << " histories, "
+    << lost << " lost, transmission " << GetTransmission()
+    << ", mean number of wall hits " << (fEntries.empty() ? 0. : hits / fEntries.size())
+    << G4endl;
+    return !fEntries.empty();
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+G4bool TransferLineKernel::Write(const G4String& fileName) const{
+    // Layout (native byte order):
+    //   char[8] "EFF10TLK", int32 version, int32 wall Z,
+    //   int32 n, n x double geometry key [mm],
+    //   int64 n, n x (int32 transmitted, int32 hits,
+    //                 double position[3] [mm], double direction[3], double length [mm])
+    std::ofstream fFileOut;
+    fFileOut.open(fileName,std::ofstream::out | std::ofstream::binary | std::ofstream::trunc);
+    
+    const char magic[8] = {'E','F','F','1','0','T','L','K'};
+    int32_t header[3] = {1,fWallZ,int32_t(fGeometryKey.size())};
+    fFileOut.write(magic,sizeof(magic));
+    fFileOut.write(reinterpret_cast<const char*>(header),sizeof(header));
+    fFileOut.write(reinterpret_cast<const char*>(fGeometryKey.data()),
+                   fGeometryKey.size() * sizeof(G4double));
+    
+    int64_t entries = int64_t(fEntries.size());
+    fFileOut.write(reinterpret_cast<const char*>(&entries),sizeof(entries));
+    for(auto& entry : fEntries){
+        int32_t flags[2] = {entry.fTransmitted ? 1 : 0,entry.fHits};
+        G4double values[7] = {entry.fPosition.x(),entry.fPosition.y(),entry.fPosition.z(),
+            entry.fDirection.x(),entry.fDirection.y(),entry.fDirection.z(),
+            entry.fLength};
+        fFileOut.write(reinterpret_cast<const char*>(flags),sizeof(flags));
+        fFileOut.write(reinterpret_cast<const char*>(values),sizeof(values));
+    }
+    fFileOut.close();
+    return !fFileOut.fail();
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+G4bool TransferLineKernel::Read(const G4String& fileName){
+    fEntries.clear();
+    if(!SetupGeometry()) return false;
+    
+    std::ifstream fFileIn;
+    fFileIn.open(fileName,std::ifstream::in | std::ifstream::binary);
+    
+    char magic[8];
+    int32_t header[3];
+    fFileIn.read(magic,sizeof(magic));
+    fFileIn.read(reinterpret_cast<char*>(header),sizeof(header));
+    if(fFileIn.fail() || std::string(magic,8) != "EFF10TLK" || header[0] != 1){
+        G4Exception("TransferLineKernel::Read",
+                    "eff0006",
+                    JustWarning,
+                    "Cannot read the transfer line kernel.");
+        return false;
+    }
+    
+    std::vector<G4double> key(header[2] > 0 ? header[2] : 0);
+    fFileIn.read(reinterpret_cast<char*>(key.data()),key.size() * sizeof(G4double));
+    G4bool sameGeometry = (key.size() == fGeometryKey.size()) && header[1] == fWallZ;
+    for(size_t i0=0;sameGeometry && i0<key.size();i0++){
+        sameGeometry = std::fabs(key[i0] - fGeometryKey[i0]) < fTolerance;
+    }
+    if(!sameGeometry){
+        G4Exception("TransferLineKernel::Read",
+                    "eff0006",
+                    JustWarning,
+                    "Transfer line kernel built for a different geometry.");
+        return false;
+    }
+    
+    int64_t entries = 0;
+    fFileIn.read(reinterpret_cast<char*>(&entries),sizeof(entries));
+    fEntries.reserve(entries > 0 ? entries : 0);
+    for(int64_t i0=0;i0<entries;i0++){
+        int32_t flags[2];
+        G4double values[7];
+        fFileIn.read(reinterpret_cast<char*>(flags),sizeof(flags));
+        fFileIn.read(reinterpret_cast<char*>(values),sizeof(values));
+        if(fFileIn.fail()) break;
+        Entry entry;
+        entry.fTransmitted = (flags[0] != 0);
+        entry.fHits = flags[1];
+        entry.fPosition.set(values[0],values[1],values[2]);
+        entry.fDirection.set(values[3],values[4],values[5]);
+        entry.fLength = values[6];
+        fEntries.push_back(entry);
+    }
+    if(G4int(fEntries.size()) != entries){
+        fEntries.clear();
+        G4Exception("TransferLineKernel::Read",
+                    "eff0006",
+                    JustWarning,
+                    "Truncated transfer line kernel.");
+        return false;
+    }
+    return true;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+const TransferLineKernel::Entry& TransferLineKernel::Sample() const{
+    size_t index = size_t(G4UniformRand() * fEntries.size());
+    if(index >= fEntries.size()) index = fEntries.size() - 1;
+    return fEntries[index];
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+G4bool TransferLineKernel::IsEntering(const G4ThreeVector& localPoint,
+                                      const G4ThreeVector& localDirection) const{
+    const G4ThreeVector lowNorm = fSolid[0]->GetLowNorm();
+    G4ThreeVector center(0.,0.,-fSolid[0]->GetZHalfLength());
+    return std::fabs((localPoint - center).dot(lowNorm)) < fTolerance &&
+        localDirection.dot(lowNorm) < 0.;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+G4ThreeVector TransferLineKernel::GetGlobalPosition(const Entry& entry) const{
+    return fToGlobal[entry.fTransmitted ? 1 : 0].TransformPoint(entry.fPosition);
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+G4ThreeVector TransferLineKernel::GetGlobalDirection(const Entry& entry) const{
+    return fToGlobal[entry.fTransmitted ? 1 : 0].TransformAxis(entry.fDirection);
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+G4double TransferLineKernel::GetTransmission() const{
+    if(fEntries.empty()) return 0.;
+    G4double transmitted = 0.;
+    for(auto& entry : fEntries){
+        if(entry.fTransmitted) transmitted += 1.;
+    }
+    return transmitted / fEntries.size();
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
@@ -0,0 +1,123 @@
+//
+// ********************************************************************
+// * License and Disclaimer                                           *
+// *                                                                  *
+// * The  Geant4 software  is  copyright of the Copyright Holders  of *
+// * the Geant4 Collaboration.  It is provided  under  the terms  and *
+// * conditions of the Geant4 Software License,  included in the file *
+// * LICENSE and available at  http://cern.ch/geant4/license .  These *
+// * include a list of copyright holders.                             *
+// *                                                                  *
+// * Neither the authors of this software system, nor their employing *
+// * institutes,nor the agencies providing financial support for this *
+// * work  make  any representation or  warranty, express or implied, *
+// * regarding  this  software system or assume any liability for its *
+// * use.  Please see the license in the file  LICENSE  and URL above *
+// * for the full disclaimer and the limitation of liability.         *
+// *                                                                  *
+// * This  code  implementation is the result of  the  scientific and *
+// * technical work of the GEANT4 collaboration.                      *
+// * By using,  copying,  modifying or  distributing the software (or *
+// * any work based  on the software)  you  agree  to acknowledge its *
+// * use  in  resulting  scientific  publications,  and indicate your *
+// * acceptance of all terms of the Geant4 Software license.          *
+// ********************************************************************
+//
+//
+/// \file TransferLineModel.cc
+/// \brief Implementation of the TransferLineModel class
+
+#include "TransferLineModel.hh"
+#include "EffusionProcess.hh"
+#include "EffusionTrackData.hh"
+
+#include "G4FastTrack.hh"
+#include "G4FastStep.hh"
+#include "G4Track.hh"
+#include "G4PhysicsModelCatalog.hh"
+#include "G4SystemOfUnits.hh"
+
+#include <cmath>
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+TransferLineModel::TransferLineModel(const G4String& modelName,
+                                     G4Region* envelope,
+                                     const G4String& kernelFile):
+G4VFastSimulationModel(modelName,envelope),
+fKernelFile(kernelFile),
+bLoaded(false),
+bReady(false),
+fEffusionID(-1){}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+TransferLineModel::~TransferLineModel(){}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+G4bool TransferLineModel::IsApplicable(const G4ParticleDefinition& particle){
+    return particle.GetParticleType() == "nucleus";
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+G4bool TransferLineModel::ModelTrigger(const G4FastTrack& fastTrack){
+    if(!bLoaded){
+        bLoaded = true;
+        bReady = fKernel.Read(fKernelFile);
+        if(bReady){
+            G4cout << "--- TransferLineModel: " << fKernel.GetNumberOfEntries()
+            << " histories read from " << fKernelFile
+            << ", transmission " << fKernel.GetTransmission() << G4endl;
+        }
+    }
+    if(!bReady) return false;
+    
+    // Only the ions entering from the target box, the ones coming back
+    // from the detector side are tracked in detail
+    if(fastTrack.GetEnvelopePhysicalVolume() != fKernel.GetEntrance()) return false;
+    return fKernel.IsEntering(fastTrack.GetPrimaryTrackLocalPosition(),
+                              fastTrack.GetPrimaryTrackLocalDirection());
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void TransferLineModel::DoIt(const G4FastTrack& fastTrack,
+                             G4FastStep& fastStep){
+    const G4Track* track = fastTrack.GetPrimaryTrack();
+    const TransferLineKernel::Entry& entry = fKernel.Sample();
+    
+    G4double adsorptionTime = 0.;
+    EffusionProcess* effusion = EffusionProcess::GetEffusionProcess(track->GetDefinition());
+    if(effusion){
+        G4int partZ = G4int(std::round(track->GetDefinition()->GetPDGCharge()));
+        adsorptionTime = effusion->GetAdsorptionTime(partZ,fKernel.GetWallZ());
+    }
+    G4double elapsedTime = entry.fLength / track->GetVelocity() + entry.fHits * adsorptionTime;
+    
+    // The exit point is moved back inside the envelope by a tolerance
+    G4ThreeVector direction = fKernel.GetGlobalDirection(entry);
+    G4ThreeVector position = fKernel.GetGlobalPosition(entry) - 1.e-6 * CLHEP::mm * direction;
+    
+    fastStep.ProposePrimaryTrackFinalPosition(position,false);
+    fastStep.ProposePrimaryTrackFinalMomentumDirection(direction,false);
+    fastStep.ProposePrimaryTrackFinalTime(track->GetGlobalTime() + elapsedTime);
+    fastStep.ProposePrimaryTrackFinalProperTime(track->GetProperTime() + elapsedTime);
+    fastStep.ProposePrimaryTrackPathLength(entry.fLength);
+    
+    // The decay during the transit is applied by the biasing operator as
+    // for the time spent adsorbed on the surfaces
+    if(fEffusionID == -1){
+        fEffusionID = G4PhysicsModelCatalog::GetIndex("effusion");
+    }
+    EffusionTrackData* trackdata =
+    (EffusionTrackData*)(track->GetAuxiliaryTrackInformation(fEffusionID));
+    if(trackdata == nullptr){
+        trackdata = new EffusionTrackData();
+        track->SetAuxiliaryTrackInformation(fEffusionID,trackdata);
+    }
+    trackdata->SetTimeSticked(elapsedTime);
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
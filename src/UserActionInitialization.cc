@@ -30,6 +30,9 @@
 #include "RunAction.hh"
 #include "G4GeneralParticleSource.hh"
 #include "StackingAction.hh"
+#include "TrackingAction.hh"
+#include "SteppingAction.hh"
+#include "CompartmentModel.hh"
 
 //....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
 UserActionInitialization::UserActionInitialization() {}
@@ -44,6 +47,11 @@ void UserActionInitialization::Build() const {
     SetUserAction(new EventAction());
     SetUserAction(new RunAction());
     SetUserAction(new StackingAction());
+    SetUserAction(new TrackingAction());
+    // Only the calibration of the CompartmentModel needs the steps
+    if(CompartmentModel::IsCalibrating()){
+        SetUserAction(new SteppingAction());
+    }
 }
 
 //....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo....
@@ -0,0 +1,174 @@
+//
+// ********************************************************************
+// * License and Disclaimer                                           *
+// *                                                                  *
+// * The  Geant4 software  is  copyright of the Copyright Holders  of *
+// * the Geant4 Collaboration.  It is provided  under  the terms  and *
+// * conditions of the Geant4 Software License,  included in the file *
+// * LICENSE and available at  http://cern.ch/geant4/license .  These *
+// * include a list of copyright holders.                             *
+// *                                                                  *
+// * Neither the authors of this software system, nor their employing *
+// * institutes,nor the agencies providing financial support for this *
+// * work  make  any representation or  warranty, express or implied, *
+// * regarding  this  software system or assume any liability for its *
+// * use.  Please see the license in the file  LICENSE  and URL above *
+// * for the full disclaimer and the limitation of liability.         *
+// *                                                                  *
+// * This  code  implementation is the result of  the  scientific and *
+// * technical work of the GEANT4 collaboration.                      *
+// * By using,  copying,  modifying or  distributing the software (or *
+// * any work based  on the software)  you  agree  to acknowledge its *
+// * use  in  resulting  scientific  publications,  and indicate your *
+// * acceptance of all terms of the Geant4 Software license.          *
+// ********************************************************************
+//
+//
+/// \file VertexFile.cc
+/// \brief Implementation of the VertexFile class
+
+#include "VertexFile.hh"
+
+#include <fstream>
+#include <cstring>
+
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+namespace
+{
+    const char kMagic[8] = {'E','F','F','1','0','V','T','X'};
+    const int32_t kVersion = 1;
+    // 24 bytes, the records in the mapping stay aligned
+    const std::size_t kHeaderSize = 8 + 2 * sizeof(int32_t) + sizeof(int64_t);
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+VertexFile::VertexFile()
+: fMapping(nullptr),
+fSize(0),
+fRecords(nullptr),
+fEntries(0),
+fCode(-1){;}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+VertexFile::~VertexFile(){
+    Close();
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+G4bool VertexFile::Append(const G4String& fileName,G4int code,
+                          const std::vector<Record>& records,G4bool truncate){
+    std::fstream file;
+    if(!truncate){
+        file.open(fileName,std::fstream::in | std::fstream::out | std::fstream::binary);
+    }
+    if(!file.is_open()){
+        file.open(fileName,std::fstream::in | std::fstream::out | std::fstream::binary |
+                  std::fstream::trunc);
+        int32_t header[2] = {kVersion,code};
+        int64_t entries = 0;
+        file.write(kMagic,sizeof(kMagic));
+        file.write(reinterpret_cast<const char*>(header),sizeof(header));
+        file.write(reinterpret_cast<const char*>(&entries),sizeof(entries));
+    }
+    
+    char magic[8];
+    int32_t header[2];
+    int64_t entries = 0;
+    file.seekg(0);
+    file.read(magic,sizeof(magic));
+    file.read(reinterpret_cast<char*>(header),sizeof(header));
+    file.read(reinterpret_cast<char*>(&entries),sizeof(entries));
+    if(file.fail() || std::memcmp(magic,kMagic,sizeof(kMagic)) != 0 ||
+       header[0] != kVersion || header[1] != code){
+        G4Exception("VertexFile::Append",
+                    "eff0010",
+                    JustWarning,
+                    ("Cannot append to the vertex file " + fileName).c_str());
+        return false;
+    }
+    
+    // The records go to the end and the count in the header is updated
+    // last, an interrupted write leaves a shorter but valid file
+    file.seekp(kHeaderSize + entries * sizeof(Record));
+    file.write(reinterpret_cast<const char*>(records.data()),
+               records.size() * sizeof(Record));
+    entries += int64_t(records.size());
+    file.seekp(kHeaderSize - sizeof(entries));
+    file.write(reinterpret_cast<const char*>(&entries),sizeof(entries));
+    file.close();
+    return !file.fail();
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+G4bool VertexFile::Open(const G4String& fileName){
+    Close();
+    
+    int fd = open(fileName.c_str(),O_RDONLY);
+    struct stat status;
+    if(fd < 0 || fstat(fd,&status) != 0 || std::size_t(status.st_size) < kHeaderSize){
+        if(fd >= 0) close(fd);
+        G4Exception("VertexFile::Open",
+                    "eff0010",
+                    JustWarning,
+                    ("Cannot open the vertex file " + fileName).c_str());
+        return false;
+    }
+    
+    void* mapping = mmap(nullptr,status.st_size,PROT_READ,MAP_PRIVATE,fd,0);
+    close(fd);
+    if(mapping == MAP_FAILED){
+        G4Exception("VertexFile::Open",
+                    "eff0010",
+                    JustWarning,
+                    ("Cannot map the vertex file " + fileName).c_str());
+        return false;
+    }
+    fMapping = mapping;
+    fSize = status.st_size;
+    
+    const char* data = static_cast<const char*>(fMapping);
+    int32_t header[2];
+    int64_t entries;
+    std::memcpy(header,data + sizeof(kMagic),sizeof(header));
+    std::memcpy(&entries,data + sizeof(kMagic) + sizeof(header),sizeof(entries));
+    if(std::memcmp(data,kMagic,sizeof(kMagic)) != 0 || header[0] != kVersion ||
+       entries <= 0 || kHeaderSize + entries * sizeof(Record) > fSize){
+        Close();
+        G4Exception("VertexFile::Open",
+                    "eff0010",
+                    JustWarning,
+                    ("Empty or corrupted vertex file " + fileName).c_str());
+        return false;
+    }
+    
+    // The records are only sampled at random, the whole file is needed
+    madvise(fMapping,fSize,MADV_RANDOM);
+    
+    fCode = header[1];
+    fEntries = entries;
+    fRecords = reinterpret_cast<const Record*>(data + kHeaderSize);
+    return true;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void VertexFile::Close(){
+    if(fMapping){
+        munmap(fMapping,fSize);
+    }
+    fMapping = nullptr;
+    fSize = 0;
+    fRecords = nullptr;
+    fEntries = 0;
+    fCode = -1;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......